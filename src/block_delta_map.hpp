@@ -0,0 +1,227 @@
+/*
+ * block_delta_map.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_BLOCK_DELTA_MAP_HPP_
+#define SRC_BLOCK_DELTA_MAP_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+/**
+ * Location index which stores IDs and locations delta encoded in memory.
+ *
+ * Entries are grouped into blocks of block_size entries. Each block has a header with
+ * the ID and location of its first entry and the offset of its remaining entries in the
+ * data buffer. The remaining entries are stored as varint encoded differences to their
+ * predecessor (ID difference minus one, zigzag encoded differences of x and y).
+ *
+ * A lookup uses a binary search on the block headers and decodes at most one block.
+ *
+ * IDs should be added in ascending order (as they appear in sorted input files). Entries
+ * which are out of order are kept in an unencoded overflow list which is sorted by sort().
+ *
+ * This index is available as `sparse_delta_mem_array` in the MapFactory.
+ */
+template <typename TId, typename TValue>
+class BlockDeltaMap : public osmium::index::map::Map<TId, TValue> {
+
+    static_assert(std::is_same<TValue, osmium::Location>::value, "BlockDeltaMap can only store locations");
+
+public:
+    /// number of entries per block
+    static constexpr size_t block_size = 128;
+
+private:
+    struct BlockHeader {
+        /// offset of the second entry of the block in m_data
+        uint64_t offset;
+        /// ID of the first entry
+        TId first_id;
+        /// location of the first entry
+        int32_t x;
+        int32_t y;
+        /// number of entries in the block
+        uint32_t count;
+    };
+
+    std::vector<BlockHeader> m_blocks;
+
+    /// encoded entries (except the first entry of each block)
+    std::vector<unsigned char> m_data;
+
+    /// entries which were added with an ID smaller than their predecessor
+    std::vector<std::pair<TId, osmium::Location>> m_overflow;
+
+    /// number of entries in the blocks
+    size_t m_size = 0;
+
+    /// true if new entries have been added to m_overflow since the last call of sort()
+    bool m_overflow_unsorted = false;
+
+    /// ID and location of the last entry added to the blocks
+    TId m_last_id = 0;
+    int32_t m_last_x = 0;
+    int32_t m_last_y = 0;
+
+    void append_varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_data.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        m_data.push_back(static_cast<unsigned char>(value));
+    }
+
+    static uint64_t decode_varint(const unsigned char*& ptr) noexcept {
+        uint64_t value = 0;
+        unsigned int shift = 0;
+        while (*ptr & 0x80) {
+            value |= static_cast<uint64_t>(*ptr & 0x7f) << shift;
+            shift += 7;
+            ++ptr;
+        }
+        value |= static_cast<uint64_t>(*ptr) << shift;
+        ++ptr;
+        return value;
+    }
+
+    static uint64_t zigzag(const int64_t value) noexcept {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static int64_t unzigzag(const uint64_t value) noexcept {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    osmium::Location get_from_blocks(const TId id) const noexcept {
+        // find the last block whose first ID is not larger than the ID we are looking for
+        auto block_it = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), id,
+                [](const TId search_id, const BlockHeader& block) {
+                    return search_id < block.first_id;
+                });
+        if (block_it == m_blocks.cbegin()) {
+            return osmium::Location{};
+        }
+        --block_it;
+        TId current_id = block_it->first_id;
+        int64_t x = block_it->x;
+        int64_t y = block_it->y;
+        const unsigned char* ptr = m_data.data() + block_it->offset;
+        for (uint32_t i = 1; i < block_it->count && current_id < id; ++i) {
+            current_id += static_cast<TId>(decode_varint(ptr) + 1);
+            x += unzigzag(decode_varint(ptr));
+            y += unzigzag(decode_varint(ptr));
+        }
+        if (current_id != id) {
+            return osmium::Location{};
+        }
+        return osmium::Location{static_cast<int32_t>(x), static_cast<int32_t>(y)};
+    }
+
+    osmium::Location get_from_overflow(const TId id) const noexcept {
+        if (m_overflow_unsorted) {
+            const auto it = std::find_if(m_overflow.cbegin(), m_overflow.cend(),
+                    [id](const std::pair<TId, osmium::Location>& entry) {
+                        return entry.first == id;
+                    });
+            return it == m_overflow.cend() ? osmium::Location{} : it->second;
+        }
+        const auto it = std::lower_bound(m_overflow.cbegin(), m_overflow.cend(), id,
+                [](const std::pair<TId, osmium::Location>& entry, const TId search_id) {
+                    return entry.first < search_id;
+                });
+        if (it == m_overflow.cend() || it->first != id) {
+            return osmium::Location{};
+        }
+        return it->second;
+    }
+
+public:
+    BlockDeltaMap() = default;
+
+    ~BlockDeltaMap() noexcept final = default;
+
+    void set(const TId id, const TValue value) final {
+        if (m_size > 0 && id <= m_last_id) {
+            m_overflow.emplace_back(id, value);
+            m_overflow_unsorted = true;
+            return;
+        }
+        if (m_size % block_size == 0) {
+            m_blocks.push_back(BlockHeader{m_data.size(), id, value.x(), value.y(), 1});
+        } else {
+            append_varint(static_cast<uint64_t>(id - m_last_id - 1));
+            append_varint(zigzag(static_cast<int64_t>(value.x()) - m_last_x));
+            append_varint(zigzag(static_cast<int64_t>(value.y()) - m_last_y));
+            ++m_blocks.back().count;
+        }
+        m_last_id = id;
+        m_last_x = value.x();
+        m_last_y = value.y();
+        ++m_size;
+    }
+
+    TValue get(const TId id) const final {
+        const osmium::Location location = get_noexcept(id);
+        if (!location) {
+            throw osmium::not_found{id};
+        }
+        return location;
+    }
+
+    TValue get_noexcept(const TId id) const noexcept final {
+        const osmium::Location location = get_from_blocks(id);
+        if (location || m_overflow.empty()) {
+            return location;
+        }
+        return get_from_overflow(id);
+    }
+
+    size_t size() const final {
+        return m_size + m_overflow.size();
+    }
+
+    size_t used_memory() const final {
+        return sizeof(BlockHeader) * m_blocks.capacity() + m_data.capacity()
+            + sizeof(std::pair<TId, osmium::Location>) * m_overflow.capacity();
+    }
+
+    void clear() final {
+        m_blocks.clear();
+        m_blocks.shrink_to_fit();
+        m_data.clear();
+        m_data.shrink_to_fit();
+        m_overflow.clear();
+        m_overflow.shrink_to_fit();
+        m_size = 0;
+        m_overflow_unsorted = false;
+        m_last_id = 0;
+        m_last_x = 0;
+        m_last_y = 0;
+    }
+
+    void sort() final {
+        if (m_overflow_unsorted) {
+            std::stable_sort(m_overflow.begin(), m_overflow.end(),
+                    [](const std::pair<TId, osmium::Location>& lhs, const std::pair<TId, osmium::Location>& rhs) {
+                        return lhs.first < rhs.first;
+                    });
+            m_overflow_unsorted = false;
+        }
+    }
+};
+
+REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, BlockDeltaMap, sparse_delta_mem_array)
+
+#endif /* SRC_BLOCK_DELTA_MAP_HPP_ */
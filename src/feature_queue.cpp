@@ -0,0 +1,75 @@
+/*
+ * feature_queue.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "feature_queue.hpp"
+
+FeatureQueue::FeatureQueue(write_func_type write_func) :
+    m_write(std::move(write_func)) {
+    m_thread = std::thread(&FeatureQueue::run, this);
+}
+
+FeatureQueue::~FeatureQueue() {
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_done = true;
+    }
+    m_not_empty.notify_all();
+    m_thread.join();
+}
+
+void FeatureQueue::push(std::unique_ptr<FeatureRecord>&& record) {
+    std::unique_lock<std::mutex> lock {m_mutex};
+    m_not_full.wait(lock, [this]() {
+        return m_queue.size() < max_queue_size;
+    });
+    m_queue.push_back(std::move(record));
+    m_not_empty.notify_one();
+}
+
+void FeatureQueue::run() {
+    while (true) {
+        std::unique_ptr<FeatureRecord> record;
+        {
+            std::unique_lock<std::mutex> lock {m_mutex};
+            m_not_empty.wait(lock, [this]() {
+                return m_done || !m_queue.empty();
+            });
+            if (m_queue.empty()) {
+                return;
+            }
+            record = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_writing = true;
+            m_not_full.notify_one();
+        }
+        try {
+            m_write(*record);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_writing = false;
+        if (m_queue.empty()) {
+            m_empty.notify_all();
+        }
+    }
+}
+
+void FeatureQueue::flush() {
+    std::unique_lock<std::mutex> lock {m_mutex};
+    m_empty.wait(lock, [this]() {
+        return m_queue.empty() && !m_writing;
+    });
+    if (m_exception) {
+        std::exception_ptr exception = m_exception;
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * feature_queue.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_FEATURE_QUEUE_HPP_
+#define SRC_FEATURE_QUEUE_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "feature_record.hpp"
+
+/**
+ * Bounded queue of features which are written by a separate thread.
+ */
+class FeatureQueue {
+public:
+    /// function writing a feature
+    using write_func_type = std::function<void(FeatureRecord&)>;
+
+private:
+    write_func_type m_write;
+
+    std::deque<std::unique_ptr<FeatureRecord>> m_queue;
+
+    /// protects m_queue, m_writing, m_done and m_exception
+    std::mutex m_mutex;
+
+    std::condition_variable m_not_empty;
+
+    std::condition_variable m_not_full;
+
+    /// notified if the writer thread has written all queued features
+    std::condition_variable m_empty;
+
+    /// true while the writer thread writes a feature it has taken from the queue
+    bool m_writing = false;
+
+    /// set to true to stop the writer thread
+    bool m_done = false;
+
+    /// exception thrown by the writer thread, rethrown by flush()
+    std::exception_ptr m_exception;
+
+    std::thread m_thread;
+
+    /// maximum number of features in the queue
+    static constexpr size_t max_queue_size = 64 * 1024;
+
+    /**
+     * Main loop of the writer thread.
+     */
+    void run();
+
+public:
+    FeatureQueue() = delete;
+
+    FeatureQueue(const FeatureQueue&) = delete;
+
+    FeatureQueue& operator=(const FeatureQueue&) = delete;
+
+    explicit FeatureQueue(write_func_type write_func);
+
+    /**
+     * Stop the writer thread after it has written all queued features.
+     */
+    ~FeatureQueue();
+
+    /**
+     * Add a feature to the queue. This method blocks if the queue is full.
+     */
+    void push(std::unique_ptr<FeatureRecord>&& record);
+
+    /**
+     * Wait until all queued features have been written.
+     *
+     * Exceptions thrown by the writer thread are rethrown.
+     */
+    void flush();
+};
+
+#endif /* SRC_FEATURE_QUEUE_HPP_ */
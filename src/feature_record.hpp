@@ -0,0 +1,87 @@
+/*
+ * feature_record.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_FEATURE_RECORD_HPP_
+#define SRC_FEATURE_RECORD_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A feature which has not been written to its layer yet (used if features are queued,
+ * spooled or written by the native SpatiaLite writer).
+ *
+ * The geometry is stored as little-endian WKB. The values of all string fields are stored
+ * in one buffer to avoid an allocation per field.
+ */
+struct FeatureRecord {
+
+    enum class FieldType : char {
+        STRING,
+        INTEGER,
+        /// seconds since the epoch
+        TIMESTAMP
+    };
+
+    struct Field {
+        /// index of the field in its layer
+        int index;
+
+        FieldType type;
+
+        /// length of a string value
+        uint32_t length;
+
+        /// offset of a string value in FeatureRecord::strings, value of other fields
+        int64_t value;
+    };
+
+    /// ID of the layer in the OGRWriter
+    size_t layer_id;
+
+    /// geometry as little-endian WKB
+    std::string wkb;
+
+    /// fields which have been set
+    std::vector<Field> fields;
+
+    /// values of all string fields, each one is followed by a null byte
+    std::string strings;
+
+    FeatureRecord(size_t layer, std::string&& wkb_geom) :
+        layer_id(layer),
+        wkb(std::move(wkb_geom)),
+        fields(),
+        strings() {
+    }
+
+    void add_string(int index, const char* value) {
+        const size_t length = std::strlen(value);
+        fields.push_back(Field{index, FieldType::STRING, static_cast<uint32_t>(length), static_cast<int64_t>(strings.size())});
+        strings.append(value, length + 1);
+    }
+
+    void add_integer(int index, int64_t value) {
+        fields.push_back(Field{index, FieldType::INTEGER, 0, value});
+    }
+
+    void add_timestamp(int index, int64_t seconds) {
+        fields.push_back(Field{index, FieldType::TIMESTAMP, 0, seconds});
+    }
+
+    /**
+     * Get the null-terminated value of a string field.
+     */
+    const char* string_value(const Field& field) const noexcept {
+        return strings.data() + field.value;
+    }
+};
+
+#endif /* SRC_FEATURE_RECORD_HPP_ */
@@ -0,0 +1,181 @@
+/*
+ * feature_spool.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "feature_spool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+    /// WKB geometry types
+    constexpr uint32_t geometry_point = 1;
+    constexpr uint32_t geometry_linestring = 2;
+    constexpr uint32_t geometry_multilinestring = 5;
+
+    /**
+     * Read a value from a buffer and advance the pointer.
+     */
+    template <typename T>
+    T read(const char*& ptr) noexcept {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+
+} // namespace
+
+FeatureSpool::FeatureSpool(const std::string& filename, const HilbertCurve& curve) :
+    m_filename(filename),
+    m_curve(curve) {
+    m_file = fopen(m_filename.c_str(), "w+b");
+    if (!m_file) {
+        throw std::system_error{errno, std::system_category(), "Could not open " + m_filename};
+    }
+    ::unlink(m_filename.c_str());
+}
+
+FeatureSpool::~FeatureSpool() {
+    if (m_file) {
+        fclose(m_file);
+    }
+}
+
+void FeatureSpool::append_string(const std::string& value) {
+    append(static_cast<uint32_t>(value.size()));
+    m_buffer.append(value);
+}
+
+/*static*/ bool FeatureSpool::wkb_centre(const std::string& wkb, double& x, double& y) {
+    // byte order, type and the count of points or linestrings
+    if (wkb.size() < 9 || wkb[0] != 0x01) {
+        return false;
+    }
+    const char* ptr = wkb.data() + 1;
+    const char* end = wkb.data() + wkb.size();
+    const uint32_t type = read<uint32_t>(ptr);
+    if (type == geometry_point) {
+        if (end - ptr < static_cast<std::ptrdiff_t>(2 * sizeof(double))) {
+            return false;
+        }
+        x = read<double>(ptr);
+        y = read<double>(ptr);
+        return true;
+    }
+    uint32_t linestrings = 1;
+    if (type == geometry_multilinestring) {
+        linestrings = read<uint32_t>(ptr);
+    } else if (type != geometry_linestring) {
+        return false;
+    }
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+    for (uint32_t i = 0; i < linestrings; ++i) {
+        if (type == geometry_multilinestring) {
+            // skip byte order and type of the linestring
+            if (end - ptr < 5) {
+                return false;
+            }
+            ptr += 5;
+        }
+        if (end - ptr < static_cast<std::ptrdiff_t>(sizeof(uint32_t))) {
+            return false;
+        }
+        const uint32_t points = read<uint32_t>(ptr);
+        if (static_cast<uint64_t>(end - ptr) < static_cast<uint64_t>(points) * 2 * sizeof(double)) {
+            return false;
+        }
+        for (uint32_t j = 0; j < points; ++j) {
+            const double px = read<double>(ptr);
+            const double py = read<double>(ptr);
+            min_x = std::min(min_x, px);
+            min_y = std::min(min_y, py);
+            max_x = std::max(max_x, px);
+            max_y = std::max(max_y, py);
+        }
+    }
+    if (min_x > max_x) {
+        return false;
+    }
+    x = (min_x + max_x) / 2;
+    y = (min_y + max_y) / 2;
+    return true;
+}
+
+void FeatureSpool::add(const FeatureRecord& record) {
+    double x;
+    double y;
+    const uint64_t hilbert_index = wkb_centre(record.wkb, x, y) ? m_curve.index(x, y) : 0;
+    m_buffer.clear();
+    append_string(record.wkb);
+    append(static_cast<uint32_t>(record.fields.size()));
+    for (const FeatureRecord::Field& field : record.fields) {
+        append(static_cast<int32_t>(field.index));
+        append(field.type);
+        append(field.length);
+        append(field.value);
+    }
+    append_string(record.strings);
+    if (fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+        throw std::system_error{errno, std::system_category(), "Writing to " + m_filename + " failed"};
+    }
+    m_index.emplace_back(hilbert_index, m_size);
+    m_size += m_buffer.size();
+}
+
+void FeatureSpool::replay(size_t layer_id, const write_func_type& write_func) {
+    if (fflush(m_file)) {
+        throw std::system_error{errno, std::system_category(), "Writing to " + m_filename + " failed"};
+    }
+    std::stable_sort(m_index.begin(), m_index.end(),
+            [](const std::pair<uint64_t, uint64_t>& lhs, const std::pair<uint64_t, uint64_t>& rhs) {
+                return lhs.first < rhs.first;
+            });
+    if (m_size > 0) {
+        void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fileno(m_file), 0);
+        if (mapping == MAP_FAILED) {
+            throw std::system_error{errno, std::system_category(), "Could not map " + m_filename};
+        }
+        const char* data = static_cast<const char*>(mapping);
+        try {
+            for (const auto& entry : m_index) {
+                const char* ptr = data + entry.second;
+                const uint32_t wkb_size = read<uint32_t>(ptr);
+                std::unique_ptr<FeatureRecord> record {new FeatureRecord(layer_id, std::string(ptr, wkb_size))};
+                ptr += wkb_size;
+                const uint32_t field_count = read<uint32_t>(ptr);
+                record->fields.reserve(field_count);
+                for (uint32_t i = 0; i < field_count; ++i) {
+                    const int32_t index = read<int32_t>(ptr);
+                    const FeatureRecord::FieldType type = read<FeatureRecord::FieldType>(ptr);
+                    const uint32_t length = read<uint32_t>(ptr);
+                    record->fields.push_back(FeatureRecord::Field{index, type, length, read<int64_t>(ptr)});
+                }
+                const uint32_t strings_size = read<uint32_t>(ptr);
+                record->strings.assign(ptr, strings_size);
+                write_func(std::move(record));
+            }
+        } catch (...) {
+            ::munmap(mapping, m_size);
+            throw;
+        }
+        ::munmap(mapping, m_size);
+    }
+    m_index.clear();
+    m_index.shrink_to_fit();
+    fclose(m_file);
+    m_file = nullptr;
+}
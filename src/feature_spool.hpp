@@ -0,0 +1,94 @@
+/*
+ * feature_spool.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_FEATURE_SPOOL_HPP_
+#define SRC_FEATURE_SPOOL_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "feature_queue.hpp"
+#include "hilbert_curve.hpp"
+
+/**
+ * Temporary file which buffers the features of a layer in order to write them sorted by
+ * the Hilbert index of the centre of their bounding box.
+ *
+ * Geometries are stored as little-endian WKB. OGR geometries are converted when they are added.
+ * The file is removed from the file system when it is created and is deleted by the operating
+ * system when it is closed. Only the Hilbert index and offset of each feature are kept in memory.
+ */
+class FeatureSpool {
+
+    /// name of the spool file (already removed from the file system)
+    std::string m_filename;
+
+    FILE* m_file = nullptr;
+
+    const HilbertCurve& m_curve;
+
+    /// Hilbert index and offset in the file of all features
+    std::vector<std::pair<uint64_t, uint64_t>> m_index;
+
+    /// size of the file
+    uint64_t m_size = 0;
+
+    /// serialization buffer of the current feature
+    std::string m_buffer;
+
+    template <typename T>
+    void append(const T value) {
+        m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void append_string(const std::string& value);
+
+public:
+    using write_func_type = std::function<void(std::unique_ptr<FeatureRecord>&&)>;
+
+    FeatureSpool() = delete;
+
+    FeatureSpool(const FeatureSpool&) = delete;
+
+    FeatureSpool& operator=(const FeatureSpool&) = delete;
+
+    /**
+     * \param filename name of the temporary file
+     * \param curve Hilbert curve covering the extent of all features
+     *
+     * \throws std::system_error if the file cannot be created
+     */
+    FeatureSpool(const std::string& filename, const HilbertCurve& curve);
+
+    ~FeatureSpool();
+
+    /**
+     * Centre of the bounding box of a little-endian WKB geometry (points, linestrings and
+     * multilinestrings).
+     *
+     * \returns false if the geometry is empty, truncated or not supported
+     */
+    static bool wkb_centre(const std::string& wkb, double& x, double& y);
+
+    /**
+     * Add a feature to the spool.
+     */
+    void add(const FeatureRecord& record);
+
+    /**
+     * Pass all features to a function sorted by their Hilbert index. Features with the same
+     * index keep their order. The spool cannot be used afterwards.
+     */
+    void replay(size_t layer_id, const write_func_type& write_func);
+};
+
+#endif /* SRC_FEATURE_SPOOL_HPP_ */
@@ -0,0 +1,93 @@
+/*
+ * filtered_location_handler.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_FILTERED_LOCATION_HANDLER_HPP_
+#define SRC_FILTERED_LOCATION_HANDLER_HPP_
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+
+#include "huge_pages.hpp"
+#include "location_store.hpp"
+#include "way_geometry_filter.hpp"
+
+/**
+ * Location handler which adds node locations only to the ways whose geometry will be built.
+ *
+ * Node locations are stored for all nodes. Looking up the locations of the nodes of a way
+ * is skipped if the filter rejects the way. The node locations of these ways stay undefined.
+ * If no filter is set, this handler behaves like osmium::handler::NodeLocationsForWays.
+ *
+ * Node locations can be written to a location store in addition. If the locations are
+ * read from a location store, storing node locations can be skipped.
+ */
+template <typename TStoragePosIDs>
+class FilteredNodeLocationsForWays : public osmium::handler::NodeLocationsForWays<TStoragePosIDs> {
+
+    using base_type = osmium::handler::NodeLocationsForWays<TStoragePosIDs>;
+
+    /// filter to apply, nullptr means that all ways get their locations
+    const WayGeometryFilter* m_filter;
+
+    /// location store to write all node locations to, nullptr if none
+    LocationStoreWriter* m_store_writer = nullptr;
+
+    /// Don't add node locations to the index because it is populated already.
+    bool m_skip_nodes = false;
+
+    /// advisor to notify about new entries in the index, nullptr if huge pages are not used
+    HugePageAdvisor* m_huge_pages = nullptr;
+
+public:
+    FilteredNodeLocationsForWays() = delete;
+
+    FilteredNodeLocationsForWays(TStoragePosIDs& storage_pos, const WayGeometryFilter* filter) :
+        base_type(storage_pos),
+        m_filter(filter) {
+    }
+
+    /**
+     * Don't store node locations in the index. Use this method if the index has been
+     * populated already (e.g. it is a location store).
+     */
+    void skip_nodes() {
+        m_skip_nodes = true;
+    }
+
+    /**
+     * Write the locations of all nodes to a location store in addition.
+     */
+    void store_locations_to(LocationStoreWriter* store_writer) {
+        m_store_writer = store_writer;
+    }
+
+    /**
+     * Keep the memory of the index backed by huge pages while it grows.
+     */
+    void advise_huge_pages(HugePageAdvisor* advisor) {
+        m_huge_pages = advisor;
+    }
+
+    void node(const osmium::Node& node) {
+        if (m_store_writer) {
+            m_store_writer->add(node);
+        }
+        if (!m_skip_nodes) {
+            base_type::node(node);
+            if (m_huge_pages) {
+                m_huge_pages->check();
+            }
+        }
+    }
+
+    void way(osmium::Way& way) {
+        if (!m_filter || (*m_filter)(way)) {
+            base_type::way(way);
+        }
+    }
+};
+
+#endif /* SRC_FILTERED_LOCATION_HANDLER_HPP_ */
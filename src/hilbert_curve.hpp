@@ -0,0 +1,80 @@
+/*
+ * hilbert_curve.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_HILBERT_CURVE_HPP_
+#define SRC_HILBERT_CURVE_HPP_
+
+#include <cstdint>
+#include <utility>
+
+/**
+ * Map coordinates inside an extent to their position on a Hilbert curve of order 16
+ * covering the extent.
+ *
+ * Sorting by the position on the curve keeps spatially close features close to each other.
+ */
+class HilbertCurve {
+
+    /// number of cells of the grid in each direction
+    static constexpr uint32_t grid_size = 1u << 16;
+
+    double m_min_x;
+    double m_min_y;
+    double m_scale_x;
+    double m_scale_y;
+
+    static uint32_t to_cell(const double value, const double min, const double scale) noexcept {
+        const double cell = (value - min) * scale;
+        // NaN fails every comparison, clamp before the cast to avoid undefined behaviour
+        if (!(cell > 0)) {
+            return 0;
+        }
+        if (cell >= grid_size - 1) {
+            return grid_size - 1;
+        }
+        return static_cast<uint32_t>(cell);
+    }
+
+public:
+    HilbertCurve(const double min_x, const double min_y, const double max_x, const double max_y) noexcept :
+        m_min_x(min_x),
+        m_min_y(min_y),
+        m_scale_x(max_x > min_x ? grid_size / (max_x - min_x) : 0),
+        m_scale_y(max_y > min_y ? grid_size / (max_y - min_y) : 0) {
+    }
+
+    /**
+     * Position of a cell on the curve.
+     */
+    static uint64_t index(uint32_t x, uint32_t y) noexcept {
+        uint64_t d = 0;
+        for (uint32_t s = grid_size / 2; s > 0; s /= 2) {
+            const uint32_t rx = (x & s) > 0;
+            const uint32_t ry = (y & s) > 0;
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // rotate the quadrant
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = grid_size - 1 - x;
+                    y = grid_size - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    /**
+     * Position of a point on the curve. Points outside the extent are moved to its border,
+     * points with non-finite coordinates to the lower border.
+     */
+    uint64_t index(const double x, const double y) const noexcept {
+        return index(to_cell(x, m_min_x, m_scale_x), to_cell(y, m_min_y, m_scale_y));
+    }
+};
+
+#endif /* SRC_HILBERT_CURVE_HPP_ */
@@ -0,0 +1,177 @@
+/*
+ * huge_pages.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "huge_pages.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+
+namespace {
+
+    /// size of a huge page on x86_64 and aarch64 (with 4 KiB base pages)
+    constexpr uintptr_t huge_page_size = 2 * 1024 * 1024;
+
+    uintptr_t page_size() {
+        static const uintptr_t size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    uintptr_t round_down(const uintptr_t value, const uintptr_t alignment) {
+        return value / alignment * alignment;
+    }
+
+    uintptr_t round_up(const uintptr_t value, const uintptr_t alignment) {
+        return round_down(value + alignment - 1, alignment);
+    }
+
+    /// address of the element an iterator of the mmap arrays points to (valid for empty arrays, too)
+    template <typename T>
+    const char* address(const T* iterator, const size_t /*size*/) {
+        return reinterpret_cast<const char*>(iterator);
+    }
+
+    /**
+     * Address of the element an iterator of a std::vector points to, nullptr if the vector
+     * is empty because its iterators must not be dereferenced then. The memory reserved by an
+     * empty vector is advised by a later call of HugePageAdvisor::check().
+     */
+    template <typename TIterator>
+    const char* address(const TIterator& iterator, const size_t size) {
+        return size == 0 ? nullptr : reinterpret_cast<const char*>(&*iterator);
+    }
+
+    template <typename TMap, typename TIndex, typename TMemory>
+    bool vector_memory(const TIndex& index, const bool mapped, TMemory& memory) {
+        const TMap* map = dynamic_cast<const TMap*>(&index);
+        if (!map) {
+            return false;
+        }
+        memory.data = address(map->cbegin(), map->size());
+        memory.size = map->size();
+        memory.entry_size = sizeof(*map->cbegin());
+        memory.mapped = mapped;
+        return true;
+    }
+
+    /**
+     * Find the mapping containing an address in /proc/self/maps.
+     */
+    bool find_mapping(const uintptr_t address, uintptr_t& begin, uintptr_t& end) {
+        std::ifstream maps{"/proc/self/maps"};
+        std::string line;
+        while (std::getline(maps, line)) {
+            unsigned long first;
+            unsigned long last;
+            if (std::sscanf(line.c_str(), "%lx-%lx", &first, &last) == 2 && address >= first && address < last) {
+                begin = first;
+                end = last;
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace
+
+HugePageAdvisor::HugePageAdvisor(index_type& index, const size_t expected_size) :
+    m_index(index) {
+    IndexMemory memory;
+    if (!index_memory(memory)) {
+        std::cerr << "WARNING: Huge pages are not supported by this type of location index.\n";
+        m_enabled = false;
+        return;
+    }
+    if (memory.mapped) {
+        advise_mapping(index, expected_size, memory);
+        return;
+    }
+    // The reservation of a std::vector is not touched before the entries are added. The
+    // advice is given as soon as the vector is not empty any more.
+    if (expected_size > 0) {
+        index.reserve(expected_size);
+        m_reserved = expected_size;
+    }
+}
+
+bool HugePageAdvisor::index_memory(IndexMemory& memory) const {
+    using id_type = osmium::unsigned_object_id_type;
+    using value_type = osmium::Location;
+#ifdef __linux__
+    if (vector_memory<osmium::index::map::DenseMmapArray<id_type, value_type>>(m_index, true, memory)) {
+        return true;
+    }
+#endif
+    return vector_memory<osmium::index::map::SparseMmapArray<id_type, value_type>>(m_index, true, memory)
+        || vector_memory<osmium::index::map::DenseMemArray<id_type, value_type>>(m_index, false, memory)
+        || vector_memory<osmium::index::map::SparseMemArray<id_type, value_type>>(m_index, false, memory);
+}
+
+void HugePageAdvisor::advise_mapping(index_type& index, const size_t expected_size, IndexMemory& memory) {
+    const uintptr_t data = reinterpret_cast<uintptr_t>(memory.data);
+    uintptr_t mapping_begin;
+    uintptr_t mapping_end;
+    if (!find_mapping(data, mapping_begin, mapping_end)) {
+        return;
+    }
+    // The capacity of the array is not known but its mapping cannot be larger than the VMA
+    // containing it. Reserving more entries makes the size of the mapping known.
+    m_reserved = std::max<size_t>(expected_size, (mapping_end - data) / memory.entry_size + 1);
+    index.reserve(m_reserved);
+    index_memory(memory);
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(memory.data);
+    // The kernel maps whole pages, the last page belongs to the mapping completely.
+    advise_range(begin, round_up(begin + m_reserved * memory.entry_size, page_size()));
+}
+
+void HugePageAdvisor::advise() {
+    IndexMemory memory;
+    index_memory(memory);
+    if (memory.mapped || !memory.data) {
+        // The kernel keeps the advice of the mapping of the mmap arrays if they grow.
+        return;
+    }
+    const size_t entries = memory.size > m_reserved ? memory.size : m_reserved;
+    const uintptr_t data = reinterpret_cast<uintptr_t>(memory.data);
+    // Only pages which belong to the vector completely are advised.
+    const uintptr_t begin = round_up(data, page_size());
+    const uintptr_t end = round_down(data + entries * memory.entry_size, page_size());
+    if (begin >= m_advised_begin && end <= m_advised_end) {
+        return;
+    }
+    if (end < begin + huge_page_size) {
+        // too small, wait until it has grown
+        return;
+    }
+    advise_range(begin, end);
+}
+
+void HugePageAdvisor::advise_range(const uintptr_t begin, const uintptr_t end) {
+    m_advised_begin = begin;
+    m_advised_end = end;
+    if (::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE)) {
+        std::cerr << "WARNING: Transparent huge pages are not available (" << std::strerror(errno)
+                << "). Using normal pages.\n";
+        m_enabled = false;
+    }
+}
+
+bool HugePageAdvisor::enabled() const noexcept {
+    return m_enabled;
+}
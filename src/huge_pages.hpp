@@ -0,0 +1,124 @@
+/*
+ * huge_pages.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_HUGE_PAGES_HPP_
+#define SRC_HUGE_PAGES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <osmium/index/map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+/**
+ * Ask the kernel to back the memory of a location index with transparent huge pages
+ * (`madvise(MADV_HUGEPAGE)`). This reduces TLB misses caused by random lookups.
+ *
+ * The advice is limited to the memory owned by the index. Other mappings which the
+ * kernel merged with the memory of the index into a single VMA are not touched.
+ *
+ * The mmap based arrays have their own mapping. The advice has to cover this mapping
+ * completely because advising a part of it splits it and mremap() fails when the array
+ * grows. Its size is only known after reserving more entries than the VMA containing the
+ * array can hold. Afterwards the kernel keeps the advice if the mapping grows or moves
+ * by mremap(), therefore pages which are touched later are huge pages already when
+ * the fault occurs. Only the initial capacity of these arrays is filled before the advice
+ * and depends on khugepaged collapsing it.
+ *
+ * The mem arrays are std::vectors. The advice covers the entries in use and the
+ * reservation of the expected number of entries as long as the vector has not grown
+ * beyond it. Empty vectors and memory reallocated while the vector grows are advised by
+ * check(), memory touched up to then becomes huge pages only when khugepaged collapses it.
+ *
+ * Only the vector based indexes of libosmium (dense/sparse_mem_array and
+ * dense/sparse_mmap_array) are supported. Other indexes are left untouched.
+ * If the kernel does not support transparent huge pages, a warning is printed and
+ * the index is used with normal pages.
+ */
+class HugePageAdvisor {
+
+    using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+    /**
+     * Memory used by the entries of the index.
+     */
+    struct IndexMemory {
+        /// first entry, nullptr for empty std::vectors
+        const char* data = nullptr;
+
+        /// number of entries in use
+        size_t size = 0;
+
+        /// size of an entry
+        size_t entry_size = 0;
+
+        /// Does the index have its own mapping (mmap arrays)?
+        bool mapped = false;
+    };
+
+    const index_type& m_index;
+
+    /// beginning of the memory advised last
+    uintptr_t m_advised_begin = 0;
+
+    /// end of the memory advised last
+    uintptr_t m_advised_end = 0;
+
+    /// number of entries reserved by the advisor
+    size_t m_reserved = 0;
+
+    /// number of calls of check() since the last look at the index
+    uint32_t m_calls = 0;
+
+    /// false if the index is not supported or madvise() failed
+    bool m_enabled = true;
+
+    /**
+     * Get the memory used by the index.
+     *
+     * \returns false if the type of the index is not supported
+     */
+    bool index_memory(IndexMemory& memory) const;
+
+    /**
+     * Advise the complete mapping of an mmap array.
+     */
+    void advise_mapping(index_type& index, size_t expected_size, IndexMemory& memory);
+
+    void advise();
+
+    void advise_range(uintptr_t begin, uintptr_t end);
+
+public:
+    HugePageAdvisor() = delete;
+
+    /**
+     * \param index location index, no nodes must have been added yet
+     * \param expected_size expected number of entries of the index, reserved before the
+     * advice is given, 0 if unknown
+     */
+    HugePageAdvisor(index_type& index, const size_t expected_size);
+
+    /**
+     * Renew the advice if the memory of the index has grown beyond the memory advised last.
+     * This method is cheap because it looks at the index only every few thousand calls.
+     */
+    void check() {
+        if (m_enabled && ++m_calls == 64 * 1024) {
+            m_calls = 0;
+            advise();
+        }
+    }
+
+    /**
+     * Has huge page support been requested successfully?
+     */
+    bool enabled() const noexcept;
+};
+
+#endif /* SRC_HUGE_PAGES_HPP_ */
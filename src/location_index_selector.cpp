@@ -0,0 +1,237 @@
+/*
+ * location_index_selector.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "location_index_selector.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/handler.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/visitor.hpp>
+
+namespace {
+
+    /// average size of a PBF file per node (ratio of the planet file)
+    constexpr uint64_t pbf_bytes_per_node = 9;
+
+    /// largest node ID assumed if the input file cannot be sampled (a bit larger than the planet's largest ID in 2026)
+    constexpr uint64_t default_max_node_id = 14000000000;
+
+    /// estimated size of an entry of sparse_delta_mem_array
+    constexpr uint64_t delta_bytes_per_node = 6;
+
+    /// size of an entry of dense arrays
+    constexpr uint64_t dense_bytes_per_id = 8;
+
+    /// size of an entry of sparse arrays
+    constexpr uint64_t sparse_bytes_per_node = 16;
+
+    /// std::vector based indexes need up to twice their size while they grow
+    constexpr uint64_t vector_growth_factor = 2;
+
+    /**
+     * A dense array is only used if it is at most this many times larger than a sparse
+     * array. libosmium fills dense arrays with empty locations, a small extract with large
+     * node IDs would use a lot of memory for nothing.
+     */
+    constexpr uint64_t max_dense_overhead = 3;
+
+    /**
+     * Count the nodes and find the largest node ID in the blobs read by a reader.
+     */
+    class NodeSampler : public osmium::handler::Handler {
+    public:
+        uint64_t count = 0;
+        uint64_t max_id = 0;
+
+        void node(const osmium::Node& node) {
+            ++count;
+            if (node.id() > 0 && node.positive_id() > max_id) {
+                max_id = node.positive_id();
+            }
+        }
+    };
+
+    void sample_blob(const std::string& filename, const PBFBlobIndex& blob_index, const BlobIndexEntry& entry,
+            NodeSampler& sampler) {
+        BlobRangeInput input(filename, blob_index.header_size(), std::make_pair(entry.offset, entry.offset + entry.size));
+        osmium::io::Reader reader(input.file(), osmium::osm_entity_bits::node);
+        osmium::apply(reader, sampler);
+        reader.close();
+        input.close();
+    }
+
+    uint64_t megabytes(const uint64_t bytes) {
+        return bytes / (1024 * 1024);
+    }
+
+} // namespace
+
+LocationIndexSelector::LocationIndexSelector(const std::string& filename, const PBFBlobIndex* blob_index,
+        osmium::util::VerboseOutput& verbose_output) :
+    m_filename(filename),
+    m_blob_index(blob_index),
+    m_verbose_output(verbose_output) {
+    if (m_filename.empty() || m_filename == "-") {
+        throw std::runtime_error{"--index auto cannot be used if reading from STDIN."};
+    }
+    osmium::io::Reader reader(m_filename, osmium::osm_entity_bits::nothing);
+    m_sorted = reader.header().get("sorting") == "Type_then_ID";
+    reader.close();
+    if (m_blob_index) {
+        estimate_from_blobs();
+    } else {
+        estimate_from_file_size();
+    }
+}
+
+void LocationIndexSelector::estimate_from_blobs() {
+    const BlobIndexEntry* first = nullptr;
+    const BlobIndexEntry* last = nullptr;
+    uint64_t blob_count = 0;
+    for (const BlobIndexEntry& entry : m_blob_index->entries()) {
+        if (entry.type == osmium::osm_entity_bits::node) {
+            if (!first) {
+                first = &entry;
+            }
+            last = &entry;
+            ++blob_count;
+        }
+    }
+    if (!first) {
+        return;
+    }
+    NodeSampler first_sample;
+    sample_blob(m_filename, *m_blob_index, *first, first_sample);
+    if (first == last) {
+        m_node_count = first_sample.count;
+        m_max_id = first_sample.max_id;
+    } else {
+        NodeSampler last_sample;
+        sample_blob(m_filename, *m_blob_index, *last, last_sample);
+        m_node_count = (blob_count - 1) * first_sample.count + last_sample.count;
+        m_max_id = std::max(first_sample.max_id, last_sample.max_id);
+    }
+    m_verbose_output << "Sampled " << blob_count << " node blobs: about " << m_node_count
+            << " nodes, largest node ID " << m_max_id << '\n';
+}
+
+void LocationIndexSelector::estimate_from_file_size() {
+    struct stat file_stat;
+    if (::stat(m_filename.c_str(), &file_stat)) {
+        throw std::system_error{errno, std::system_category(), "Could not stat " + m_filename};
+    }
+    m_node_count = static_cast<uint64_t>(file_stat.st_size) / pbf_bytes_per_node;
+    m_max_id = default_max_node_id;
+    m_verbose_output << "No blob index available, estimating about " << m_node_count
+            << " nodes from the file size, assuming largest node ID " << m_max_id << '\n';
+}
+
+std::string LocationIndexSelector::select(uint64_t memory_budget, const std::string& directory) {
+    if (memory_budget == 0) {
+        // leave a quarter of the physical memory to the other data structures
+        memory_budget = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 4 * 3;
+    }
+    const uint64_t dense_size = (m_max_id + 1) * dense_bytes_per_id;
+    const uint64_t sparse_size = m_node_count * sparse_bytes_per_node;
+    // sparse_delta_mem_array stores nodes out of order uncompressed
+    const uint64_t delta_size = m_node_count * (m_sorted ? delta_bytes_per_node : sparse_bytes_per_node) * vector_growth_factor;
+
+    // candidates ordered by lookup speed, the mmap variants are preferred because they grow without copying
+    std::string type;
+    uint64_t projected_size = 0;
+    if (dense_size <= memory_budget && dense_size <= sparse_size * max_dense_overhead) {
+        type = "dense_mmap_array";
+        projected_size = dense_size;
+    } else if (sparse_size <= memory_budget) {
+        type = "sparse_mmap_array";
+        projected_size = sparse_size;
+    } else if (delta_size <= memory_budget) {
+        type = "sparse_delta_mem_array";
+        projected_size = delta_size;
+    } else {
+        // Nothing fits into the memory, the index is written to disk and the page cache is used.
+        // The file gets a unique name because multiple processes might use the same directory.
+        std::string index_filename = directory.empty() ? "." : directory;
+        index_filename += "/node_locations.XXXXXX";
+        const int fd = ::mkstemp(&index_filename[0]);
+        if (fd == -1) {
+            throw std::system_error{errno, std::system_category(), "Could not create " + index_filename};
+        }
+        ::close(fd);
+        if (dense_size <= sparse_size * max_dense_overhead) {
+            type = "dense_file_array," + index_filename;
+            projected_size = dense_size;
+        } else {
+            type = "sparse_file_array," + index_filename;
+            projected_size = sparse_size;
+        }
+    }
+    m_verbose_output << "Memory budget for the location index: " << megabytes(memory_budget) << " MB ("
+            << "dense: " << megabytes(dense_size) << " MB, sparse: " << megabytes(sparse_size)
+            << " MB, sparse_delta: " << megabytes(delta_size) << " MB)\n";
+    m_verbose_output << "Using location index " << type << ", projected memory usage " << megabytes(projected_size) << " MB\n";
+    return type;
+}
+
+uint64_t LocationIndexSelector::expected_size(const std::string& type) const {
+    if (type == "dense_mmap_array" || type == "dense_mem_array") {
+        return m_max_id + 1;
+    }
+    if (type == "sparse_mmap_array" || type == "sparse_mem_array") {
+        return m_node_count;
+    }
+    return 0;
+}
+
+/*static*/ uint64_t LocationIndexSelector::parse_memory_size(const std::string& size) {
+    if (size.empty() || !std::isdigit(static_cast<unsigned char>(size.front()))) {
+        throw std::invalid_argument{"Invalid memory size: " + size};
+    }
+    size_t end = 0;
+    uint64_t value = 0;
+    try {
+        value = std::stoull(size, &end);
+    } catch (const std::out_of_range&) {
+        throw std::invalid_argument{"Memory size is too large: " + size};
+    }
+    if (end + 1 < size.size()) {
+        throw std::invalid_argument{"Invalid memory size: " + size};
+    }
+    uint64_t factor = 1;
+    if (end < size.size()) {
+        switch (std::toupper(static_cast<unsigned char>(size[end]))) {
+        case 'T':
+            factor = 1ULL << 40;
+            break;
+        case 'G':
+            factor = 1ULL << 30;
+            break;
+        case 'M':
+            factor = 1ULL << 20;
+            break;
+        case 'K':
+            factor = 1ULL << 10;
+            break;
+        default:
+            throw std::invalid_argument{"Invalid memory size: " + size};
+        }
+    }
+    if (value > std::numeric_limits<uint64_t>::max() / factor) {
+        throw std::invalid_argument{"Memory size is too large: " + size};
+    }
+    return value * factor;
+}
@@ -0,0 +1,85 @@
+/*
+ * location_index_selector.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_LOCATION_INDEX_SELECTOR_HPP_
+#define SRC_LOCATION_INDEX_SELECTOR_HPP_
+
+#include <string>
+
+#include <osmium/util/verbose_output.hpp>
+
+#include "pbf_blob_index.hpp"
+
+/**
+ * Select the fastest type of location index whose memory usage fits into a memory budget.
+ *
+ * The number of nodes and the largest node ID are estimated by reading the first and the
+ * last node blob of the input file. This requires a blob index (see PBFBlobIndex). If no
+ * blob index is available, the number of nodes is estimated from the size of the input
+ * file and the largest node ID of the planet is assumed.
+ */
+class LocationIndexSelector {
+    const std::string& m_filename;
+
+    const PBFBlobIndex* m_blob_index;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    /// estimated number of nodes
+    uint64_t m_node_count = 0;
+
+    /// estimated largest node ID
+    uint64_t m_max_id = 0;
+
+    /// Is the input file sorted by ID? Unsorted data is stored uncompressed by sparse_delta_mem_array.
+    bool m_sorted = false;
+
+    void estimate_from_blobs();
+
+    void estimate_from_file_size();
+
+public:
+    LocationIndexSelector() = delete;
+
+    /**
+     * \param filename input file
+     * \param blob_index blob index of the input file, nullptr if not available
+     * \param verbose_output verbose output stream
+     */
+    LocationIndexSelector(const std::string& filename, const PBFBlobIndex* blob_index,
+            osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Select an index type.
+     *
+     * \param memory_budget maximum memory usage of the index in bytes, 0 to use the size
+     * of the physical memory
+     *
+     * \param directory directory for the index file if the index does not fit into memory,
+     * the file is created with a unique name and has to be removed by the caller
+     *
+     * \returns name of the index type (and its file if necessary) to be passed to the MapFactory
+     */
+    std::string select(uint64_t memory_budget, const std::string& directory);
+
+    /**
+     * Get the estimated number of entries of an index of the vector based types.
+     *
+     * \returns estimated number of entries, 0 for other types
+     */
+    uint64_t expected_size(const std::string& type) const;
+
+    /**
+     * Parse a size like `1500M`, `8G` or `123456` (bytes). The suffixes K, M, G and T
+     * are powers of 1024.
+     *
+     * \throws std::invalid_argument if the string is not a valid size
+     */
+    static uint64_t parse_memory_size(const std::string& size);
+};
+
+#endif /* SRC_LOCATION_INDEX_SELECTOR_HPP_ */
@@ -0,0 +1,220 @@
+/*
+ * location_store.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "location_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/io/any_input.hpp>
+
+namespace {
+
+    /// magic bytes at the beginning of a location store (including the version of the format)
+    const char location_store_magic[16] = "OSMI_LOCSTORE_1";
+
+    /// number of entries written at once
+    constexpr size_t write_buffer_size = 64 * 1024;
+
+    void fill_header(LocationStoreHeader& header, const LocationStoreIdentity& identity, const uint64_t count) {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, location_store_magic, sizeof(header.magic));
+        header.file_size = identity.file_size;
+        header.file_mtime = identity.file_mtime;
+        std::strncpy(header.timestamp, identity.timestamp.c_str(), sizeof(header.timestamp) - 1);
+        header.count = count;
+    }
+
+} // namespace
+
+/*static*/ LocationStoreIdentity LocationStoreIdentity::of(const std::string& filename) {
+    if (filename.empty() || filename == "-") {
+        throw std::runtime_error{"A location store cannot be used if reading from STDIN."};
+    }
+    LocationStoreIdentity identity;
+    struct stat file_stat;
+    if (::stat(filename.c_str(), &file_stat)) {
+        throw std::system_error{errno, std::system_category(), "Could not stat " + filename};
+    }
+    identity.file_size = static_cast<uint64_t>(file_stat.st_size);
+    identity.file_mtime = static_cast<int64_t>(file_stat.st_mtime);
+    osmium::io::Reader reader{filename, osmium::osm_entity_bits::nothing};
+    identity.timestamp = reader.header().get("osmosis_replication_timestamp");
+    reader.close();
+    // The timestamp is truncated to the length of the field in the header of the file.
+    if (identity.timestamp.size() >= sizeof(LocationStoreHeader::timestamp)) {
+        identity.timestamp.resize(sizeof(LocationStoreHeader::timestamp) - 1);
+    }
+    return identity;
+}
+
+bool LocationStoreIdentity::operator==(const LocationStoreIdentity& other) const {
+    return file_size == other.file_size && file_mtime == other.file_mtime && timestamp == other.timestamp;
+}
+
+
+LocationStoreWriter::LocationStoreWriter(const std::string& filename, const LocationStoreIdentity& identity) :
+    m_filename(filename),
+    m_temp_filename(filename),
+    m_identity(identity),
+    m_buffer() {
+    m_temp_filename += ".tmp.";
+    m_temp_filename += std::to_string(::getpid());
+    m_file = fopen(m_temp_filename.c_str(), "wb");
+    if (!m_file) {
+        throw std::system_error{errno, std::system_category(), "Could not open " + m_temp_filename};
+    }
+    // The header is written again with the correct number of entries by commit().
+    LocationStoreHeader header;
+    fill_header(header, m_identity, 0);
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        m_valid = false;
+    }
+    m_buffer.reserve(write_buffer_size);
+}
+
+LocationStoreWriter::~LocationStoreWriter() {
+    if (m_file) {
+        fclose(m_file);
+        ::unlink(m_temp_filename.c_str());
+    }
+}
+
+void LocationStoreWriter::add(const osmium::Node& node) {
+    if (!m_valid || node.id() <= 0) {
+        return;
+    }
+    const osmium::unsigned_object_id_type id = node.positive_id();
+    if (id <= m_last_id) {
+        std::cerr << "WARNING: Input file is not sorted by ID. No location store will be written.\n";
+        m_valid = false;
+        return;
+    }
+    m_last_id = id;
+    m_buffer.push_back(LocationStoreEntry{id, node.location().x(), node.location().y()});
+    if (m_buffer.size() == write_buffer_size) {
+        flush_buffer();
+    }
+}
+
+void LocationStoreWriter::flush_buffer() {
+    if (m_valid && !m_buffer.empty() && fwrite(m_buffer.data(), sizeof(LocationStoreEntry), m_buffer.size(), m_file) != m_buffer.size()) {
+        std::cerr << "ERROR: Writing location store " << m_temp_filename << " failed.\n";
+        m_valid = false;
+    }
+    m_count += m_buffer.size();
+    m_buffer.clear();
+}
+
+bool LocationStoreWriter::commit() {
+    flush_buffer();
+    LocationStoreHeader header;
+    fill_header(header, m_identity, m_count);
+    if (m_valid) {
+        m_valid = fseek(m_file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, m_file) == 1;
+    }
+    m_valid = (fclose(m_file) == 0) && m_valid;
+    m_file = nullptr;
+    if (!m_valid || rename(m_temp_filename.c_str(), m_filename.c_str())) {
+        ::unlink(m_temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+LocationStoreIndex::LocationStoreIndex(int fd, void* mapping, size_t mapping_size) :
+    m_fd(fd),
+    m_mapping(mapping),
+    m_mapping_size(mapping_size) {
+    const LocationStoreHeader* header = static_cast<const LocationStoreHeader*>(m_mapping);
+    m_begin = reinterpret_cast<const LocationStoreEntry*>(header + 1);
+    m_end = m_begin + header->count;
+}
+
+LocationStoreIndex::~LocationStoreIndex() noexcept {
+    ::munmap(m_mapping, m_mapping_size);
+    ::close(m_fd);
+}
+
+/*static*/ std::unique_ptr<LocationStoreIndex> LocationStoreIndex::open(const std::string& filename,
+        const LocationStoreIdentity& identity) {
+    std::unique_ptr<LocationStoreIndex> index;
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return index;
+    }
+    struct stat file_stat;
+    LocationStoreHeader header;
+    if (::fstat(fd, &file_stat) || static_cast<size_t>(file_stat.st_size) < sizeof(header)
+            || ::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        ::close(fd);
+        return index;
+    }
+    LocationStoreIdentity stored_identity;
+    stored_identity.file_size = header.file_size;
+    stored_identity.file_mtime = header.file_mtime;
+    header.timestamp[sizeof(header.timestamp) - 1] = '\0';
+    stored_identity.timestamp = header.timestamp;
+    if (std::memcmp(header.magic, location_store_magic, sizeof(header.magic)) || !(stored_identity == identity)
+            || static_cast<uint64_t>(file_stat.st_size) != sizeof(header) + header.count * sizeof(LocationStoreEntry)) {
+        ::close(fd);
+        return index;
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::system_category(), "Could not map location store " + filename};
+    }
+    index.reset(new LocationStoreIndex(fd, mapping, size));
+    return index;
+}
+
+void LocationStoreIndex::set(const osmium::unsigned_object_id_type, const osmium::Location) {
+    throw std::runtime_error{"Location store is read-only"};
+}
+
+osmium::Location LocationStoreIndex::get(const osmium::unsigned_object_id_type id) const {
+    const osmium::Location location = get_noexcept(id);
+    if (!location) {
+        throw osmium::not_found{id};
+    }
+    return location;
+}
+
+osmium::Location LocationStoreIndex::get_noexcept(const osmium::unsigned_object_id_type id) const noexcept {
+    const LocationStoreEntry* it = std::lower_bound(m_begin, m_end, id,
+            [](const LocationStoreEntry& entry, const osmium::unsigned_object_id_type search_id) {
+                return entry.id < search_id;
+            });
+    if (it == m_end || it->id != id) {
+        return osmium::Location{};
+    }
+    return osmium::Location{it->x, it->y};
+}
+
+size_t LocationStoreIndex::size() const {
+    return static_cast<size_t>(m_end - m_begin);
+}
+
+size_t LocationStoreIndex::used_memory() const {
+    return m_mapping_size;
+}
+
+void LocationStoreIndex::clear() {
+}
@@ -0,0 +1,150 @@
+/*
+ * location_store.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_LOCATION_STORE_HPP_
+#define SRC_LOCATION_STORE_HPP_
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <osmium/index/map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+/**
+ * Identity of an input file. A location store can only be used for the input
+ * file it was created from.
+ */
+struct LocationStoreIdentity {
+    /// size of the input file in bytes
+    uint64_t file_size = 0;
+
+    /// modification time of the input file
+    int64_t file_mtime = 0;
+
+    /// value of `osmosis_replication_timestamp` in the header of the input file
+    std::string timestamp;
+
+    /**
+     * Determine the identity of an input file. This reads the header of the file.
+     */
+    static LocationStoreIdentity of(const std::string& filename);
+
+    bool operator==(const LocationStoreIdentity& other) const;
+};
+
+/**
+ * On-disk format of a location store
+ *
+ * The file starts with a LocationStoreHeader, followed by LocationStoreEntry
+ * structs sorted by ID. Byte order is the byte order of the machine.
+ */
+struct LocationStoreHeader {
+    char magic[16];
+    uint64_t file_size;
+    int64_t file_mtime;
+    char timestamp[24];
+    uint64_t count;
+};
+
+struct LocationStoreEntry {
+    uint64_t id;
+    int32_t x;
+    int32_t y;
+};
+
+/**
+ * Write the locations of all nodes of the input file to a location store.
+ *
+ * The file is written under a temporary name and renamed when commit() is called.
+ * Therefore other processes never see incomplete files.
+ */
+class LocationStoreWriter {
+    std::string m_filename;
+
+    std::string m_temp_filename;
+
+    LocationStoreIdentity m_identity;
+
+    FILE* m_file = nullptr;
+
+    std::vector<LocationStoreEntry> m_buffer;
+
+    uint64_t m_count = 0;
+
+    osmium::unsigned_object_id_type m_last_id = 0;
+
+    /// set to false if an error happened or the input is not sorted
+    bool m_valid = true;
+
+    void flush_buffer();
+
+public:
+    LocationStoreWriter() = delete;
+
+    LocationStoreWriter(const std::string& filename, const LocationStoreIdentity& identity);
+
+    ~LocationStoreWriter();
+
+    void add(const osmium::Node& node);
+
+    /**
+     * Finish the file and make it available to other processes.
+     *
+     * \returns false if the location store could not be written
+     */
+    bool commit();
+};
+
+/**
+ * Read-only location index backed by a location store which is mapped into memory.
+ *
+ * Any number of processes can use the same location store at the same time.
+ */
+class LocationStoreIndex : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+    int m_fd = -1;
+
+    void* m_mapping = nullptr;
+
+    size_t m_mapping_size = 0;
+
+    const LocationStoreEntry* m_begin = nullptr;
+
+    const LocationStoreEntry* m_end = nullptr;
+
+    LocationStoreIndex(int fd, void* mapping, size_t mapping_size);
+
+public:
+    LocationStoreIndex() = delete;
+
+    ~LocationStoreIndex() noexcept;
+
+    /**
+     * Open a location store.
+     *
+     * \returns an empty pointer if the file does not exist or belongs to another input file
+     */
+    static std::unique_ptr<LocationStoreIndex> open(const std::string& filename, const LocationStoreIdentity& identity);
+
+    /// This index is read-only, calling this method throws an exception.
+    void set(const osmium::unsigned_object_id_type id, const osmium::Location value) final;
+
+    osmium::Location get(const osmium::unsigned_object_id_type id) const final;
+
+    osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final;
+
+    size_t size() const final;
+
+    size_t used_memory() const final;
+
+    void clear() final;
+};
+
+#endif /* SRC_LOCATION_STORE_HPP_ */
@@ -0,0 +1,24 @@
+/*
+ * needed_nodes_handler.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "needed_nodes_handler.hpp"
+
+NeededNodesHandler::NeededNodesHandler(const WayGeometryFilter& filter,
+        osmium::index::IdSetDense<osmium::unsigned_object_id_type>& needed_nodes) :
+        m_filter(filter),
+        m_needed_nodes(needed_nodes) {}
+
+void NeededNodesHandler::way(const osmium::Way& way) {
+    if (!m_filter(way)) {
+        return;
+    }
+    for (const osmium::NodeRef& nd_ref : way.nodes()) {
+        if (nd_ref.ref() > 0) {
+            m_needed_nodes.set(static_cast<osmium::unsigned_object_id_type>(nd_ref.ref()));
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * needed_nodes_handler.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_NEEDED_NODES_HANDLER_HPP_
+#define SRC_NEEDED_NODES_HANDLER_HPP_
+
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "way_geometry_filter.hpp"
+
+/**
+ * This handler populates an IdSet with the IDs of all nodes whose locations are required to
+ * build way geometries: nodes of route member ways and of platform and station ways.
+ */
+class NeededNodesHandler : public osmium::handler::Handler {
+    /// filter deciding which ways need the locations of their nodes
+    const WayGeometryFilter& m_filter;
+
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type>& m_needed_nodes;
+
+public:
+    NeededNodesHandler() = delete;
+
+    NeededNodesHandler(const WayGeometryFilter& filter,
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type>& needed_nodes);
+
+    void way(const osmium::Way& way);
+};
+
+#endif /* SRC_NEEDED_NODES_HANDLER_HPP_ */
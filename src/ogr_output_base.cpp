@@ -20,12 +20,17 @@
 
 #include "ogr_output_base.hpp"
 
+#include <cinttypes>
+#include <cstdio>
+
 OGROutputBase::OGROutputBase(OGRWriter& writer, osmium::util::VerboseOutput& verbose_output, Options& options) :
         m_writer(writer),
 #ifdef MERCATOR_OUTPUT
         m_factory(osmium::geom::MercatorProjection()),
+        m_wkb_factory(osmium::geom::MercatorProjection()),
 #else
         m_factory(),
+        m_wkb_factory(),
 #endif
         m_verbose_output(verbose_output),
         m_options(options) { }
@@ -45,3 +50,51 @@ ogr_factory_type& OGROutputBase::factory() {
 osmium::util::VerboseOutput& OGROutputBase::verbose_output() {
     return m_verbose_output;
 }
+
+OutputFeature OGROutputBase::create_point_feature(const OutputLayer& layer, const osmium::Node& node) {
+    if (m_writer.accepts_wkb()) {
+        return OutputFeature(layer, m_wkb_factory.create_point(node));
+    }
+    return OutputFeature(layer, m_factory.create_point(node));
+}
+
+OutputFeature OGROutputBase::create_linestring_feature(const OutputLayer& layer, const osmium::Way& way) {
+    if (m_writer.accepts_wkb()) {
+        return OutputFeature(layer, m_wkb_factory.create_linestring(way));
+    }
+    return OutputFeature(layer, m_factory.create_linestring(way));
+}
+
+void OGROutputBase::add_id_field(OutputLayer& layer, const char* field_name) {
+    if (m_options.typed_schema) {
+        layer.add_field(field_name, OFTInteger64, 20);
+    } else {
+        layer.add_field(field_name, OFTString, 10);
+    }
+}
+
+void OGROutputBase::add_timestamp_field(OutputLayer& layer, const char* field_name) {
+    if (m_options.typed_schema) {
+        layer.add_field(field_name, OFTDateTime, 0);
+    } else {
+        layer.add_field(field_name, OFTString, 21);
+    }
+}
+
+void OGROutputBase::set_id_field(OutputFeature& feature, int field_index, osmium::object_id_type id) {
+    if (m_options.typed_schema) {
+        feature.set_integer_field(field_index, id);
+        return;
+    }
+    char idbuffer[24];
+    snprintf(idbuffer, sizeof(idbuffer), "%" PRId64, static_cast<int64_t>(id));
+    feature.set_field(field_index, idbuffer);
+}
+
+void OGROutputBase::set_timestamp_field(OutputFeature& feature, int field_index, const osmium::Timestamp& timestamp) {
+    if (m_options.typed_schema) {
+        feature.set_timestamp_field(field_index, timestamp);
+        return;
+    }
+    feature.set_field(field_index, timestamp.to_iso().c_str());
+}
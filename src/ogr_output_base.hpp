@@ -24,6 +24,7 @@
 #include <gdalcpp.hpp>
 
 #include <osmium/geom/ogr.hpp>
+#include <osmium/geom/wkb.hpp>
 
 #ifdef MERCATOR_OUTPUT
     #include <osmium/geom/mercator_projection.hpp>
@@ -37,9 +38,13 @@
 #ifdef MERCATOR_OUTPUT
     /// factory to build OGR geometries in Web Mercator projection
     using ogr_factory_type = osmium::geom::OGRFactory<osmium::geom::MercatorProjection>;
+    /// factory to build WKB geometries in Web Mercator projection
+    using wkb_factory_type = osmium::geom::WKBFactory<osmium::geom::MercatorProjection>;
 #else
     /// factory to build OGR geometries with a coordinate transformation if necessary
     using ogr_factory_type = osmium::geom::OGRFactory<>;
+    /// factory to build WKB geometries
+    using wkb_factory_type = osmium::geom::WKBFactory<>;
 #endif
 
 /**
@@ -58,6 +63,9 @@ protected:
 
     ogr_factory_type m_factory;
 
+    /// factory to build WKB geometries if the writer accepts them
+    wkb_factory_type m_wkb_factory;
+
     /// reference to output manager for STDERR
     osmium::util::VerboseOutput& m_verbose_output;
 
@@ -81,6 +89,42 @@ public:
 
     osmium::util::VerboseOutput& verbose_output();
 
+    /**
+     * Add a field for an OSM object ID to a layer. It is a 64-bit integer field if
+     * Options::typed_schema is set and a string field otherwise.
+     */
+    void add_id_field(OutputLayer& layer, const char* field_name);
+
+    /**
+     * Add a field for a timestamp to a layer. It is a date/time field if Options::typed_schema
+     * is set and a string field otherwise.
+     */
+    void add_timestamp_field(OutputLayer& layer, const char* field_name);
+
+    /**
+     * Set the value of a field added by add_id_field().
+     */
+    void set_id_field(OutputFeature& feature, int field_index, osmium::object_id_type id);
+
+    /**
+     * Set the value of a field added by add_timestamp_field().
+     */
+    void set_timestamp_field(OutputFeature& feature, int field_index, const osmium::Timestamp& timestamp);
+
+    /**
+     * Create a feature with the location of a node as geometry.
+     *
+     * The geometry is built as WKB if the writer accepts WKB. Otherwise an OGR geometry is built.
+     */
+    OutputFeature create_point_feature(const OutputLayer& layer, const osmium::Node& node);
+
+    /**
+     * Create a feature with the geometry of a way as linestring.
+     *
+     * The geometry is built as WKB if the writer accepts WKB. Otherwise an OGR geometry is built.
+     */
+    OutputFeature create_linestring_feature(const OutputLayer& layer, const osmium::Way& way);
+
     inline bool coordinates_valid(const osmium::Location& location) {
 #ifdef MERCATOR_OUTPUT
         return location.valid() && location.lat() < UPPER_LIMIT_LATITUDE && location.lat() > -UPPER_LIMIT_LATITUDE;
@@ -6,17 +6,161 @@
  */
 
 #include "ogr_writer.hpp"
+#include "spatial_index_builder.hpp"
+#include "sqlite_merger.hpp"
+
+#include <ctime>
+#include <stdexcept>
+#include <unistd.h>
 
 #ifdef MERCATOR_OUTPUT
     constexpr int SRS = 3857;
+    /// extent of the output coordinate system
+    constexpr double EXTENT_MIN_X = -20037508.342789244;
+    constexpr double EXTENT_MIN_Y = -20037508.342789244;
+    constexpr double EXTENT_MAX_X = 20037508.342789244;
+    constexpr double EXTENT_MAX_Y = 20037508.342789244;
 #else
     constexpr int SRS = 4326;
+    /// extent of the output coordinate system
+    constexpr double EXTENT_MIN_X = -180.0;
+    constexpr double EXTENT_MIN_Y = -90.0;
+    constexpr double EXTENT_MAX_X = 180.0;
+    constexpr double EXTENT_MAX_Y = 90.0;
 #endif
 
+namespace {
+
+    /**
+     * Convert a little-endian WKB geometry to an OGR geometry.
+     */
+    std::unique_ptr<OGRGeometry> wkb_to_geometry(std::string& wkb) {
+        OGRGeometry* geometry = nullptr;
+        if (OGRGeometryFactory::createFromWkb(reinterpret_cast<unsigned char*>(&wkb[0]), nullptr, &geometry,
+                static_cast<int>(wkb.size())) != OGRERR_NONE) {
+            throw std::runtime_error{"Failed to convert WKB geometry"};
+        }
+        return std::unique_ptr<OGRGeometry>{geometry};
+    }
+
+    /**
+     * Convert a timestamp (seconds since the epoch) to the value of an OFTDateTime field.
+     */
+    OGRField date_time_value(int64_t timestamp) {
+        const time_t seconds = static_cast<time_t>(timestamp);
+        struct tm time;
+        gmtime_r(&seconds, &time);
+        OGRField value;
+        value.Date.Year = static_cast<GInt16>(time.tm_year + 1900);
+        value.Date.Month = static_cast<GByte>(time.tm_mon + 1);
+        value.Date.Day = static_cast<GByte>(time.tm_mday);
+        value.Date.Hour = static_cast<GByte>(time.tm_hour);
+        value.Date.Minute = static_cast<GByte>(time.tm_min);
+        value.Date.Second = static_cast<float>(time.tm_sec);
+        // UTC
+        value.Date.TZFlag = 100;
+        value.Date.Reserved = 0;
+        return value;
+    }
+
+} // namespace
+
+OutputLayer::OutputLayer(OGRWriter& writer, size_t id) :
+    m_writer(writer),
+    m_id(id) {
+}
+
+void OutputLayer::add_field(const char* field_name, OGRFieldType type, int width, int precision /* = 0 */) {
+    m_writer.add_field(m_id, field_name, type, width, precision);
+}
+
+size_t OutputLayer::id() const noexcept {
+    return m_id;
+}
+
+OGRWriter& OutputLayer::writer() const noexcept {
+    return m_writer;
+}
+
+
+OutputFeature::OutputFeature(const OutputLayer& layer, std::unique_ptr<OGRGeometry>&& geometry) {
+    gdalcpp::Layer* gdal_layer = layer.writer().direct_layer(layer.id());
+    if (gdal_layer) {
+        m_feature.reset(new gdalcpp::Feature(*gdal_layer, std::move(geometry)));
+        return;
+    }
+    std::string wkb;
+    if (geometry) {
+        wkb.resize(geometry->WkbSize());
+        geometry->exportToWkb(wkbNDR, reinterpret_cast<unsigned char*>(&wkb[0]));
+    }
+    m_record.reset(new FeatureRecord(layer.id(), std::move(wkb)));
+}
+
+OutputFeature::OutputFeature(const OutputLayer& layer, std::string&& wkb) {
+    gdalcpp::Layer* gdal_layer = layer.writer().direct_layer(layer.id());
+    if (gdal_layer) {
+        m_feature.reset(new gdalcpp::Feature(*gdal_layer, wkb.empty() ? nullptr : wkb_to_geometry(wkb)));
+        return;
+    }
+    m_record.reset(new FeatureRecord(layer.id(), std::move(wkb)));
+}
+
+void OutputFeature::set_field(int field_index, const char* value) {
+    if (!value) {
+        value = "";
+    }
+    if (m_feature) {
+        m_feature->set_field(field_index, value);
+    } else {
+        m_record->add_string(field_index, value);
+    }
+}
+
+void OutputFeature::set_integer_field(int field_index, int64_t value) {
+    if (m_feature) {
+        m_feature->set_field(field_index, static_cast<GIntBig>(value));
+    } else {
+        m_record->add_integer(field_index, value);
+    }
+}
+
+void OutputFeature::set_timestamp_field(int field_index, const osmium::Timestamp& timestamp) {
+    if (m_feature) {
+        OGRField value = date_time_value(timestamp.seconds_since_epoch());
+        m_feature->set_field(field_index, &value);
+    } else {
+        m_record->add_timestamp(field_index, timestamp.seconds_since_epoch());
+    }
+}
+
+gdalcpp::Feature* OutputFeature::gdal_feature() noexcept {
+    return m_feature.get();
+}
+
+std::unique_ptr<FeatureRecord> OutputFeature::release() {
+    return std::move(m_record);
+}
+
+
 OGRWriter::OGRWriter(Options& options, osmium::util::VerboseOutput& verbose_output) :
     m_verbose_output(verbose_output),
     m_options(options),
-    m_datasets() {
+    m_datasets(),
+    m_write_direct(!options.native_spatialite && !options.async_writer && !options.parallel_layers
+            && !options.hilbert_sort),
+    m_curve(EXTENT_MIN_X, EXTENT_MIN_Y, EXTENT_MAX_X, EXTENT_MAX_Y) {
+    if (m_options.async_writer && !m_options.parallel_layers) {
+        m_queues.emplace_back(new FeatureQueue([this](FeatureRecord& record) {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            write_record(record);
+        }));
+    }
+}
+
+OGRWriter::~OGRWriter() {
+    // Stop the writer threads before the layers are destroyed.
+    m_queues.clear();
 }
 
 
@@ -48,7 +192,105 @@ std::string OGRWriter::filename_suffix() {
     return "";
 }
 
+std::vector<std::string> OGRWriter::close_datasets() {
+    m_queues.clear();
+    std::vector<std::string> filenames;
+    for (auto& file : m_spatialite_files) {
+        file->close();
+        filenames.push_back(file->filename());
+    }
+    m_tables.clear();
+    m_spatialite_files.clear();
+    m_layers.clear();
+    for (auto& d : m_datasets) {
+        filenames.push_back(d->dataset_name());
+    }
+    m_datasets.clear();
+    return filenames;
+}
+
+std::string OGRWriter::merge_layer_files() {
+    const std::vector<std::string> filenames = close_datasets();
+    if (filenames.empty()) {
+        return "";
+    }
+    m_verbose_output << "Merging " << filenames.size() << " layer files ...\n";
+    try {
+        SQLiteMerger merger {filenames.front()};
+        for (auto it = filenames.begin() + 1; it != filenames.end(); ++it) {
+            try {
+                merger.merge(*it);
+            } catch (const std::exception& err) {
+                // The layer file is kept because its layer is missing in the merged file.
+                std::cerr << "ERROR: Merging " << *it << " into " << filenames.front() << " failed: " << err.what() << '\n';
+                continue;
+            }
+            if (unlink(it->c_str())) {
+                std::cerr << "ERROR: Failed to remove " << *it << '\n';
+            }
+        }
+        merger.close();
+    } catch (const std::exception& err) {
+        std::cerr << "ERROR: Merging layer files into " << filenames.front() << " failed: " << err.what() << '\n';
+        return "";
+    }
+    return filenames.front();
+}
+
+void OGRWriter::build_spatial_index(const std::string& filename) {
+    close_datasets();
+    m_verbose_output << "Building spatial indexes ...\n";
+    SpatialIndexBuilder builder {filename, m_verbose_output};
+    builder.build();
+}
+
+void OGRWriter::write_spooled_features() {
+    if (m_spools.empty()) {
+        return;
+    }
+    m_verbose_output << "Writing features sorted by their Hilbert index ...\n";
+    // The spools are moved out of the member first to let add_record() write the features.
+    std::vector<std::unique_ptr<FeatureSpool>> spools;
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        spools.swap(m_spools);
+    }
+    for (size_t layer_id = 0; layer_id < spools.size(); ++layer_id) {
+        spools[layer_id]->replay(layer_id, [this](std::unique_ptr<FeatureRecord>&& record) {
+            add_record(std::move(record));
+        });
+        spools[layer_id].reset();
+    }
+    flush();
+}
+
 void OGRWriter::rename_output_files(const std::string& view_name) {
+    flush();
+    write_spooled_features();
+    if (m_options.parallel_layers || m_options.native_spatialite) {
+        std::string filename;
+        if (m_options.parallel_layers) {
+            filename = merge_layer_files();
+        } else if (!m_spatialite_files.empty()) {
+            m_spatialite_files.front()->close();
+            filename = m_spatialite_files.front()->filename();
+        }
+        if (filename.empty()) {
+            return;
+        }
+        std::string destination_name {m_options.output_directory};
+        destination_name += '/';
+        destination_name += view_name;
+        destination_name += filename_suffix();
+        if (access(destination_name.c_str(), F_OK) == 0) {
+            std::cerr << "ERROR: Cannot rename output file from to " << destination_name << " because file exists already.\n";
+        } else if (rename(filename.c_str(), destination_name.c_str())) {
+            std::cerr << "ERROR: Rename from " << filename << " to " << destination_name << "failed.\n";
+        } else if (m_options.build_spatial_index) {
+            build_spatial_index(destination_name);
+        }
+        return;
+    }
     if (m_datasets.size() == 1 && filename_suffix().length()) {
         // rename output file if there is one output dataset only
         std::string destination_name {m_options.output_directory};
@@ -60,6 +302,8 @@ void OGRWriter::rename_output_files(const std::string& view_name) {
         } else {
             if (rename(m_datasets.front()->dataset_name().c_str(), destination_name.c_str())) {
                 std::cerr << "ERROR: Rename from " << m_datasets.front()->dataset_name() << " to " << destination_name << "failed.\n";
+            } else if (m_options.build_spatial_index) {
+                build_spatial_index(destination_name);
             }
         }
     } else if (m_datasets.size() > 1 && filename_suffix().length()) {
@@ -78,27 +322,156 @@ void OGRWriter::rename_output_files(const std::string& view_name) {
 }
 
 void OGRWriter::ensure_writeable_dataset(const char* layer_name) {
-    if (m_datasets.empty() || one_layer_per_datasource_only()) {
+    if (m_datasets.empty() || one_layer_per_datasource_only() || m_options.parallel_layers) {
         std::string output_filename = m_options.output_directory;
         output_filename += '/';
         output_filename += layer_name;
         std::unique_ptr<gdalcpp::Dataset> ds {new gdalcpp::Dataset(m_options.output_format,
                 output_filename, gdalcpp::SRS(SRS), get_gdal_default_dataset_options(m_options.output_format))};
         m_datasets.push_back(std::move(ds));
-        m_datasets.back()->enable_auto_transactions(10000);
+        m_datasets.back()->enable_auto_transactions(m_options.transaction_size);
     }
 }
 
-gdalcpp::Layer OGRWriter::create_layer(const char* layer_name, OGRwkbGeometryType type) {
-    ensure_writeable_dataset(layer_name);
-    const std::vector<std::string>& options = get_gdal_default_layer_options(m_options.output_format);
-    return gdalcpp::Layer(*(m_datasets.back()), layer_name, type, options);
+OutputLayer OGRWriter::create_layer(const char* layer_name, OGRwkbGeometryType type) {
+    flush();
+    std::lock_guard<std::mutex> lock {m_mutex};
+    const size_t layer_id = m_options.native_spatialite ? m_tables.size() : m_layers.size();
+    if (m_options.native_spatialite) {
+        if (m_spatialite_files.empty() || m_options.parallel_layers) {
+            std::string output_filename = m_options.output_directory;
+            output_filename += '/';
+            output_filename += layer_name;
+            m_spatialite_files.emplace_back(new SpatialiteWriter(output_filename, SRS, m_options.transaction_size));
+        }
+        SpatialiteWriter* file = m_spatialite_files.back().get();
+        m_tables.emplace_back(file, file->create_table(layer_name, type));
+        if (m_options.parallel_layers) {
+            const size_t table_id = m_tables.back().second;
+            m_queues.emplace_back(new FeatureQueue([file, table_id](FeatureRecord& record) {
+                write_to_spatialite(*file, table_id, record);
+            }));
+        }
+    } else {
+        ensure_writeable_dataset(layer_name);
+        const std::vector<std::string>& options = get_gdal_default_layer_options(m_options.output_format);
+        m_layers.emplace_back(new gdalcpp::Layer(*(m_datasets.back()), layer_name, type, options));
+        if (m_options.parallel_layers) {
+            gdalcpp::Layer* layer = m_layers.back().get();
+            m_queues.emplace_back(new FeatureQueue([layer](FeatureRecord& record) {
+                write_to_layer(*layer, record);
+            }));
+        }
+    }
+    if (m_options.hilbert_sort) {
+        std::string spool_filename = m_options.output_directory;
+        spool_filename += '/';
+        spool_filename += layer_name;
+        spool_filename += ".spool.";
+        spool_filename += std::to_string(::getpid());
+        m_spools.emplace_back(new FeatureSpool(spool_filename, m_curve));
+    }
+    return OutputLayer(*this, layer_id);
 }
 
-std::unique_ptr<gdalcpp::Layer> OGRWriter::create_layer_ptr(const char* layer_name, OGRwkbGeometryType type) {
-    ensure_writeable_dataset(layer_name);
-    const std::vector<std::string>& options = get_gdal_default_layer_options(m_options.output_format);
-    return std::unique_ptr<gdalcpp::Layer>{new gdalcpp::Layer(*(m_datasets.back()), layer_name, type, options)};
+std::unique_ptr<OutputLayer> OGRWriter::create_layer_ptr(const char* layer_name, OGRwkbGeometryType type) {
+    return std::unique_ptr<OutputLayer>{new OutputLayer(create_layer(layer_name, type))};
+}
+
+void OGRWriter::add_field(size_t layer_id, const char* field_name, OGRFieldType type, int width, int precision) {
+    flush();
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if (m_options.native_spatialite) {
+        const auto& table = m_tables.at(layer_id);
+        table.first->add_column(table.second, field_name, type, width);
+        return;
+    }
+    m_layers.at(layer_id)->add_field(field_name, type, width, precision);
+}
+
+bool OGRWriter::accepts_wkb() const noexcept {
+    return !m_write_direct;
+}
+
+gdalcpp::Layer* OGRWriter::direct_layer(size_t layer_id) noexcept {
+    return m_write_direct ? m_layers[layer_id].get() : nullptr;
+}
+
+/*static*/ void OGRWriter::write_to_spatialite(SpatialiteWriter& file, size_t table_id, FeatureRecord& record) {
+    file.insert(table_id, record);
+}
+
+/*static*/ void OGRWriter::write_to_layer(gdalcpp::Layer& layer, FeatureRecord& record) {
+    gdalcpp::Feature feature(layer, record.wkb.empty() ? nullptr : wkb_to_geometry(record.wkb));
+    for (const FeatureRecord::Field& field : record.fields) {
+        switch (field.type) {
+        case FeatureRecord::FieldType::STRING:
+            feature.set_field(field.index, record.string_value(field));
+            break;
+        case FeatureRecord::FieldType::INTEGER:
+            feature.set_field(field.index, static_cast<GIntBig>(field.value));
+            break;
+        case FeatureRecord::FieldType::TIMESTAMP: {
+                OGRField value = date_time_value(field.value);
+                feature.set_field(field.index, &value);
+            }
+            break;
+        }
+    }
+    feature.add_to_layer();
+}
+
+void OGRWriter::write_record(FeatureRecord& record) {
+    if (m_options.native_spatialite) {
+        const auto& table = m_tables[record.layer_id];
+        write_to_spatialite(*table.first, table.second, record);
+    } else {
+        write_to_layer(*m_layers[record.layer_id], record);
+    }
+}
+
+FeatureQueue* OGRWriter::queue(size_t layer_id) {
+    if (m_queues.empty()) {
+        return nullptr;
+    }
+    if (m_options.parallel_layers) {
+        return m_queues[layer_id].get();
+    }
+    return m_queues.front().get();
+}
+
+void OGRWriter::add_feature(OutputFeature& feature) {
+    gdalcpp::Feature* gdal_feature = feature.gdal_feature();
+    if (gdal_feature) {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        gdal_feature->add_to_layer();
+        return;
+    }
+    std::unique_ptr<FeatureRecord> record = feature.release();
+    if (m_options.hilbert_sort) {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        if (!m_spools.empty()) {
+            m_spools[record->layer_id]->add(*record);
+            return;
+        }
+    }
+    add_record(std::move(record));
+}
+
+void OGRWriter::add_record(std::unique_ptr<FeatureRecord>&& record) {
+    FeatureQueue* feature_queue = queue(record->layer_id);
+    if (feature_queue) {
+        feature_queue->push(std::move(record));
+        return;
+    }
+    std::lock_guard<std::mutex> lock {m_mutex};
+    write_record(*record);
+}
+
+void OGRWriter::flush() {
+    for (auto& feature_queue : m_queues) {
+        feature_queue->flush();
+    }
 }
 
 std::vector<std::string> OGRWriter::get_gdal_default_dataset_options(std::string& output_format) {
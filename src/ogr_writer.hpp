@@ -9,13 +9,107 @@
 #define SRC_OGR_WRITER_HPP_
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 #include <gdalcpp.hpp>
+#include <osmium/osm/timestamp.hpp>
 #include <osmium/util/verbose_output.hpp>
+#include "feature_queue.hpp"
+#include "feature_spool.hpp"
+#include "hilbert_curve.hpp"
 #include "options.hpp"
+#include "spatialite_writer.hpp"
+
+class OGRWriter;
+
+/**
+ * Handle of a layer owned by the OGRWriter.
+ */
+class OutputLayer {
+    OGRWriter& m_writer;
+
+    size_t m_id;
+
+public:
+    OutputLayer() = delete;
+
+    OutputLayer(OGRWriter& writer, size_t id);
+
+    void add_field(const char* field_name, OGRFieldType type, int width, int precision = 0);
+
+    size_t id() const noexcept;
+
+    OGRWriter& writer() const noexcept;
+};
+
+/**
+ * Feature to be written to an OutputLayer. It is written when it is passed to
+ * OGRWriter::add_feature().
+ *
+ * If the OGRWriter writes features to GDAL layers by the thread adding them, the
+ * GDAL feature is built directly. Otherwise the geometry and the field values are
+ * recorded in a FeatureRecord.
+ */
+class OutputFeature {
+    /// feature written directly to its GDAL layer, nullptr if the feature is recorded
+    std::unique_ptr<gdalcpp::Feature> m_feature;
+
+    /// recorded feature, nullptr if the feature is written directly
+    std::unique_ptr<FeatureRecord> m_record;
+
+public:
+    OutputFeature() = delete;
+
+    OutputFeature(const OutputLayer& layer, std::unique_ptr<OGRGeometry>&& geometry);
+
+    /**
+     * \param layer layer
+     * \param wkb geometry as little-endian WKB
+     */
+    OutputFeature(const OutputLayer& layer, std::string&& wkb);
+
+    /**
+     * Set the value of a field. Setting a null pointer is equal to setting an empty string.
+     */
+    void set_field(int field_index, const char* value);
+
+    /**
+     * Set the value of an integer field (OFTInteger or OFTInteger64).
+     */
+    void set_integer_field(int field_index, int64_t value);
+
+    /**
+     * Set the value of a date/time field (OFTDateTime).
+     */
+    void set_timestamp_field(int field_index, const osmium::Timestamp& timestamp);
+
+    /**
+     * Get the GDAL feature if the feature is written directly, nullptr otherwise.
+     */
+    gdalcpp::Feature* gdal_feature() noexcept;
+
+    /**
+     * Get the recorded feature, nullptr if the feature is written directly.
+     */
+    std::unique_ptr<FeatureRecord> release();
+};
 
 /**
  * This class manages the output datasets and serves as factory for layers.
+ *
+ * In asynchronous mode (Options::async_writer), features are queued and written
+ * by a separate thread.
+ *
+ * If Options::native_spatialite is set, all layers are written to a SpatiaLite database
+ * by a SpatialiteWriter instead of GDAL.
+ *
+ * If Options::parallel_layers is set, each layer is written to its own SQLite file by its own
+ * thread. The files are merged into one file by rename_output_files().
+ *
+ * If Options::hilbert_sort is set, features are buffered in a FeatureSpool per layer and
+ * written sorted by the Hilbert index of their bounding box by rename_output_files().
  */
 class OGRWriter {
 public:
@@ -35,6 +129,44 @@ private:
     // 'm_options' has a deleted copy constructor".
     datasets_type m_datasets;
 
+    /// all layers, the index is the ID of the layer (unused if the native SpatiaLite writer is used)
+    std::vector<std::unique_ptr<gdalcpp::Layer>> m_layers;
+
+    /**
+     * Native SpatiaLite output files (only if Options::native_spatialite is set). There is one
+     * file per layer if Options::parallel_layers is set and one file for all layers otherwise.
+     */
+    std::vector<std::unique_ptr<SpatialiteWriter>> m_spatialite_files;
+
+    /// SpatiaLite file and table ID of all layers, the index is the ID of the layer
+    std::vector<std::pair<SpatialiteWriter*, size_t>> m_tables;
+
+    /**
+     * Are features written to the GDAL layers by the thread adding them? Otherwise they are
+     * recorded as FeatureRecord to be queued, spooled or written by the native SpatiaLite writer.
+     */
+    const bool m_write_direct;
+
+    /// serializes access to the datasets if features are written by multiple threads
+    std::mutex m_mutex;
+
+    /**
+     * Queues of features to be written by separate threads. There is one queue for all layers in
+     * asynchronous mode (Options::async_writer) and one queue per layer if Options::parallel_layers
+     * is set. Otherwise, features are written by the thread adding them.
+     */
+    std::vector<std::unique_ptr<FeatureQueue>> m_queues;
+
+    /// Hilbert curve covering the extent of the output coordinate system
+    HilbertCurve m_curve;
+
+    /**
+     * Spools buffering the features of each layer until they are written sorted by
+     * their Hilbert index (only if Options::hilbert_sort is set), the index is the ID
+     * of the layer
+     */
+    std::vector<std::unique_ptr<FeatureSpool>> m_spools;
+
     const std::vector<std::string> GDAL_DEFAULT_OPTIONS;
 
     /// maximum length of a string field
@@ -80,23 +212,105 @@ private:
      */
     static std::vector<std::string> get_gdal_default_layer_options(std::string& output_format);
 
+    /**
+     * Write a feature to its layer. The caller has to ensure that no other thread accesses the datasets.
+     */
+    void write_record(FeatureRecord& record);
+
+    static void write_to_layer(gdalcpp::Layer& layer, FeatureRecord& record);
+
+    static void write_to_spatialite(SpatialiteWriter& file, size_t table_id, FeatureRecord& record);
+
+    /**
+     * Write a feature or add it to the queue of its layer.
+     */
+    void add_record(std::unique_ptr<FeatureRecord>&& record);
+
+    /**
+     * Write the features of all spools sorted by their Hilbert index.
+     */
+    void write_spooled_features();
+
+    /**
+     * Get the queue a feature of a layer has to be added to, nullptr if features are not queued.
+     */
+    FeatureQueue* queue(size_t layer_id);
+
+    /**
+     * Stop the writer threads and close all datasets.
+     *
+     * \returns names of the closed files
+     */
+    std::vector<std::string> close_datasets();
+
+    /**
+     * Close all datasets and build the spatial indexes of an SQLite output file.
+     */
+    void build_spatial_index(const std::string& filename);
+
+    /**
+     * Stop the writer threads, close all datasets and merge the per-layer files into one
+     * SQLite file (Options::parallel_layers only).
+     *
+     * \returns name of the merged file
+     */
+    std::string merge_layer_files();
+
 public:
     OGRWriter() = delete;
 
     OGRWriter(Options& options, osmium::util::VerboseOutput& verbose_output);
 
+    ~OGRWriter();
+
     void rename_output_files(const std::string& view_name);
 
     /**
-     * Add a new dataset to the vector if the last one cannot be use for multiple layers
+     * Add a new dataset to the vector if the last one cannot be use for multiple layers or
+     * each layer is written to its own file.
      */
     void ensure_writeable_dataset(const char* layer_name);
 
-    //TODO check if it is better to keep a vector of layers and return a reference only
-    gdalcpp::Layer create_layer(const char* layer_name, OGRwkbGeometryType type);
+    /**
+     * Create a new layer. The layer is owned by this class.
+     */
+    OutputLayer create_layer(const char* layer_name, OGRwkbGeometryType type);
+
+    std::unique_ptr<OutputLayer> create_layer_ptr(const char* layer_name, OGRwkbGeometryType type);
+
+    /**
+     * Add a field to a layer. This method must not be called after the first feature has been added
+     * to the layer.
+     */
+    void add_field(size_t layer_id, const char* field_name, OGRFieldType type, int width, int precision);
+
+    /**
+     * Does the writer prefer geometries as WKB instead of OGR geometries? This is the case
+     * if features are recorded.
+     */
+    bool accepts_wkb() const noexcept;
 
-    //TODO check if it is better to keep a vector of layers and return a pointer on stack only
-    std::unique_ptr<gdalcpp::Layer> create_layer_ptr(const char* layer_name, OGRwkbGeometryType type);
+    /**
+     * Get the GDAL layer if features are written to it directly, nullptr if features are recorded.
+     *
+     * This method must not be called while layers are created.
+     */
+    gdalcpp::Layer* direct_layer(size_t layer_id) noexcept;
+
+    /**
+     * Add a feature to its layer. In asynchronous mode, the feature is queued and this method
+     * blocks only if the queue is full.
+     *
+     * This method can be called by multiple threads at the same time.
+     */
+    void add_feature(OutputFeature& feature);
+
+    /**
+     * Wait until all queued features have been written.
+     *
+     * Exceptions thrown by the writer thread are rethrown.
+     */
+    void flush();
 };
 
 #endif /* SRC_OGR_WRITER_HPP_ */
@@ -13,6 +13,42 @@ struct Options {
     std::string output_format = "SQlite";
     std::string output_directory = "";
     bool verbose = false;
+    /// run the checks of pass 3 during pass 2 (input has to be sorted by type and ID)
+    bool fold_pass3 = false;
+    /// use an index of the blobs of the input file to read only the blobs required by each pass
+    bool blob_index = false;
+    /// store only the locations of nodes referenced by ways whose geometry is built
+    bool selective_location_index = false;
+    /// add node locations only to ways whose geometry is built
+    bool filter_way_locations = false;
+    /// file to read node locations from or to write them to, empty if no location store is used
+    std::string location_store = "";
+    /// back the location index with transparent huge pages
+    bool huge_pages = false;
+    /// maximum memory usage of the location index if its type is selected automatically, 0 means physical memory
+    uint64_t memory_budget = 0;
+    /// number of threads validating routes, 1 means that routes are validated by the reading thread
+    unsigned int threads = 1;
+    /// write features by a separate thread
+    bool async_writer = false;
+    /// number of features written per transaction
+    int transaction_size = 10000;
+    /// write SpatiaLite output with the SQLite C API instead of GDAL
+    bool native_spatialite = false;
+    /// write each layer to its own SQLite file by its own thread and merge the files at the end
+    bool parallel_layers = false;
+    /// build the spatial indexes after all features have been written (output format SQlite only)
+    bool build_spatial_index = false;
+    /// buffer the features of each layer and write them sorted by the Hilbert index of their bounding box
+    bool hilbert_sort = false;
+    /// use integer columns for IDs and date/time columns for timestamps instead of strings
+    bool typed_schema = false;
+    /// maximum number of way geometries cached for routes sharing ways, 0 disables the cache
+    size_t way_cache_size = 100000;
+    /// write the geometries of route ways once to route_ways and the members of routes to route_members
+    bool normalized_routes = false;
+    /// write one error line per way, node and error with the IDs of all relations reporting it
+    bool aggregate_errors = false;
     bool crossings = true;
     bool platforms = true;
     bool points = true;
@@ -5,9 +5,14 @@
  *      Author: Michael Reichert <michael.reichert@geofabrik.de>
  */
 
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <string>
 #include <iostream>
 #include <getopt.h>
+#include <unistd.h>
+#include <strings.h>
 
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/multipolygon_collector.hpp>
@@ -16,19 +21,27 @@
 #include <osmium/index/map/sparse_mmap_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
-#include <osmium/handler/node_locations_for_ways.hpp>
+#include "block_delta_map.hpp"
+#include <osmium/handler/check_order.hpp>
 #include <osmium/io/any_input.hpp>
 #include <osmium/relations/manager_util.hpp>
 #include <osmium/visitor.hpp>
 
+#include "filtered_location_handler.hpp"
+#include "huge_pages.hpp"
+#include "location_index_selector.hpp"
+#include "location_store.hpp"
+#include "needed_nodes_handler.hpp"
 #include "ogr_writer.hpp"
+#include "pbf_blob_index.hpp"
 #include "railway_handler_pass1.hpp"
 #include "railway_handler_pass2.hpp"
 #include "route_manager.hpp"
+#include "selective_location_index.hpp"
 #include "turn_restriction_handler.hpp"
 
 using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
-using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+using location_handler_type = FilteredNodeLocationsForWays<index_type>;
 
 void print_help(char* arg0) {
     std::cerr << "Usage: " << arg0 << " [OPTIONS] INFILE OUTPUT_DIRECTORY\n" \
@@ -36,16 +49,63 @@ void print_help(char* arg0) {
               << "  -h, --help           This help message.\n" \
               << "  -f, --format         Output format (default: SQlite)\n" \
               << "  -i, --index          Set index type for location index (default: sparse_mem_array)\n" \
+              << "                       sparse_delta_mem_array needs less memory than\n" \
+              << "                       sparse_mem_array if the input is sorted by ID.\n" \
+              << "                       auto selects the fastest type which fits into the memory\n" \
+              << "                       budget. PBF input files are sampled using a blob index\n" \
+              << "                       which is only written to disk with --blob-index.\n" \
+              << "                       Not available if reading from STDIN.\n" \
+              << "  --memory-budget SIZE Maximum memory usage of the location index for --index auto,\n" \
+              << "                       e.g. 12G or 800M (default: 3/4 of the physical memory)\n" \
+              << "  -t, --threads N      Number of threads validating routes (default: 1)\n" \
               << "  -v, --verbose        Verbose output\n" \
+              << "  --location-store FILE  Read node locations from FILE if it has been written\n" \
+              << "                       for the same input file, write them to FILE otherwise.\n" \
+              << "                       Multiple processes can read the same FILE at the same time.\n" \
+              << "                       Not available if reading from STDIN.\n" \
+              << "  --async-writer       Write output features by a separate thread.\n" \
+              << "  --transaction-size N Number of features written per transaction (default: 10000)\n" \
+              << "  --native-spatialite  Write SpatiaLite output with SQLite directly instead of GDAL\n" \
+              << "                       (output format SQlite only).\n" \
+              << "  --build-spatial-index  Build spatial indexes after all features have been\n" \
+              << "                       written (output format SQlite only).\n" \
+              << "  --hilbert-sort       Buffer the features of each layer in a temporary file and\n" \
+              << "                       write them sorted by the Hilbert index of their bounding\n" \
+              << "                       box at the end.\n" \
+              << "  --typed-schema       Write IDs as 64-bit integers and timestamps as date/time\n" \
+              << "                       values instead of strings.\n" \
+              << "  --parallel-layers    Write each layer to its own file by its own thread and\n" \
+              << "                       merge the files at the end (output format SQlite only).\n" \
+              << "  --way-cache-size N   Number of way geometries cached for ways shared by\n" \
+              << "                       multiple routes, 0 disables the cache (default: 100000)\n" \
+              << "  --huge-pages         Ask for transparent huge pages for the location index\n" \
+              << "                       (*_mem_array and *_mmap_array only). Works best with\n" \
+              << "                       --index auto which reserves the estimated size up front.\n" \
+              << "  --filter-way-locations  Add node locations only to ways whose geometry is\n" \
+              << "                       built (route members, platforms and stations).\n" \
+              << "  --selective-index    Store only the locations of nodes referenced by route\n" \
+              << "                       members, platforms and stations. This requires an\n" \
+              << "                       additional read of all ways. -i/--index is ignored.\n" \
+              << "  --blob-index         Use an index of the blobs of the input file (PBF only) to\n" \
+              << "                       skip blobs which are not needed by a pass. The index is\n" \
+              << "                       written to INFILE.blobidx and reused by later runs.\n" \
+              << "  --fold-pass3         Run the checks of pass 3 during pass 2. This avoids\n" \
+              << "                       reading the input file a third time but requires\n" \
+              << "                       the input file to be sorted by type and ID.\n" \
               << "\n" \
               << "Content Related Options:\n" \
               << "--no-crossings        Don't write the crossings layer.\n" \
               << "--no-platforms        Don't write the platforms layer.\n" \
               << "--no-points           Don't write a layer of points (railway=switch).\n" \
               << "--no-railway-details  Don't check if signals, buffer stops, milestones etc.\n" \
+              << "                      are mapped on the way which represents the track.\n" \
               << "--no-stations         Don't write the stations layer.\n" \
               << "--no-stops            Don't write the stops layer.\n" \
-              << "                      are mapped on the way which represents the track.\n";
+              << "--normalized-routes   Write the geometry of each route way once to route_ways and\n" \
+              << "                      the member ways of routes to route_members. The routes\n" \
+              << "                      layers have no geometry then.\n" \
+              << "--aggregate-errors    Write one error line per way and error with the number and\n" \
+              << "                      IDs of all route relations reporting it.\n";
 #ifdef MERCATOR_OUTPUT
     std::cerr << "Output is written in Web Mercator projection (EPSG:3857).\n";
 #else
@@ -61,25 +121,60 @@ int main(int argc, char* argv[]) {
     const int NO_RAILWAY_DETAILS = 1003;
     const int NO_STOPS = 1004;
     const int NO_STATIONS = 1005;
+    const int FOLD_PASS3 = 1006;
+    const int BLOB_INDEX = 1007;
+    const int SELECTIVE_INDEX = 1008;
+    const int FILTER_WAY_LOCATIONS = 1009;
+    const int LOCATION_STORE = 1010;
+    const int HUGE_PAGES = 1011;
+    const int MEMORY_BUDGET = 1012;
+    const int ASYNC_WRITER = 1013;
+    const int TRANSACTION_SIZE = 1014;
+    const int NATIVE_SPATIALITE = 1015;
+    const int PARALLEL_LAYERS = 1016;
+    const int BUILD_SPATIAL_INDEX = 1017;
+    const int HILBERT_SORT = 1018;
+    const int TYPED_SCHEMA = 1019;
+    const int WAY_CACHE_SIZE = 1020;
+    const int NORMALIZED_ROUTES = 1021;
+    const int AGGREGATE_ERRORS = 1022;
 
     static struct option long_options[] = {
+        {"aggregate-errors",   no_argument, 0, AGGREGATE_ERRORS},
+        {"async-writer",   no_argument, 0, ASYNC_WRITER},
+        {"blob-index",   no_argument, 0, BLOB_INDEX},
+        {"build-spatial-index",   no_argument, 0, BUILD_SPATIAL_INDEX},
         {"no-crossings",   no_argument, 0, NO_CROSSINGS},
         {"help",   no_argument, 0, 'h'},
+        {"filter-way-locations",   no_argument, 0, FILTER_WAY_LOCATIONS},
+        {"fold-pass3",   no_argument, 0, FOLD_PASS3},
         {"format", required_argument, 0, 'f'},
+        {"hilbert-sort",   no_argument, 0, HILBERT_SORT},
+        {"huge-pages",   no_argument, 0, HUGE_PAGES},
         {"index", required_argument, 0, 'i'},
+        {"location-store", required_argument, 0, LOCATION_STORE},
+        {"memory-budget", required_argument, 0, MEMORY_BUDGET},
+        {"native-spatialite",   no_argument, 0, NATIVE_SPATIALITE},
         {"no-platforms",   no_argument, 0, NO_PLATFORMS},
         {"no-points",   no_argument, 0, NO_POINTS},
         {"no-railway-details",   no_argument, 0, NO_RAILWAY_DETAILS},
         {"no-stations",   no_argument, 0, NO_STATIONS},
         {"no-stops",   no_argument, 0, NO_STOPS},
+        {"normalized-routes",   no_argument, 0, NORMALIZED_ROUTES},
+        {"parallel-layers",   no_argument, 0, PARALLEL_LAYERS},
+        {"selective-index",   no_argument, 0, SELECTIVE_INDEX},
+        {"threads", required_argument, 0, 't'},
+        {"transaction-size", required_argument, 0, TRANSACTION_SIZE},
+        {"typed-schema",   no_argument, 0, TYPED_SCHEMA},
         {"verbose",   no_argument, 0, 'v'},
+        {"way-cache-size", required_argument, 0, WAY_CACHE_SIZE},
         {0, 0, 0, 0}
     };
 
     Options options;
 
     while (true) {
-        int c = getopt_long(argc, argv, "hf:i:v", long_options, 0);
+        int c = getopt_long(argc, argv, "hf:i:t:v", long_options, 0);
         if (c == -1) {
             break;
         }
@@ -104,6 +199,14 @@ int main(int argc, char* argv[]) {
                     exit(1);
                 }
                 break;
+            case 't':
+                if (optarg && atoi(optarg) > 0) {
+                    options.threads = static_cast<unsigned int>(atoi(optarg));
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
             case NO_CROSSINGS:
                 options.crossings = false;
                 break;
@@ -122,6 +225,76 @@ int main(int argc, char* argv[]) {
             case NO_STATIONS:
                 options.stations = false;
                 break;
+            case FOLD_PASS3:
+                options.fold_pass3 = true;
+                break;
+            case BLOB_INDEX:
+                options.blob_index = true;
+                break;
+            case SELECTIVE_INDEX:
+                options.selective_location_index = true;
+                break;
+            case FILTER_WAY_LOCATIONS:
+                options.filter_way_locations = true;
+                break;
+            case LOCATION_STORE:
+                options.location_store = optarg;
+                break;
+            case HUGE_PAGES:
+                options.huge_pages = true;
+                break;
+            case ASYNC_WRITER:
+                options.async_writer = true;
+                break;
+            case NATIVE_SPATIALITE:
+                options.native_spatialite = true;
+                break;
+            case BUILD_SPATIAL_INDEX:
+                options.build_spatial_index = true;
+                break;
+            case TYPED_SCHEMA:
+                options.typed_schema = true;
+                break;
+            case HILBERT_SORT:
+                options.hilbert_sort = true;
+                break;
+            case PARALLEL_LAYERS:
+                options.parallel_layers = true;
+                break;
+            case TRANSACTION_SIZE:
+                if (optarg && atoi(optarg) > 0) {
+                    options.transaction_size = atoi(optarg);
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
+            case AGGREGATE_ERRORS:
+                options.aggregate_errors = true;
+                break;
+            case NORMALIZED_ROUTES:
+                options.normalized_routes = true;
+                break;
+            case WAY_CACHE_SIZE: {
+                char* end = nullptr;
+                errno = 0;
+                const unsigned long size = optarg && isdigit(static_cast<unsigned char>(optarg[0])) ? strtoul(optarg, &end, 10) : 0;
+                if (!end || *end != '\0' || errno == ERANGE) {
+                    std::cerr << "ERROR: Invalid way cache size " << (optarg ? optarg : "") << '\n';
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                options.way_cache_size = size;
+                break;
+            }
+            case MEMORY_BUDGET:
+                try {
+                    options.memory_budget = LocationIndexSelector::parse_memory_size(optarg);
+                } catch (const std::logic_error& err) {
+                    std::cerr << "ERROR: " << err.what() << '\n';
+                    exit(1);
+                }
+                break;
             case 'v':
                 options.verbose = true;
                 break;
@@ -141,6 +314,32 @@ int main(int argc, char* argv[]) {
     } else {
         input_filename = "-";
     }
+    if (options.location_index_type == "auto" && input_filename == "-") {
+        std::cerr << "ERROR: --index auto cannot be used if reading from STDIN.\n";
+        print_help(argv[0]);
+        exit(1);
+    }
+    if (!options.location_store.empty() && input_filename == "-") {
+        std::cerr << "ERROR: --location-store cannot be used if reading from STDIN.\n";
+        print_help(argv[0]);
+        exit(1);
+    }
+    if (options.memory_budget != 0 && options.location_index_type != "auto") {
+        std::cerr << "ERROR: --memory-budget requires --index auto.\n";
+        exit(1);
+    }
+    if (options.native_spatialite && strcasecmp(options.output_format.c_str(), "SQlite") != 0) {
+        std::cerr << "ERROR: --native-spatialite requires output format SQlite.\n";
+        exit(1);
+    }
+    if (options.parallel_layers && strcasecmp(options.output_format.c_str(), "SQlite") != 0) {
+        std::cerr << "ERROR: --parallel-layers requires output format SQlite.\n";
+        exit(1);
+    }
+    if (options.build_spatial_index && strcasecmp(options.output_format.c_str(), "SQlite") != 0) {
+        std::cerr << "ERROR: --build-spatial-index requires output format SQlite.\n";
+        exit(1);
+    }
 
     const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
 
@@ -148,29 +347,125 @@ int main(int argc, char* argv[]) {
     OGRWriter writer {options, verbose_output};
     RouteManager route_manager(writer, options, verbose_output);
 
+    const bool auto_index = options.location_index_type == "auto";
+    // estimated number of entries of the location index, 0 if unknown
+    uint64_t expected_index_size = 0;
+    std::unique_ptr<PBFBlobIndex> blob_index;
+    if (options.blob_index || auto_index) {
+        // --index auto uses the blob index if possible but works without it.
+        blob_index = PBFBlobIndex::open(input_filename, verbose_output, options.blob_index);
+    }
+    if (auto_index) {
+        LocationIndexSelector selector(input_filename, blob_index.get(), verbose_output);
+        options.location_index_type = selector.select(options.memory_budget, options.output_directory);
+        expected_index_size = selector.expected_size(options.location_index_type);
+        if (!options.blob_index) {
+            // The blob index was only needed to sample the input file.
+            blob_index.reset();
+        }
+    }
+
     {
         verbose_output << "Pass 1 (reading route relations) ...";
-        osmium::io::File input_file(input_filename);
-        osmium::relations::read_relations(input_file, route_manager);
+        if (blob_index) {
+            BlobRangeInput relations_input(input_filename, blob_index->header_size(),
+                    blob_index->range(osmium::osm_entity_bits::relation));
+            osmium::relations::read_relations(relations_input.file(), route_manager);
+            relations_input.close();
+        } else {
+            osmium::io::File input_file(input_filename);
+            osmium::relations::read_relations(input_file, route_manager);
+        }
         verbose_output << " done\n";
     }
 
+    // decides which ways need the locations of their nodes (available after pass 1)
+    WayGeometryFilter way_filter(route_manager.member_way_ids(), options);
+
+    // A location store written for the same input file replaces building the location index.
+    std::unique_ptr<LocationStoreIndex> stored_locations;
+    std::unique_ptr<LocationStoreWriter> location_store_writer;
+    if (!options.location_store.empty()) {
+        const LocationStoreIdentity identity = LocationStoreIdentity::of(input_filename);
+        stored_locations = LocationStoreIndex::open(options.location_store, identity);
+        if (stored_locations) {
+            verbose_output << "Reading " << stored_locations->size() << " node locations from location store "
+                    << options.location_store << "\n";
+        } else {
+            location_store_writer.reset(new LocationStoreWriter(options.location_store, identity));
+        }
+    }
+
+    // IDs of all nodes whose locations are required if only a selection of all locations is stored
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> needed_nodes;
+    if (options.selective_location_index && !stored_locations) {
+        verbose_output << "Pass 1b (collecting nodes of route members, platforms and stations) ...";
+        NeededNodesHandler needed_nodes_handler(way_filter, needed_nodes);
+        if (blob_index) {
+            BlobRangeInput ways_input(input_filename, blob_index->header_size(), blob_index->range(osmium::osm_entity_bits::way));
+            osmium::io::Reader ways_reader(ways_input.file(), osmium::osm_entity_bits::way);
+            osmium::apply(ways_reader, needed_nodes_handler);
+            ways_reader.close();
+            ways_input.close();
+        } else {
+            osmium::io::Reader ways_reader(input_filename, osmium::osm_entity_bits::way);
+            osmium::apply(ways_reader, needed_nodes_handler);
+            ways_reader.close();
+        }
+        verbose_output << " done, " << needed_nodes.size() << " nodes needed\n";
+    }
+
     osmium::index::IdSetDense<osmium::unsigned_object_id_type> point_node_members;
 
     // This ItemStash collects the IDs of all nodes which are expected to be reference by a way because their tags require it.
     // Examples: points, signals, stop positions
     osmium::ItemStash must_on_track;
     std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type> must_on_track_handles;
+    RailwayHandlerPass2 railway_handler2(writer, point_node_members, must_on_track_handles, must_on_track, options, verbose_output);
     {
-        auto location_index = map_factory.create_map(options.location_index_type);
-        location_handler_type location_handler(*location_index);
+        std::unique_ptr<index_type> location_index;
+        const bool locations_from_store = static_cast<bool>(stored_locations);
+        if (locations_from_store) {
+            location_index = std::move(stored_locations);
+        } else if (options.selective_location_index) {
+            location_index.reset(new SelectiveLocationIndex(needed_nodes));
+        } else {
+            location_index = map_factory.create_map(options.location_index_type);
+            const size_t comma = options.location_index_type.find(',');
+            if (auto_index && comma != std::string::npos) {
+                // The index file has been created by the automatic selection and is not needed after this run.
+                ::unlink(options.location_index_type.substr(comma + 1).c_str());
+            }
+        }
+        location_handler_type location_handler(*location_index, options.filter_way_locations ? &way_filter : nullptr);
         location_handler.ignore_errors();
+        if (locations_from_store) {
+            location_handler.skip_nodes();
+        }
+        location_handler.store_locations_to(location_store_writer.get());
+        std::unique_ptr<HugePageAdvisor> huge_page_advisor;
+        if (options.huge_pages && !locations_from_store) {
+            huge_page_advisor.reset(new HugePageAdvisor(*location_index, expected_index_size));
+            location_handler.advise_huge_pages(huge_page_advisor.get());
+        }
         RailwayHandlerPass1 railway_handler1(writer, options, verbose_output, must_on_track, must_on_track_handles);
+        TurnRestrictionHandler tr_handler(point_node_members);
 
         verbose_output << "Pass 2 ...";
         osmium::io::Reader reader1(input_filename);
-        if (options.points) {
-            TurnRestrictionHandler tr_handler(point_node_members);
+        if (options.fold_pass3) {
+            // Points are written after the turn restrictions have been read because the
+            // via members of the turn restrictions are required to classify them.
+            railway_handler2.defer_points();
+            osmium::handler::CheckOrder check_order;
+            if (options.points) {
+                osmium::apply(reader1, check_order, location_handler, railway_handler1, railway_handler2, tr_handler,
+                        route_manager.handler());
+            } else {
+                osmium::apply(reader1, check_order, location_handler, railway_handler1, railway_handler2,
+                        route_manager.handler());
+            }
+        } else if (options.points) {
             osmium::apply(reader1, location_handler, railway_handler1, tr_handler, route_manager.handler());
         } else {
             osmium::apply(reader1, location_handler, railway_handler1, route_manager.handler());
@@ -178,19 +473,44 @@ int main(int argc, char* argv[]) {
         route_manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
             route_manager.process_route(*handle);
         });
+        route_manager.finish();
         verbose_output << " done\n";
 
         reader1.close();
     }
 
-    RailwayHandlerPass2 railway_handler2(writer, point_node_members, must_on_track_handles, must_on_track, options, verbose_output);
-    verbose_output << "Pass 3 ...";
-    osmium::io::Reader reader2(input_filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
-    osmium::apply(reader2, railway_handler2);
+    if (location_store_writer) {
+        verbose_output << "Writing location store " << options.location_store << " ...";
+        if (location_store_writer->commit()) {
+            verbose_output << " done\n";
+        } else {
+            verbose_output << " failed\n";
+            std::cerr << "WARNING: Location store " << options.location_store << " could not be written.\n";
+        }
+        location_store_writer.reset();
+    }
+
+    if (options.fold_pass3) {
+        railway_handler2.write_deferred_points();
+    } else {
+        verbose_output << "Pass 3 ...";
+        const osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::node | osmium::osm_entity_bits::way;
+        if (blob_index) {
+            BlobRangeInput nodes_ways_input(input_filename, blob_index->header_size(), blob_index->range(read_types));
+            osmium::io::Reader reader2(nodes_ways_input.file(), read_types);
+            osmium::apply(reader2, railway_handler2);
+            reader2.close();
+            nodes_ways_input.close();
+        } else {
+            osmium::io::Reader reader2(input_filename, read_types);
+            osmium::apply(reader2, railway_handler2);
+            reader2.close();
+        }
+        verbose_output << " done\n";
+    }
     railway_handler2.after_ways();
     must_on_track.clear();
     must_on_track.garbage_collect();
     writer.rename_output_files("pubtrans");
-    verbose_output << " done\n";
     verbose_output << "wrote output to " << options.output_directory << "\n";
 }
@@ -0,0 +1,547 @@
+/*
+ * pbf_blob_index.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "pbf_blob_index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+    /// maximum size of a BlobHeader according to the PBF specification
+    constexpr uint32_t max_blob_header_size = 64 * 1024;
+
+    /// maximum size of a Blob according to the PBF specification
+    constexpr uint64_t max_blob_size = 32 * 1024 * 1024;
+
+    /// first line of an index file
+    const char* index_file_magic = "osmi_pubtrans3 blob index 1";
+
+    /// protobuf wire types
+    constexpr uint64_t wire_varint = 0;
+    constexpr uint64_t wire_fixed64 = 1;
+    constexpr uint64_t wire_length_delimited = 2;
+    constexpr uint64_t wire_fixed32 = 5;
+
+    /**
+     * Read exactly size bytes at the given offset.
+     *
+     * \returns number of bytes read (less than size at the end of the file)
+     */
+    size_t read_at(const int fd, char* buffer, const size_t size, uint64_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            const ssize_t result = ::pread(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::system_category(), "Reading input file for blob index failed"};
+            }
+            if (result == 0) {
+                break;
+            }
+            done += static_cast<size_t>(result);
+        }
+        return done;
+    }
+
+    /**
+     * Decode a varint.
+     *
+     * \returns false if the data ends before the end of the varint
+     */
+    bool read_varint(const char*& data, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; data != end && shift < 64; shift += 7) {
+            const uint8_t byte = static_cast<uint8_t>(*data++);
+            value |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+            if (!(byte & 0x80u)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Skip the value of a protobuf field.
+     *
+     * \returns false if the data ends before the end of the field
+     */
+    bool skip_value(const char*& data, const char* end, const uint64_t wire_type) {
+        uint64_t length = 0;
+        switch (wire_type) {
+        case wire_varint:
+            return read_varint(data, end, length);
+        case wire_fixed64:
+            length = 8;
+            break;
+        case wire_length_delimited:
+            if (!read_varint(data, end, length)) {
+                return false;
+            }
+            break;
+        case wire_fixed32:
+            length = 4;
+            break;
+        default:
+            throw std::runtime_error{"Unsupported protobuf wire type in PBF file"};
+        }
+        if (static_cast<uint64_t>(end - data) < length) {
+            return false;
+        }
+        data += length;
+        return true;
+    }
+
+    /**
+     * Determine the types of the objects in all primitive groups of a PrimitiveBlock.
+     *
+     * \returns osmium::osm_entity_bits::all if the block contains objects of different types,
+     * unknown primitive groups or no primitive group at all
+     */
+    osmium::osm_entity_bits::type block_types(const char* data, const char* end) {
+        osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+        while (data != end) {
+            uint64_t key;
+            if (!read_varint(data, end, key)) {
+                throw std::runtime_error{"Invalid PrimitiveBlock in PBF file"};
+            }
+            if (key != ((2 << 3) | wire_length_delimited)) {
+                if (!skip_value(data, end, key & 0x7u)) {
+                    throw std::runtime_error{"Invalid PrimitiveBlock in PBF file"};
+                }
+                continue;
+            }
+            // PrimitiveGroup found, the keys of its fields determine the type
+            uint64_t length;
+            if (!read_varint(data, end, length) || static_cast<uint64_t>(end - data) < length) {
+                throw std::runtime_error{"Invalid PrimitiveGroup in PBF file"};
+            }
+            const char* group_end = data + length;
+            while (data != group_end) {
+                if (!read_varint(data, group_end, key)) {
+                    throw std::runtime_error{"Invalid PrimitiveGroup in PBF file"};
+                }
+                switch (key >> 3) {
+                case 1: // nodes
+                case 2: // dense nodes
+                    types |= osmium::osm_entity_bits::node;
+                    break;
+                case 3:
+                    types |= osmium::osm_entity_bits::way;
+                    break;
+                case 4:
+                    types |= osmium::osm_entity_bits::relation;
+                    break;
+                case 5:
+                    types |= osmium::osm_entity_bits::changeset;
+                    break;
+                default:
+                    return osmium::osm_entity_bits::all;
+                }
+                if (!skip_value(data, group_end, key & 0x7u)) {
+                    throw std::runtime_error{"Invalid PrimitiveGroup in PBF file"};
+                }
+            }
+        }
+        switch (types) {
+        case osmium::osm_entity_bits::node:
+        case osmium::osm_entity_bits::way:
+        case osmium::osm_entity_bits::relation:
+        case osmium::osm_entity_bits::changeset:
+            return types;
+        default:
+            // Mixed blocks must never be skipped.
+            return osmium::osm_entity_bits::all;
+        }
+    }
+
+    struct FileIdentity {
+        uint64_t size;
+        int64_t mtime;
+    };
+
+    FileIdentity file_identity(const std::string& filename) {
+        struct stat file_stat;
+        if (::stat(filename.c_str(), &file_stat)) {
+            throw std::system_error{errno, std::system_category(), "Could not stat " + filename};
+        }
+        return {static_cast<uint64_t>(file_stat.st_size), static_cast<int64_t>(file_stat.st_mtime)};
+    }
+
+} // namespace
+
+PBFBlobIndex::PBFBlobIndex(const std::string& filename) :
+    m_filename(filename),
+    m_entries() {
+}
+
+/*static*/ std::string PBFBlobIndex::index_filename(const std::string& filename) {
+    return filename + ".blobidx";
+}
+
+/*static*/ std::unique_ptr<PBFBlobIndex> PBFBlobIndex::open(const std::string& filename,
+        osmium::util::VerboseOutput& verbose_output, bool requested /* = true */) {
+    std::unique_ptr<PBFBlobIndex> index;
+    if (filename.empty() || filename == "-") {
+        if (requested) {
+            std::cerr << "WARNING: Blob index is not available if reading from STDIN.\n";
+        }
+        return index;
+    }
+    osmium::io::File file {filename};
+    if (file.format() != osmium::io::file_format::pbf || file.compression() != osmium::io::file_compression::none) {
+        if (requested) {
+            std::cerr << "WARNING: Blob index is only available for PBF files.\n";
+        }
+        return index;
+    }
+    index.reset(new PBFBlobIndex(filename));
+    if (!index->load()) {
+        verbose_output << "Building blob index ...";
+        index->build();
+        verbose_output << " done\n";
+        // The directory of the input file is only written to if the user asked for it.
+        if (requested && !index->save()) {
+            verbose_output << "Could not write blob index to " << index_filename(filename) << '\n';
+        }
+    }
+    if (!index->sorted()) {
+        if (requested) {
+            std::cerr << "WARNING: Input file is not sorted by type. Blob index will not be used.\n";
+        }
+        index.reset();
+    }
+    return index;
+}
+
+bool PBFBlobIndex::load() {
+    const FileIdentity identity = file_identity(m_filename);
+    std::ifstream infile {index_filename(m_filename)};
+    if (!infile) {
+        return false;
+    }
+    std::string magic;
+    std::getline(infile, magic);
+    if (magic != index_file_magic) {
+        return false;
+    }
+    infile >> m_file_size >> m_file_mtime;
+    if (!infile || m_file_size != identity.size || m_file_mtime != identity.mtime) {
+        return false;
+    }
+    m_entries.clear();
+    uint64_t offset;
+    uint64_t size;
+    int type;
+    while (infile >> offset >> size >> type) {
+        m_entries.emplace_back(offset, size, static_cast<osmium::osm_entity_bits::type>(type));
+    }
+    if (!infile.eof() || m_entries.empty()) {
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PBFBlobIndex::save() const {
+    // Write to a temporary file first to avoid that concurrent runs read incomplete indexes.
+    const std::string destination = index_filename(m_filename);
+    std::string temp_filename = destination;
+    temp_filename += ".tmp.";
+    temp_filename += std::to_string(::getpid());
+    {
+        std::ofstream outfile {temp_filename};
+        if (!outfile) {
+            return false;
+        }
+        outfile << index_file_magic << '\n' << m_file_size << ' ' << m_file_mtime << '\n';
+        for (const BlobIndexEntry& entry : m_entries) {
+            outfile << entry.offset << ' ' << entry.size << ' ' << static_cast<int>(entry.type) << '\n';
+        }
+        if (!outfile) {
+            ::unlink(temp_filename.c_str());
+            return false;
+        }
+    }
+    if (::rename(temp_filename.c_str(), destination.c_str())) {
+        ::unlink(temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+void PBFBlobIndex::build() {
+    const FileIdentity identity = file_identity(m_filename);
+    m_file_size = identity.size;
+    m_file_mtime = identity.mtime;
+    m_entries.clear();
+    const int fd = ::open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error{errno, std::system_category(), "Could not open " + m_filename};
+    }
+    std::vector<char> header_buffer(max_blob_header_size);
+    uint64_t offset = 0;
+    try {
+        while (offset < m_file_size) {
+            // length of the BlobHeader as 4 byte big endian integer
+            unsigned char size_buffer[4];
+            if (read_at(fd, reinterpret_cast<char*>(size_buffer), 4, offset) != 4) {
+                throw std::runtime_error{"Unexpected end of PBF file while building blob index"};
+            }
+            const uint32_t header_size = (static_cast<uint32_t>(size_buffer[0]) << 24)
+                    | (static_cast<uint32_t>(size_buffer[1]) << 16)
+                    | (static_cast<uint32_t>(size_buffer[2]) << 8)
+                    | static_cast<uint32_t>(size_buffer[3]);
+            if (header_size > max_blob_header_size
+                    || read_at(fd, header_buffer.data(), header_size, offset + 4) != header_size) {
+                throw std::runtime_error{"Invalid BlobHeader in PBF file"};
+            }
+            // parse BlobHeader
+            std::string blob_type;
+            uint64_t blob_size = 0;
+            const char* data = header_buffer.data();
+            const char* end = data + header_size;
+            while (data != end) {
+                uint64_t key;
+                if (!read_varint(data, end, key)) {
+                    throw std::runtime_error{"Invalid BlobHeader in PBF file"};
+                }
+                if (key == ((1 << 3) | wire_length_delimited)) {
+                    uint64_t length;
+                    if (!read_varint(data, end, length) || static_cast<uint64_t>(end - data) < length) {
+                        throw std::runtime_error{"Invalid BlobHeader in PBF file"};
+                    }
+                    blob_type.assign(data, length);
+                    data += length;
+                } else if (key == ((3 << 3) | wire_varint)) {
+                    if (!read_varint(data, end, blob_size)) {
+                        throw std::runtime_error{"Invalid BlobHeader in PBF file"};
+                    }
+                } else if (!skip_value(data, end, key & 0x7u)) {
+                    throw std::runtime_error{"Invalid BlobHeader in PBF file"};
+                }
+            }
+            if (blob_size > max_blob_size) {
+                throw std::runtime_error{"Blob in PBF file is too large"};
+            }
+            const uint64_t blob_offset = offset + 4 + header_size;
+            osmium::osm_entity_bits::type type = osmium::osm_entity_bits::nothing;
+            if (blob_type == "OSMData") {
+                type = read_blob_type(fd, blob_offset, blob_size);
+            } else if (blob_type != "OSMHeader") {
+                throw std::runtime_error{"Unknown blob type in PBF file: " + blob_type};
+            }
+            m_entries.emplace_back(offset, 4 + header_size + blob_size, type);
+            offset = blob_offset + blob_size;
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+/*static*/ osmium::osm_entity_bits::type PBFBlobIndex::read_blob_type(const int fd, const uint64_t offset, const uint64_t size) {
+    std::string blob(size, '\0');
+    if (read_at(fd, &blob[0], size, offset) != size) {
+        throw std::runtime_error{"Unexpected end of PBF file while building blob index"};
+    }
+    const char* data = blob.data();
+    const char* end = data + blob.size();
+    const char* raw_data = nullptr;
+    const char* zlib_data = nullptr;
+    uint64_t data_length = 0;
+    uint64_t raw_size = 0;
+    while (data != end) {
+        uint64_t key;
+        if (!read_varint(data, end, key)) {
+            throw std::runtime_error{"Invalid Blob in PBF file"};
+        }
+        if (key == ((1 << 3) | wire_length_delimited) || key == ((3 << 3) | wire_length_delimited)) {
+            if (!read_varint(data, end, data_length) || static_cast<uint64_t>(end - data) < data_length) {
+                throw std::runtime_error{"Invalid Blob in PBF file"};
+            }
+            ((key >> 3) == 1 ? raw_data : zlib_data) = data;
+            data += data_length;
+        } else if (key == ((2 << 3) | wire_varint)) {
+            if (!read_varint(data, end, raw_size)) {
+                throw std::runtime_error{"Invalid Blob in PBF file"};
+            }
+        } else if (!skip_value(data, end, key & 0x7u)) {
+            throw std::runtime_error{"Invalid Blob in PBF file"};
+        }
+    }
+    if (raw_data) {
+        return block_types(raw_data, raw_data + data_length);
+    }
+    if (!zlib_data) {
+        // other compression types are not supported by the index
+        return osmium::osm_entity_bits::all;
+    }
+    if (raw_size > max_blob_size) {
+        throw std::runtime_error{"Blob in PBF file is too large"};
+    }
+    std::string block(raw_size, '\0');
+    uLongf block_size = static_cast<uLongf>(raw_size);
+    if (::uncompress(reinterpret_cast<Bytef*>(&block[0]), &block_size, reinterpret_cast<const Bytef*>(zlib_data),
+            static_cast<uLong>(data_length)) != Z_OK || block_size != raw_size) {
+        throw std::runtime_error{"Failed to decompress blob in PBF file"};
+    }
+    return block_types(block.data(), block.data() + block.size());
+}
+
+bool PBFBlobIndex::sorted() const {
+    int previous = osmium::osm_entity_bits::nothing;
+    for (const BlobIndexEntry& entry : m_entries) {
+        if (entry.type == osmium::osm_entity_bits::nothing) {
+            // OSMHeader
+            continue;
+        }
+        if (entry.type != osmium::osm_entity_bits::node && entry.type != osmium::osm_entity_bits::way
+                && entry.type != osmium::osm_entity_bits::relation) {
+            return false;
+        }
+        if (entry.type < previous) {
+            return false;
+        }
+        previous = entry.type;
+    }
+    return true;
+}
+
+uint64_t PBFBlobIndex::header_size() const {
+    if (m_entries.empty() || m_entries.front().type != osmium::osm_entity_bits::nothing) {
+        throw std::runtime_error{"PBF file does not start with an OSMHeader blob"};
+    }
+    return m_entries.front().size;
+}
+
+std::pair<uint64_t, uint64_t> PBFBlobIndex::range(osmium::osm_entity_bits::type types) const {
+    std::pair<uint64_t, uint64_t> result {0, 0};
+    bool found = false;
+    for (const BlobIndexEntry& entry : m_entries) {
+        if ((entry.type & types) == osmium::osm_entity_bits::nothing) {
+            continue;
+        }
+        if (!found) {
+            result.first = entry.offset;
+            found = true;
+        }
+        result.second = entry.offset + entry.size;
+    }
+    return result;
+}
+
+const std::vector<BlobIndexEntry>& PBFBlobIndex::entries() const {
+    return m_entries;
+}
+
+
+BlobRangeInput::BlobRangeInput(const std::string& filename, uint64_t header_size, std::pair<uint64_t, uint64_t> range) {
+    m_input_fd = ::open(filename.c_str(), O_RDONLY);
+    if (m_input_fd < 0) {
+        throw std::system_error{errno, std::system_category(), "Could not open " + filename};
+    }
+    if (::pipe(m_pipe)) {
+        ::close(m_input_fd);
+        throw std::system_error{errno, std::system_category(), "Could not create pipe"};
+    }
+#ifdef F_SETPIPE_SZ
+    // A larger pipe buffer reduces the number of context switches. Failures are not critical.
+    ::fcntl(m_pipe[1], F_SETPIPE_SZ, 1024 * 1024);
+#endif
+    m_thread = std::thread(&BlobRangeInput::copy_ranges, this, header_size, range);
+}
+
+BlobRangeInput::~BlobRangeInput() {
+    stop();
+    ::close(m_input_fd);
+}
+
+void BlobRangeInput::stop() {
+    // Closing the read end causes the writing thread to stop if the reader did not read everything.
+    if (m_pipe[0] >= 0) {
+        ::close(m_pipe[0]);
+        m_pipe[0] = -1;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void BlobRangeInput::close() {
+    stop();
+    if (m_error) {
+        std::rethrow_exception(m_error);
+    }
+}
+
+osmium::io::File BlobRangeInput::file() const {
+    std::string filename = "/dev/fd/";
+    filename += std::to_string(m_pipe[0]);
+    return osmium::io::File{filename, "pbf"};
+}
+
+void BlobRangeInput::copy_ranges(uint64_t header_size, std::pair<uint64_t, uint64_t> range) {
+    // Writing to a pipe without readers should fail with EPIPE instead of killing the programme.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    if (copy_range(0, header_size)) {
+        copy_range(range.first, range.second);
+    }
+    ::close(m_pipe[1]);
+}
+
+bool BlobRangeInput::copy_range(uint64_t begin, uint64_t end) {
+    std::vector<char> buffer(1024 * 1024);
+    while (begin < end) {
+        const size_t chunk = std::min<uint64_t>(buffer.size(), end - begin);
+        const ssize_t length = ::pread(m_input_fd, buffer.data(), chunk, static_cast<off_t>(begin));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length < 0) {
+            // The reader cannot tell an incomplete file from a complete one, close() reports it.
+            const int error = errno;
+            m_error = std::make_exception_ptr(std::system_error{error, std::system_category(), "Reading input file failed"});
+            return false;
+        }
+        if (length == 0) {
+            m_error = std::make_exception_ptr(std::runtime_error{"Unexpected end of input file"});
+            return false;
+        }
+        size_t written = 0;
+        while (written < static_cast<size_t>(length)) {
+            const ssize_t result = ::write(m_pipe[1], buffer.data() + written, static_cast<size_t>(length) - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result < 0) {
+                // The reader has stopped reading.
+                return false;
+            }
+            written += static_cast<size_t>(result);
+        }
+        begin += static_cast<uint64_t>(length);
+    }
+    return true;
+}
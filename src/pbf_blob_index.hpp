@@ -0,0 +1,190 @@
+/*
+ * pbf_blob_index.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_PBF_BLOB_INDEX_HPP_
+#define SRC_PBF_BLOB_INDEX_HPP_
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <osmium/io/file.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+/**
+ * Position and content of one blob of a PBF file.
+ */
+struct BlobIndexEntry {
+    /// offset of the blob (including the length of its BlobHeader) from the beginning of the file
+    uint64_t offset;
+
+    /// size of the blob including the length of the BlobHeader and the BlobHeader itself
+    uint64_t size;
+
+    /// type of the objects in the blob, osmium::osm_entity_bits::nothing for the OSMHeader blob
+    osmium::osm_entity_bits::type type;
+
+    BlobIndexEntry(uint64_t blob_offset, uint64_t blob_size, osmium::osm_entity_bits::type blob_type) :
+        offset(blob_offset),
+        size(blob_size),
+        type(blob_type) {
+    }
+};
+
+/**
+ * This class holds the offsets and entity types of all blobs of a PBF file.
+ *
+ * Building the index decompresses each blob and reads the keys of all its primitive
+ * groups. Blobs containing objects of different types are marked with
+ * osmium::osm_entity_bits::all. They are never skipped and the file is not considered
+ * to be sorted.
+ *
+ * The index is cached in a file next to the input file (see index_filename()).
+ */
+class PBFBlobIndex {
+    std::string m_filename;
+
+    /// size of the input file when the index was built
+    uint64_t m_file_size = 0;
+
+    /// modification time of the input file when the index was built
+    int64_t m_file_mtime = 0;
+
+    std::vector<BlobIndexEntry> m_entries;
+
+    /**
+     * Determine the type of the objects in an OSMData blob.
+     *
+     * \param fd file descriptor of the input file
+     * \param offset offset of the Blob message
+     * \param size size of the Blob message
+     */
+    static osmium::osm_entity_bits::type read_blob_type(int fd, uint64_t offset, uint64_t size);
+
+public:
+    PBFBlobIndex() = delete;
+
+    explicit PBFBlobIndex(const std::string& filename);
+
+    /**
+     * Name of the file used to cache the index of the given input file.
+     */
+    static std::string index_filename(const std::string& filename);
+
+    /**
+     * Load the index from its cache file or build it if the cache file is missing or outdated.
+     *
+     * Returns an empty pointer if the input file is not a PBF file on disk.
+     *
+     * \param filename input file
+     * \param verbose_output verbose output stream
+     * \param requested Has the blob index been requested by the user? Only then a warning is
+     * printed if the blob index cannot be used and a newly built index is written to its
+     * cache file.
+     */
+    static std::unique_ptr<PBFBlobIndex> open(const std::string& filename, osmium::util::VerboseOutput& verbose_output,
+            bool requested = true);
+
+    /**
+     * Load the index from its cache file.
+     *
+     * \returns false if the cache file is missing or does not belong to the current version of the input file
+     */
+    bool load();
+
+    /**
+     * Build the index by reading all blobs of the input file.
+     */
+    void build();
+
+    /**
+     * Write the index to its cache file.
+     *
+     * \returns false if the file could not be written
+     */
+    bool save() const;
+
+    /**
+     * Check if all nodes are stored before all ways and all ways before all relations.
+     */
+    bool sorted() const;
+
+    /**
+     * Size of the OSMHeader blob at the beginning of the file.
+     */
+    uint64_t header_size() const;
+
+    /**
+     * Get the range of bytes which contains all blobs of the given types.
+     *
+     * The range is only meaningful if the file is sorted. If there is no such blob,
+     * an empty range is returned.
+     *
+     * \returns offset of the first and offset after the last blob
+     */
+    std::pair<uint64_t, uint64_t> range(osmium::osm_entity_bits::type types) const;
+
+    const std::vector<BlobIndexEntry>& entries() const;
+};
+
+/**
+ * Feed a range of bytes of a PBF file (prepended by its OSMHeader blob) into a pipe which
+ * can be read by an osmium::io::Reader.
+ *
+ * The data is copied by a separate thread. The object has to live as long as the reader
+ * reads from the file. Call close() after the reader has been closed, reading errors are
+ * only reported by close().
+ */
+class BlobRangeInput {
+    int m_input_fd = -1;
+
+    /// read and write end of the pipe
+    int m_pipe[2] = {-1, -1};
+
+    std::thread m_thread;
+
+    /// error of the copying thread, the reader only sees the end of the stream
+    std::exception_ptr m_error;
+
+    void stop();
+
+    void copy_ranges(uint64_t header_size, std::pair<uint64_t, uint64_t> range);
+
+    bool copy_range(uint64_t begin, uint64_t end);
+
+public:
+    BlobRangeInput() = delete;
+
+    BlobRangeInput(const BlobRangeInput&) = delete;
+
+    BlobRangeInput& operator=(const BlobRangeInput&) = delete;
+
+    /**
+     * \param filename input file
+     * \param header_size size of the OSMHeader blob at the beginning of the file
+     * \param range offsets of the first byte and the byte after the last byte to be read
+     */
+    BlobRangeInput(const std::string& filename, uint64_t header_size, std::pair<uint64_t, uint64_t> range);
+
+    ~BlobRangeInput();
+
+    /**
+     * Stop copying and rethrow the error which occurred while reading the input file, if any.
+     */
+    void close();
+
+    /**
+     * File to be passed to osmium::io::Reader
+     */
+    osmium::io::File file() const;
+};
+
+#endif /* SRC_PBF_BLOB_INDEX_HPP_ */
@@ -6,6 +6,7 @@
  */
 
 #include "ptv2_checker.hpp"
+#include "tag_values.hpp"
 #include <osmium/index/id_set.hpp>
 #include <assert.h>
 
@@ -15,24 +16,26 @@ PTv2Checker::PTv2Checker(RouteWriter& writer) :
 
 RouteType PTv2Checker::get_route_type(const char* route) {
     assert(route);
-    if (!strcmp(route, "train")) {
+    switch (tag_values::route(route)) {
+    case tag_values::Route::TRAIN:
         return RouteType::TRAIN;
-    } else if (!strcmp(route, "light_rail")) {
+    case tag_values::Route::LIGHT_RAIL:
         return RouteType::LIGHT_RAIL;
-    } else if (!strcmp(route, "subway")) {
+    case tag_values::Route::SUBWAY:
         return RouteType::SUBWAY;
-    } else if (!strcmp(route, "tram")) {
+    case tag_values::Route::TRAM:
         return RouteType::TRAM;
-    } else if (!strcmp(route, "bus")) {
+    case tag_values::Route::BUS:
         return RouteType::BUS;
-    } else if (!strcmp(route, "trolleybus")) {
+    case tag_values::Route::TROLLEYBUS:
         return RouteType::TROLLEYBUS;
-    } else if (!strcmp(route, "ferry")) {
+    case tag_values::Route::FERRY:
         return RouteType::FERRY;
-    } else if (!strcmp(route, "aerialway")) {
+    case tag_values::Route::AERIALWAY:
         return RouteType::AERIALWAY;
+    default:
+        return RouteType::NONE;
     }
-    return RouteType::NONE;
 }
 
 bool PTv2Checker::is_stop(const char* role) {
@@ -72,9 +75,18 @@ bool PTv2Checker::check_valid_railway_track(RouteType type, const osmium::TagLis
         return is_ferry(member_tags);
     }
     if (type == RouteType::TRAIN || type == RouteType::LIGHT_RAIL || type == RouteType::TRAM) {
-        if (!strcmp(railway, "rail") || !strcmp(railway, "light_rail") || !strcmp(railway, "tram") || !strcmp(railway, "subway")
-                || !strcmp(railway, "funicular") || !strcmp(railway, "preserved") || !strcmp(railway, "miniature") || !strcmp(railway, "narrow_gauge")) {
+        switch (tag_values::railway(railway)) {
+        case tag_values::Railway::RAIL:
+        case tag_values::Railway::LIGHT_RAIL:
+        case tag_values::Railway::TRAM:
+        case tag_values::Railway::SUBWAY:
+        case tag_values::Railway::FUNICULAR:
+        case tag_values::Railway::PRESERVED:
+        case tag_values::Railway::MINIATURE:
+        case tag_values::Railway::NARROW_GAUGE:
             return true;
+        default:
+            break;
         }
     }
     if (type == RouteType::SUBWAY) {
@@ -88,13 +100,29 @@ bool PTv2Checker::check_valid_road_way(const osmium::TagList& member_tags) {
     if (!highway) {
         return is_ferry(member_tags);
     }
-    return (!strcmp(highway, "motorway") || !strcmp(highway, "motorway_link") || !strcmp(highway, "trunk")
-        || !strcmp(highway, "trunk_link") || !strcmp(highway, "primary") || !strcmp(highway, "primary_link")
-        || !strcmp(highway, "secondary") || !strcmp(highway, "secondary_link") || !strcmp(highway, "tertiary")
-        || !strcmp(highway, "tertiary_link") || !strcmp(highway, "unclassified") || !strcmp(highway, "residential")
-        || !strcmp(highway, "service") || !strcmp(highway, "track") || !strcmp(highway, "pedestrian")
-        || !strcmp(highway, "living_street") || !strcmp(highway, "bus_guideway") || !strcmp(highway, "busway")
-       );
+    switch (tag_values::highway(highway)) {
+    case tag_values::Highway::MOTORWAY:
+    case tag_values::Highway::MOTORWAY_LINK:
+    case tag_values::Highway::TRUNK:
+    case tag_values::Highway::TRUNK_LINK:
+    case tag_values::Highway::PRIMARY:
+    case tag_values::Highway::PRIMARY_LINK:
+    case tag_values::Highway::SECONDARY:
+    case tag_values::Highway::SECONDARY_LINK:
+    case tag_values::Highway::TERTIARY:
+    case tag_values::Highway::TERTIARY_LINK:
+    case tag_values::Highway::UNCLASSIFIED:
+    case tag_values::Highway::RESIDENTIAL:
+    case tag_values::Highway::SERVICE:
+    case tag_values::Highway::TRACK:
+    case tag_values::Highway::PEDESTRIAN:
+    case tag_values::Highway::LIVING_STREET:
+    case tag_values::Highway::BUS_GUIDEWAY:
+    case tag_values::Highway::BUSWAY:
+        return true;
+    default:
+        return false;
+    }
 }
 
 bool PTv2Checker::check_valid_trolleybus_way(const osmium::TagList& member_tags) {
@@ -146,32 +174,64 @@ BackOrFront PTv2Checker::roundabout_connected_to_next_way(const osmium::Way* pre
     return BackOrFront::UNDEFINED;
 }
 
+uint8_t PTv2Checker::classify_way(const osmium::TagList& tags) {
+    uint8_t classes = 0;
+    if (check_valid_railway_track(RouteType::TRAIN, tags)) {
+        classes |= WayClass::RAILWAY;
+    }
+    if (check_valid_railway_track(RouteType::SUBWAY, tags)) {
+        classes |= WayClass::SUBWAY;
+    }
+    if (check_valid_road_way(tags)) {
+        classes |= WayClass::ROAD;
+    }
+    if (check_valid_trolleybus_way(tags)) {
+        classes |= WayClass::TROLLEYBUS;
+    }
+    if (is_ferry(tags, true)) {
+        classes |= WayClass::FERRY;
+    }
+    return classes;
+}
+
+constexpr size_t PTv2Checker::max_memoized_objects;
+
+/*static*/ uint8_t PTv2Checker::route_type_bit(const RouteType type) noexcept {
+    if (type == RouteType::NONE) {
+        return 0;
+    }
+    return static_cast<uint8_t>(1 << (static_cast<int>(type) - 1));
+}
+
 RouteError PTv2Checker::is_way_usable(const osmium::Relation& relation, RouteType type, const osmium::Way* way) {
+    const uint8_t classes = memoized(m_way_classes, way->id(), [this, way]() {
+        return classify_way(way->tags());
+    });
     switch (type) {
     case RouteType::TRAIN:
     case RouteType::LIGHT_RAIL:
     case RouteType::TRAM:
     case RouteType::SUBWAY:
-        if (!check_valid_railway_track(type, way->tags())) {
+        if (!(classes & (type == RouteType::SUBWAY ? WayClass::SUBWAY : WayClass::RAILWAY))) {
             m_writer.write_error_way(relation, 0, "rail-guided route over non-rail", way);
             return RouteError::OVER_NON_RAIL;
         }
         break;
 
     case RouteType::BUS:
-        if (!check_valid_road_way(way->tags())) {
+        if (!(classes & WayClass::ROAD)) {
             m_writer.write_error_way(relation, 0, "road vehicle route over non-road", way);
             return RouteError::OVER_NON_ROAD;
         }
         break;
     case RouteType::TROLLEYBUS:
-        if (!check_valid_trolleybus_way(way->tags())) {
+        if (!(classes & WayClass::TROLLEYBUS)) {
             m_writer.write_error_way(relation, 0, "trolley bus without trolley wire", way);
             return RouteError::NO_TROLLEY_WIRE;
         }
         break;
     case RouteType::FERRY:
-        if (!is_ferry(way->tags(), true)) {
+        if (!(classes & WayClass::FERRY)) {
             m_writer.write_error_way(relation, 0, "ferry over ways other than route=ferry", way);
             return RouteError::NO_FERRY;
         }
@@ -182,173 +242,210 @@ RouteError PTv2Checker::is_way_usable(const osmium::Relation& relation, RouteTyp
     return RouteError::CLEAN;
 }
 
-RouteError PTv2Checker::check_stop_tags(const osmium::Relation& relation, const osmium::Node* node, RouteType type) {
-    if (node->tags().has_tag("public_transport", "stop_position") && vehicle_tags_matches_route_type(node->tags(), type)) {
-        return RouteError::CLEAN;
+bool PTv2Checker::stop_tags_valid(const osmium::TagList& tags, RouteType type) {
+    if (tags.has_tag("public_transport", "stop_position") && vehicle_tags_matches_route_type(tags, type)) {
+        return true;
     }
-    if ((type == RouteType::BUS || type == RouteType::TROLLEYBUS) && !node->tags().has_tag("highway", "bus_stop")) {
-        m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
-        return RouteError::STOP_TAG_MISSING;
+    if ((type == RouteType::BUS || type == RouteType::TROLLEYBUS) && !tags.has_tag("highway", "bus_stop")) {
+        return false;
     }
-    if (type == RouteType::TRAIN && !node->tags().has_tag("railway", "station")
-            && !node->tags().has_tag("railway", "halt") && !node->tags().has_tag("railway", "tram_stop")) {
-        m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
-        return RouteError::STOP_TAG_MISSING;
+    if (type == RouteType::TRAIN && !tags.has_tag("railway", "station")
+            && !tags.has_tag("railway", "halt") && !tags.has_tag("railway", "tram_stop")) {
+        return false;
     }
-    if (type == RouteType::SUBWAY && !node->tags().has_tag("railway", "station")) {
-        m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
-        return RouteError::STOP_TAG_MISSING;
+    if (type == RouteType::SUBWAY && !tags.has_tag("railway", "station")) {
+        return false;
     }
-    if (type == RouteType::FERRY && !node->tags().has_tag("amenity", "ferry_terminal")) {
-        m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
-        return RouteError::STOP_TAG_MISSING;
+    if (type == RouteType::FERRY && !tags.has_tag("amenity", "ferry_terminal")) {
+        return false;
     }
-    if (type == RouteType::AERIALWAY && !node->tags().has_tag("aerialway", "station")) {
-        m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
-        return RouteError::STOP_TAG_MISSING;
+    if (type == RouteType::AERIALWAY && !tags.has_tag("aerialway", "station")) {
+        return false;
     }
-    return RouteError::CLEAN;
+    return true;
 }
 
-RouteError PTv2Checker::check_platform_tags(const osmium::Relation& relation, const RouteType type, const osmium::OSMObject* object) {
-    if (object->tags().has_tag("public_transport", "platform")) {
+RouteError PTv2Checker::check_stop_tags(const osmium::Relation& relation, const osmium::Node* node, RouteType type) {
+    const uint8_t valid_types = memoized(m_stop_classes, node->id(), [this, node]() {
+        uint8_t types = 0;
+        for (int t = static_cast<int>(RouteType::BUS); t <= static_cast<int>(RouteType::LIGHT_RAIL); ++t) {
+            if (stop_tags_valid(node->tags(), static_cast<RouteType>(t))) {
+                types |= route_type_bit(static_cast<RouteType>(t));
+            }
+        }
+        return types;
+    });
+    if (type == RouteType::NONE || (valid_types & route_type_bit(type))) {
         return RouteError::CLEAN;
     }
-    if (((type == RouteType::BUS || type == RouteType::TROLLEYBUS)
-            && !object->tags().has_tag("highway", "bus_stop") && !object->tags().has_tag("highway", "platform"))
+    m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
+    return RouteError::STOP_TAG_MISSING;
+}
+
+bool PTv2Checker::platform_tags_valid(const osmium::TagList& tags, const RouteType type) {
+    if (tags.has_tag("public_transport", "platform")) {
+        return true;
+    }
+    return !(((type == RouteType::BUS || type == RouteType::TROLLEYBUS)
+            && !tags.has_tag("highway", "bus_stop") && !tags.has_tag("highway", "platform"))
             || ((type == RouteType::TRAIN || type == RouteType::TRAM || type == RouteType::SUBWAY)
-            && !object->tags().has_tag("railway", "platform"))) {
-        if (object->type() == osmium::item_type::node) {
-            const osmium::Node* node = static_cast<const osmium::Node*>(object);
-            m_writer.write_error_point(relation, node->id(), node->location(), "platform without proper tags", 0);
-        } else if (object->type() == osmium::item_type::way) {
-            m_writer.write_error_way(relation, 0, "platform without proper tags", static_cast<const osmium::Way*>(object));
-        }
-        return RouteError::PLTF_TAG_MISSING;
+            && !tags.has_tag("railway", "platform")));
+}
+
+RouteError PTv2Checker::check_platform_tags(const osmium::Relation& relation, const RouteType type, const osmium::OSMObject* object) {
+    bool valid;
+    if (object->type() == osmium::item_type::node || object->type() == osmium::item_type::way) {
+        auto& classes = object->type() == osmium::item_type::node ? m_node_platform_classes : m_way_platform_classes;
+        const uint8_t valid_types = memoized(classes, object->id(), [this, object]() {
+            uint8_t types = 0;
+            for (int t = static_cast<int>(RouteType::BUS); t <= static_cast<int>(RouteType::LIGHT_RAIL); ++t) {
+                if (platform_tags_valid(object->tags(), static_cast<RouteType>(t))) {
+                    types |= route_type_bit(static_cast<RouteType>(t));
+                }
+            }
+            return types;
+        });
+        valid = type == RouteType::NONE || (valid_types & route_type_bit(type));
+    } else {
+        valid = platform_tags_valid(object->tags(), type);
     }
-    return RouteError::CLEAN;
+    if (valid) {
+        return RouteError::CLEAN;
+    }
+    if (object->type() == osmium::item_type::node) {
+        const osmium::Node* node = static_cast<const osmium::Node*>(object);
+        m_writer.write_error_point(relation, node->id(), node->location(), "platform without proper tags", 0);
+    } else if (object->type() == osmium::item_type::way) {
+        m_writer.write_error_way(relation, 0, "platform without proper tags", static_cast<const osmium::Way*>(object));
+    }
+    return RouteError::PLTF_TAG_MISSING;
 }
 
-RouteError PTv2Checker::check_roles_order_and_type(const osmium::Relation& relation,
-        std::vector<const osmium::OSMObject*>& member_objects) {
-	// Build an index of all nodes of all member ways (except platforms)
-	std::vector<WayNodeWithOrderID> node_ids_rank;
+void PTv2Checker::classify_members(const osmium::Relation& relation,
+        const std::vector<const osmium::OSMObject*>& member_objects) {
+    m_members.clear();
+    m_members.reserve(member_objects.size());
+    // Build an index of all nodes of all member ways (except platforms)
+    m_way_node_index.clear();
     std::vector<const osmium::OSMObject*>::const_iterator obj_it = member_objects.cbegin();
     osmium::RelationMemberList::const_iterator member_it = relation.members().cbegin();
     size_t way_count = 0;
     for (; obj_it != member_objects.cend(), member_it != relation.members().cend();
             ++obj_it, ++member_it) {
-		if (member_it->type() == osmium::item_type::way && !strcmp(member_it->role(), "") && *obj_it) {
-			const osmium::Way* way = static_cast<const osmium::Way*>(*obj_it);
-			for (const auto nref : way->nodes()) {
-				node_ids_rank.emplace_back(nref.ref(), way_count);
-			}
-			++way_count;
-		}
-	}
-    std::sort(node_ids_rank.begin(), node_ids_rank.end());
-    // Have we already passed a member which is neither a stop nor a platform?
-    bool seen_road_member = false;
-    // Have we already passed a member which is a stop or a platform?
-    bool seen_stop_platform = false;
-    // Is the route incomplete (some members not available in the input file)?
-    bool incomplete = false;
-    RouteError error = RouteError::CLEAN;
-    RouteType type = get_route_type(relation.get_value_by_key("route"));
-    if (type == RouteType::NONE) {
-        error |= RouteError::UNKNOWN_TYPE;
-    }
-    std::vector<WayNodeWithOrderID>::iterator last_stop = node_ids_rank.begin();
-    obj_it = member_objects.cbegin();
-    member_it = relation.members().cbegin();
-    for (; obj_it != member_objects.cend(), member_it != relation.members().cend();
-            ++obj_it, ++member_it) {
-        if (*obj_it == nullptr) {
-            incomplete = true;
+        const char* role = member_it->role();
+        MemberRole member_role = MemberRole::UNKNOWN;
+        if (!strcmp(role, "")) {
+            member_role = MemberRole::EMPTY;
+        } else if (is_stop(role)) {
+            member_role = MemberRole::STOP;
+        } else if (is_platform(role)) {
+            member_role = MemberRole::PLATFORM;
         }
-        const osmium::OSMObject* object = *obj_it;
-        if (member_it->type() == osmium::item_type::way && !strcmp(member_it->role(), "")) {
-            seen_road_member = true;
-            error |= role_check_handle_road_member(relation, type, object, seen_stop_platform);
-        } else if (member_it->type() != osmium::item_type::way && !strcmp(member_it->role(), "")) {
-            if (member_it->type() == osmium::item_type::node && object) {
-                const osmium::Node* node = static_cast<const osmium::Node*>(object);
-                m_writer.write_error_point(relation, node->id(), node->location(), "empty role for non-way object", 0);
-            }
-            error |= RouteError::EMPTY_ROLE_NON_WAY;
-        } else if (seen_road_member && (is_stop(member_it->role()) || is_platform(member_it->role()))) {
-            error |= handle_errorneous_stop_platform(relation, object);
-        } else if (member_it->type() == osmium::item_type::node && is_stop(member_it->role())) {
-            seen_stop_platform = true;
-            // errors reported by check_stop_tags are not considered as severe
-            if (object) {
-                check_stop_tags(relation, static_cast<const osmium::Node*>(object), type);
-            }
-        } else if (member_it->type() == osmium::item_type::way && is_stop(member_it->role())) {
-            error |= RouteError::STOP_IS_NOT_NODE;
-            if (object) {
-                m_writer.write_error_way(relation, 0, "stop is not a node", static_cast<const osmium::Way*>(object));
-            }
-        } else if (is_platform(member_it->role())) {
-            seen_stop_platform = true;
-            // errors reported by check_platform_tags are not considered as severe
-            if (object) {
-                check_platform_tags(relation, type, object);
+        m_members.push_back(ClassifiedMember{*obj_it, role, member_it->ref(), member_it->type(), member_role});
+        if (member_it->type() == osmium::item_type::way && member_role == MemberRole::EMPTY && *obj_it) {
+            const osmium::Way* way = static_cast<const osmium::Way*>(*obj_it);
+            for (const auto nref : way->nodes()) {
+                m_way_node_index[nref.ref()].emplace_back(way_count);
             }
-        } else if (strcmp(member_it->role(), "") && !is_stop(member_it->role()) && !is_platform(member_it->role())) {
-            error |= handle_unknown_role(relation, object, member_it->role());
+            ++way_count;
+        }
+    }
+}
+
+void PTv2Checker::init_role_check(const osmium::Relation& relation, RoleCheckState& state) {
+    state.last_stop_way_index = 0;
+    state.type = get_route_type(relation.get_value_by_key("route"));
+    if (state.type == RouteType::NONE) {
+        state.error |= RouteError::UNKNOWN_TYPE;
+    }
+}
+
+void PTv2Checker::role_check_member(const osmium::Relation& relation, const ClassifiedMember& member,
+        RoleCheckState& state) {
+    const osmium::OSMObject* object = member.object;
+    if (object == nullptr) {
+        state.incomplete = true;
+    }
+    if (member.type == osmium::item_type::way && member.role == MemberRole::EMPTY) {
+        state.seen_road_member = true;
+        state.error |= role_check_handle_road_member(relation, state.type, object, state.seen_stop_platform);
+    } else if (member.type != osmium::item_type::way && member.role == MemberRole::EMPTY) {
+        if (member.type == osmium::item_type::node && object) {
+            const osmium::Node* node = static_cast<const osmium::Node*>(object);
+            m_writer.write_error_point(relation, node->id(), node->location(), "empty role for non-way object", 0);
+        }
+        state.error |= RouteError::EMPTY_ROLE_NON_WAY;
+    } else if (state.seen_road_member && (member.role == MemberRole::STOP || member.role == MemberRole::PLATFORM)) {
+        state.error |= handle_errorneous_stop_platform(relation, object);
+    } else if (member.type == osmium::item_type::node && member.role == MemberRole::STOP) {
+        state.seen_stop_platform = true;
+        // errors reported by check_stop_tags are not considered as severe
+        if (object) {
+            check_stop_tags(relation, static_cast<const osmium::Node*>(object), state.type);
+        }
+    } else if (member.type == osmium::item_type::way && member.role == MemberRole::STOP) {
+        state.error |= RouteError::STOP_IS_NOT_NODE;
+        if (object) {
+            m_writer.write_error_way(relation, 0, "stop is not a node", static_cast<const osmium::Way*>(object));
+        }
+    } else if (member.role == MemberRole::PLATFORM) {
+        state.seen_stop_platform = true;
+        // errors reported by check_platform_tags are not considered as severe
+        if (object) {
+            check_platform_tags(relation, state.type, object);
         }
-        if (member_it->type() == osmium::item_type::node && *obj_it != nullptr && is_stop(member_it->role())) {
-        	if (node_ids_rank.empty()) {
-				error |= handle_stop_not_on_way(relation, static_cast<const osmium::Node*>(*obj_it));
-			} else {
-				auto node_ids_it = std::find_if(
-						node_ids_rank.begin(),
-						node_ids_rank.end(),
-						[&member_it](const WayNodeWithOrderID& val) { return val.id == member_it->ref() && !val.found; }
-				);
-				if (node_ids_it == node_ids_rank.end()) {
-					error |= handle_stop_not_on_way(relation, static_cast<const osmium::Node*>(*obj_it));
-				} else if (node_ids_it->way_index < last_stop->way_index) {
-					// Search a second time. If the way is used twice by the road (T-like or a
-					// loop) and served in a later run instead, the first occurrence of this node
-					// in the nodes index is not the one we are looking for.
-					++node_ids_it;
-					node_ids_it = std::find_if(
-							node_ids_it,
-							node_ids_rank.end(),
-							[&member_it, &last_stop](const WayNodeWithOrderID& val) { return val.id == member_it->ref() && !val.found && val.way_index >= last_stop->way_index; }
-					);
-					if (node_ids_it == node_ids_rank.end()) {
-						error |= handle_stop_wrong_order(relation, static_cast<const osmium::Node*>(*obj_it));
-					} else {
-						node_ids_it->found = true;
-						last_stop = node_ids_it;
-					}
-				} else {
-					node_ids_it->found = true;
-					last_stop = node_ids_it;
-				}
-			}
+    } else if (member.role == MemberRole::UNKNOWN) {
+        state.error |= handle_unknown_role(relation, object, member.role_string);
+    }
+    if (member.type == osmium::item_type::node && object != nullptr && member.role == MemberRole::STOP) {
+        auto index_it = m_way_node_index.find(member.ref);
+        std::vector<WayNodeSlot>::iterator slot_it;
+        if (index_it != m_way_node_index.end()) {
+            slot_it = std::find_if(index_it->second.begin(), index_it->second.end(),
+                    [](const WayNodeSlot& slot) { return !slot.found; });
+        }
+        if (index_it == m_way_node_index.end() || slot_it == index_it->second.end()) {
+            state.error |= handle_stop_not_on_way(relation, static_cast<const osmium::Node*>(object));
+        } else if (slot_it->way_index < state.last_stop_way_index) {
+            // Search a second time. If the way is used twice by the road (T-like or a
+            // loop) and served in a later run instead, the first occurrence of this node
+            // in the nodes index is not the one we are looking for.
+            ++slot_it;
+            const size_t last_stop_way_index = state.last_stop_way_index;
+            slot_it = std::find_if(slot_it, index_it->second.end(),
+                    [last_stop_way_index](const WayNodeSlot& slot) {
+                        return !slot.found && slot.way_index >= last_stop_way_index;
+                    });
+            if (slot_it == index_it->second.end()) {
+                state.error |= handle_stop_wrong_order(relation, static_cast<const osmium::Node*>(object));
+            } else {
+                slot_it->found = true;
+                state.last_stop_way_index = slot_it->way_index;
+            }
+        } else {
+            slot_it->found = true;
+            state.last_stop_way_index = slot_it->way_index;
         }
     }
-    if (!seen_road_member && !incomplete) {
+}
+
+RouteError PTv2Checker::finish_role_check(const osmium::Relation& relation, RoleCheckState& state) {
+    if (!state.seen_road_member && !state.incomplete) {
         // route contains no highway/railway members
-        error |= RouteError::NO_ROUTE;
+        state.error |= RouteError::NO_ROUTE;
         // write all members as errors
-        obj_it = member_objects.cbegin();
-        for (; obj_it != member_objects.cend(); ++obj_it) {
-            if (*obj_it == nullptr) {
+        for (const ClassifiedMember& member : m_members) {
+            if (member.object == nullptr) {
                 continue;
             }
-            switch ((*obj_it)->type()) {
+            switch (member.object->type()) {
             case osmium::item_type::node: {
-                const osmium::Node* node = static_cast<const osmium::Node*>(*obj_it);
+                const osmium::Node* node = static_cast<const osmium::Node*>(member.object);
                 m_writer.write_error_point(relation, node->id(), node->location(), "route has only stops/platforms", 0);
                 break;
             }
             case osmium::item_type::way: {
-                const osmium::Way* way = static_cast<const osmium::Way*>(*obj_it);
+                const osmium::Way* way = static_cast<const osmium::Way*>(member.object);
                 m_writer.write_error_way(relation, 0, "route has only stops/platforms", way);
                 break;
             }
@@ -357,7 +454,46 @@ RouteError PTv2Checker::check_roles_order_and_type(const osmium::Relation& relat
             }
         }
     }
-    return error;
+    return state.error;
+}
+
+void PTv2Checker::gap_check_member(const osmium::Relation& relation, const ClassifiedMember& member, GapCheckState& state) {
+    const osmium::Way* way = nullptr;
+    if (member.type == osmium::item_type::way && member.object != nullptr) {
+        way = static_cast<const osmium::Way*>(member.object);
+    }
+    state.gaps_count += gap_detector_member_handling(relation, way, state.previous_way, member, state.status,
+            state.previous_way_end);
+    if (way) {
+        state.previous_way = way;
+    }
+}
+
+RouteError PTv2Checker::validate(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects) {
+    classify_members(relation, member_objects);
+    RoleCheckState role_state;
+    init_role_check(relation, role_state);
+    GapCheckState gap_state;
+    for (const ClassifiedMember& member : m_members) {
+        role_check_member(relation, member, role_state);
+        gap_check_member(relation, member, gap_state);
+    }
+    RouteError result = finish_role_check(relation, role_state);
+    if (gap_state.gaps_count > 0) {
+        result |= RouteError::UNORDERED_GAP;
+    }
+    return result;
+}
+
+RouteError PTv2Checker::check_roles_order_and_type(const osmium::Relation& relation,
+        std::vector<const osmium::OSMObject*>& member_objects) {
+    classify_members(relation, member_objects);
+    RoleCheckState state;
+    init_role_check(relation, state);
+    for (const ClassifiedMember& member : m_members) {
+        role_check_member(relation, member, state);
+    }
+    return finish_role_check(relation, state);
 }
 
 RouteError PTv2Checker::role_check_handle_road_member(const osmium::Relation& relation, const RouteType type,
@@ -422,39 +558,26 @@ RouteError PTv2Checker::handle_unknown_role(const osmium::Relation& relation, co
 }
 
 int PTv2Checker::find_gaps(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects) {
-    MemberStatus status = MemberStatus::BEFORE_FIRST;
-    BackOrFront previous_way_end = BackOrFront::UNDEFINED;
-    int gaps_count = 0;
-    const osmium::Way* previous_way = nullptr;
-    std::vector<const osmium::OSMObject*>::const_iterator obj_it = member_objects.cbegin();
-    osmium::RelationMemberList::const_iterator member_it = relation.members().cbegin();
-    for (size_t i = 0; obj_it != member_objects.cend(), member_it != relation.members().cend(); ++obj_it, ++member_it, ++i) {
-        const osmium::OSMObject* object = *obj_it;
-        const osmium::Way* way = nullptr;
-        if (member_it->type() == osmium::item_type::way && object != nullptr) {
-            way = static_cast<const osmium::Way*>(object);
-        }
-        gaps_count += gap_detector_member_handling(relation, way, previous_way, member_it, status, previous_way_end);
-        if (member_it->type() == osmium::item_type::way && object) {
-            previous_way = static_cast<const osmium::Way*>(object);
-        }
+    classify_members(relation, member_objects);
+    GapCheckState state;
+    for (const ClassifiedMember& member : m_members) {
+        gap_check_member(relation, member, state);
     }
-    return gaps_count;
+    return state.gaps_count;
 }
 
 int PTv2Checker::gap_detector_member_handling(const osmium::Relation& relation, const osmium::Way* way,
-        const osmium::Way* previous_way, osmium::RelationMemberList::const_iterator member_it, MemberStatus& status,
+        const osmium::Way* previous_way, const ClassifiedMember& member, MemberStatus& status,
         BackOrFront& previous_way_end) {
-    const char* role = member_it->role();
     if (way == nullptr && status == MemberStatus::BEFORE_FIRST) {
         // We can ignore missing members if we are still in the stop/platform section
         return 0;
-    } else if (way == nullptr && member_it->type() == osmium::item_type::way) {
+    } else if (way == nullptr && member.type == osmium::item_type::way) {
         status = MemberStatus::AFTER_MISSING;
         return 0;
     }
     // check role and type
-    if (status == MemberStatus::BEFORE_FIRST && member_it->type() == osmium::item_type::way && !strcmp(role, "")) {
+    if (status == MemberStatus::BEFORE_FIRST && member.type == osmium::item_type::way && member.role == MemberRole::EMPTY) {
         status = MemberStatus::FIRST;
     }
     if (status == MemberStatus::BEFORE_FIRST) {
@@ -463,7 +586,7 @@ int PTv2Checker::gap_detector_member_handling(const osmium::Relation& relation,
     }
 
     // check if it is a way
-    if (member_it->type() != osmium::item_type::way || strcmp(role, "")) {
+    if (member.type != osmium::item_type::way || member.role != MemberRole::EMPTY) {
         status = MemberStatus::AFTER_GAP;
         return 0;
     }
@@ -504,7 +627,7 @@ int PTv2Checker::gap_detector_member_handling(const osmium::Relation& relation,
     }
 
     // Now the real comparisons begin.
-    assert(previous_way && member_it->type() == osmium::item_type::way);
+    assert(previous_way && member.type == osmium::item_type::way);
     if (status == MemberStatus::AFTER_ROUNDABOUT) {
         // check which end of the way is connected to the roundabout
         previous_way_end = roundabout_connected_to_next_way(previous_way, way);
@@ -8,6 +8,10 @@
 #ifndef SRC_PTV2_CHECKER_HPP_
 #define SRC_PTV2_CHECKER_HPP_
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 #include "route_writer.hpp"
 
 /**
@@ -42,28 +46,180 @@ enum class BackOrFront : char {
     BACK = 2
 };
 
-struct WayNodeWithOrderID {
-	/// Node ID
-	osmium::object_id_type id;
+/**
+ * Role of a route member, classified once per relation.
+ */
+enum class MemberRole : char {
+    /// empty role (way used by the vehicle)
+    EMPTY = 0,
+    /// `stop`, `stop_entry_only` or `stop_exit_only`
+    STOP = 1,
+    /// `platform`, `platform_entry_only` or `platform_exit_only`
+    PLATFORM = 2,
+    /// any other role
+    UNKNOWN = 3
+};
+
+/**
+ * Member of a route relation with its role classified.
+ */
+struct ClassifiedMember {
+    /// member object, nullptr if it is not available in the input file
+    const osmium::OSMObject* object;
+    /// role as string, used for error messages
+    const char* role_string;
+    osmium::object_id_type ref;
+    osmium::item_type type;
+    MemberRole role;
+};
+
+/**
+ * Occurrence of a node in a member way of a route. Stops are matched against these slots.
+ */
+struct WayNodeSlot {
 	/// index (= offset from begin) of the way in a list of all member ways with an empty role
 	size_t way_index;
+	/// Has a stop been matched with this slot?
 	bool found = false;
 
-	explicit WayNodeWithOrderID(osmium::object_id_type node_ref, size_t index) :
-			id(node_ref),
+	explicit WayNodeSlot(size_t index) :
 			way_index(index) {}
-
-	bool operator<(const WayNodeWithOrderID& rhs) const {
-		return this->way_index < rhs.way_index || (this->way_index == rhs.way_index && this->id < rhs.id);
-	}
 };
 
+/**
+ * Bits of the classification of a way as a member of a route.
+ */
+namespace WayClass {
+    /// valid for train, light rail and tram routes
+    constexpr uint8_t RAILWAY = 1;
+    /// valid for subway routes
+    constexpr uint8_t SUBWAY = 2;
+    /// valid for bus routes
+    constexpr uint8_t ROAD = 4;
+    /// valid for trolleybus routes
+    constexpr uint8_t TROLLEYBUS = 8;
+    /// valid for ferry routes
+    constexpr uint8_t FERRY = 16;
+}
+
 /**
  * This class provides methods to check the validity of a route relation.
  */
 class PTv2Checker {
     RouteWriter& m_writer;
 
+    /**
+     * Index of all nodes of the member ways (except platforms) of the relation being checked by
+     * check_roles_order_and_type(). The slots of each node are sorted by the way index.
+     * It is a member to reuse its memory.
+     */
+    std::unordered_map<osmium::object_id_type, std::vector<WayNodeSlot>> m_way_node_index;
+
+    /// members of the relation being checked, a member to reuse its memory
+    std::vector<ClassifiedMember> m_members;
+
+    /**
+     * Classifications of member objects which are used by many routes. They depend on the
+     * tags only and are computed once per object.
+     *
+     * Each checker has its own tables because each validation thread has its own checker.
+     * A table is cleared if it reaches max_memoized_objects entries to bound the memory
+     * used by all threads.
+     */
+    /// WayClass bits of ways
+    std::unordered_map<osmium::object_id_type, uint8_t> m_way_classes;
+
+    /// route types (bits by route_type_bit()) a stop node is tagged properly for
+    std::unordered_map<osmium::object_id_type, uint8_t> m_stop_classes;
+
+    /// route types (bits by route_type_bit()) a platform node is tagged properly for
+    std::unordered_map<osmium::object_id_type, uint8_t> m_node_platform_classes;
+
+    /// route types (bits by route_type_bit()) a platform way is tagged properly for
+    std::unordered_map<osmium::object_id_type, uint8_t> m_way_platform_classes;
+
+    /// maximum number of entries of each classification table
+    static constexpr size_t max_memoized_objects = 256 * 1024;
+
+    /**
+     * Look up the classification of an object or compute and remember it.
+     */
+    template <typename TFunction>
+    static uint8_t memoized(std::unordered_map<osmium::object_id_type, uint8_t>& classes,
+            const osmium::object_id_type id, TFunction&& compute) {
+        auto it = classes.find(id);
+        if (it != classes.end()) {
+            return it->second;
+        }
+        const uint8_t value = compute();
+        if (classes.size() >= max_memoized_objects) {
+            classes.clear();
+        }
+        classes.emplace(id, value);
+        return value;
+    }
+
+    /**
+     * Get the bit of a route type in the classification of stops and platforms.
+     *
+     * RouteType::NONE has no bit because any stop and platform is valid for it.
+     */
+    static uint8_t route_type_bit(const RouteType type) noexcept;
+
+    /**
+     * Get the WayClass bits of a way.
+     */
+    uint8_t classify_way(const osmium::TagList& tags);
+
+    /**
+     * Check if a stop is tagged properly for a route type.
+     */
+    bool stop_tags_valid(const osmium::TagList& tags, RouteType type);
+
+    /**
+     * Check if a platform is tagged properly for a route type.
+     */
+    bool platform_tags_valid(const osmium::TagList& tags, const RouteType type);
+
+    /// state of the check of roles, order and type of the members
+    struct RoleCheckState {
+        /// Have we already passed a member which is neither a stop nor a platform?
+        bool seen_road_member = false;
+        /// Have we already passed a member which is a stop or a platform?
+        bool seen_stop_platform = false;
+        /// Is the route incomplete (some members not available in the input file)?
+        bool incomplete = false;
+        /// index of the way the last stop is located on
+        size_t last_stop_way_index = 0;
+        RouteType type = RouteType::NONE;
+        RouteError error = RouteError::CLEAN;
+    };
+
+    /// state of the gap detection
+    struct GapCheckState {
+        MemberStatus status = MemberStatus::BEFORE_FIRST;
+        BackOrFront previous_way_end = BackOrFront::UNDEFINED;
+        const osmium::Way* previous_way = nullptr;
+        int gaps_count = 0;
+    };
+
+    /**
+     * Classify the roles of all members of a relation and build the index of the nodes of
+     * its member ways.
+     */
+    void classify_members(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects);
+
+    void init_role_check(const osmium::Relation& relation, RoleCheckState& state);
+
+    /**
+     * Check role, type and the order of stops of a member.
+     */
+    void role_check_member(const osmium::Relation& relation, const ClassifiedMember& member, RoleCheckState& state);
+
+    RouteError finish_role_check(const osmium::Relation& relation, RoleCheckState& state);
+
+    void gap_check_member(const osmium::Relation& relation, const ClassifiedMember& member, GapCheckState& state);
+
     RouteError role_check_handle_road_member(const osmium::Relation& relation, const RouteType type,
             const osmium::OSMObject* object, const bool seen_stop_platform);
 
@@ -78,7 +234,7 @@ class PTv2Checker {
     int gap_detector_member_handling(const osmium::Relation& relation, /*const osmium::OSMObject* object,*/
             const osmium::Way* way,
             const osmium::Way* previous_way,
-            osmium::RelationMemberList::const_iterator member_it, MemberStatus& status, BackOrFront& previous_way_end);
+            const ClassifiedMember& member, MemberStatus& status, BackOrFront& previous_way_end);
 
     static const osmium::NodeRef* back_or_front_to_node_ref(BackOrFront back_or_front, const osmium::Way* way);
 
@@ -234,6 +390,18 @@ public:
      */
     RouteError check_platform_tags(const osmium::Relation& relation, const RouteType type, const osmium::OSMObject* object);
 
+    /**
+     * Run all checks of a route relation: roles, order and type of its members and gaps.
+     *
+     * The members are classified once and all checks are done in a single pass over them.
+     * The result is the same as the one of check_roles_order_and_type() and find_gaps().
+     *
+     * \param relation relation to be checked
+     *
+     * \param member_objects vector of pointers to the member objects
+     */
+    RouteError validate(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects);
+
     /*
      * Check the correct order of the members of the relation without looking on their geometry.
      */
@@ -6,6 +6,8 @@
  */
 
 #include "railway_handler_pass1.hpp"
+#include "tag_extractor.hpp"
+#include "tag_values.hpp"
 #include <iostream>
 
 /// indexes of fields – all layers
@@ -42,6 +44,29 @@ struct StationsIndexes {
     static constexpr int amenity = 8;
 };
 
+/// indexes of the values returned by feature_tags
+struct FeatureTagIndexes {
+    static constexpr size_t railway = 0;
+    static constexpr size_t public_transport = 1;
+    static constexpr size_t highway = 2;
+    static constexpr size_t name = 3;
+    static constexpr size_t network = 4;
+    static constexpr size_t _operator = 5;
+    static constexpr size_t ref = 6;
+    static constexpr size_t local_ref = 7;
+    static constexpr size_t amenity = 8;
+    static constexpr size_t crossing_barrier = 9;
+    static constexpr size_t crossing_light = 10;
+};
+
+namespace {
+
+    /// tags read by the handler, read once per object
+    const TagExtractor<11> feature_tags {"railway", "public_transport", "highway", "name", "network", "operator",
+        "ref", "local_ref", "amenity", "crossing:barrier", "crossing:light"};
+
+} // namespace
+
 RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
         osmium::util::VerboseOutput& verbose_output, osmium::ItemStash& signals,
         std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& must_on_track_handles) :
@@ -51,16 +76,16 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
     if (options.crossings) {
         m_crossings = m_output.writer().create_layer_ptr("crossings", wkbPoint);
         // add fields to layers
-        m_crossings->add_field("node_id", OFTString, 10);
-        m_crossings->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_crossings, "node_id");
+        m_output.add_timestamp_field(*m_crossings, "lastchange");
         m_crossings->add_field("barrier", OFTString, 50);
         m_crossings->add_field("lights", OFTString, 50);
     }
     if (options.stops) {
         m_stops = m_output.writer().create_layer_ptr("stops", wkbPoint);
         // add fields to layers
-        m_stops->add_field("node_id", OFTString, 10);
-        m_stops->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_stops, "node_id");
+        m_output.add_timestamp_field(*m_stops, "lastchange");
         m_stops->add_field("name", OFTString, 100);
         m_stops->add_field("public_transport", OFTString, 50);
         m_stops->add_field("railway", OFTString, 50);
@@ -73,8 +98,8 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
     if (options.platforms) {
         m_platforms = m_output.writer().create_layer_ptr("platforms", wkbPoint);
         // add fields to layers
-        m_platforms->add_field("node_id", OFTString, 10);
-        m_platforms->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_platforms, "node_id");
+        m_output.add_timestamp_field(*m_platforms, "lastchange");
         m_platforms->add_field("name", OFTString, 100);
         m_platforms->add_field("public_transport", OFTString, 50);
         m_platforms->add_field("railway", OFTString, 50);
@@ -84,8 +109,8 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
         m_platforms->add_field("ref", OFTString, 25);
         m_platforms->add_field("local_ref", OFTString, 25);
         m_platforms_l = m_output.writer().create_layer_ptr("platforms_l", wkbLineString);
-        m_platforms_l->add_field("way_id", OFTString, 10);
-        m_platforms_l->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_platforms_l, "way_id");
+        m_output.add_timestamp_field(*m_platforms_l, "lastchange");
         m_platforms_l->add_field("name", OFTString, 21);
         m_platforms_l->add_field("public_transport", OFTString, 50);
         m_platforms_l->add_field("railway", OFTString, 50);
@@ -98,8 +123,8 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
     if (options.stations) {
         m_stations = m_output.writer().create_layer_ptr("stations", wkbPoint);
         // add fields to layers
-        m_stations->add_field("node_id", OFTString, 10);
-        m_stations->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_stations, "node_id");
+        m_output.add_timestamp_field(*m_stations, "lastchange");
         m_stations->add_field("name", OFTString, 100);
         m_stations->add_field("public_transport", OFTString, 50);
         m_stations->add_field("railway", OFTString, 50);
@@ -108,8 +133,8 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
         m_stations->add_field("network", OFTString, 100);
         m_stations->add_field("amenity", OFTString, 50);
         m_stations_l = m_output.writer().create_layer_ptr("stations_l", wkbLineString);
-        m_stations_l->add_field("way_id", OFTString, 10);
-        m_stations_l->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_stations_l, "way_id");
+        m_output.add_timestamp_field(*m_stations_l, "lastchange");
         m_stations_l->add_field("name", OFTString, 100);
         m_stations_l->add_field("public_transport", OFTString, 50);
         m_stations_l->add_field("railway", OFTString, 50);
@@ -121,8 +146,8 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
     if (options.stops || options.platforms) {
         m_stops_only_highway = m_output.writer().create_layer_ptr("stops_only_highway", wkbPoint);
         // add fields to layers
-        m_stops_only_highway->add_field("node_id", OFTString, 10);
-        m_stops_only_highway->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_stops_only_highway, "node_id");
+        m_output.add_timestamp_field(*m_stops_only_highway, "lastchange");
         m_stops_only_highway->add_field("name", OFTString, 100);
         m_stops_only_highway->add_field("public_transport", OFTString, 50);
         m_stops_only_highway->add_field("railway", OFTString, 50);
@@ -132,32 +157,74 @@ RailwayHandlerPass1::RailwayHandlerPass1(OGRWriter& writer, Options& options,
     }
 }
 
+/*static*/ bool RailwayHandlerPass1::has_relevant_tags(const osmium::TagList& tags) {
+    for (const osmium::Tag& tag : tags) {
+        const char* key = tag.key();
+        switch (key[0]) {
+        case 'r':
+            if (!strcmp(key, "railway")) {
+                return true;
+            }
+            break;
+        case 'p':
+            if (!strcmp(key, "public_transport")) {
+                return true;
+            }
+            break;
+        case 'h':
+            if (!strcmp(key, "highway") && !strcmp(tag.value(), "bus_stop")) {
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
 void RailwayHandlerPass1::node(const osmium::Node& node) {
-    if (!node.location().valid()) {
+    if (node.tags().empty() || !node.location().valid() || !has_relevant_tags(node.tags())) {
         return;
     }
-    const char* railway = node.get_value_by_key("railway");
-    const char* public_transport = node.get_value_by_key("public_transport");
-    if (m_output.options().railway_details && railway &&
-            (!strcmp(railway, "signal") || !strcmp(railway, "stop")
-             || !strcmp(railway, "buffer_stop") || !strcmp(railway, "level_crossing")
-             || !strcmp(railway, "milestone") || !strcmp(railway, "derail")
-             || !strcmp(railway, "isolated_track_section") || !strcmp(railway, "switch")
-             || !strcmp(railway, "railway_crossing"))) {
+    const feature_tags_type tags = feature_tags.extract(node.tags());
+    const char* railway = tags[FeatureTagIndexes::railway];
+    const char* public_transport = tags[FeatureTagIndexes::public_transport];
+    const tag_values::Railway railway_value = railway ? tag_values::railway(railway) : tag_values::Railway::UNKNOWN;
+    bool must_on_track = false;
+    if (m_output.options().railway_details) {
+        switch (railway_value) {
+        case tag_values::Railway::SIGNAL:
+        case tag_values::Railway::STOP:
+        case tag_values::Railway::BUFFER_STOP:
+        case tag_values::Railway::LEVEL_CROSSING:
+        case tag_values::Railway::MILESTONE:
+        case tag_values::Railway::DERAIL:
+        case tag_values::Railway::ISOLATED_TRACK_SECTION:
+        case tag_values::Railway::SWITCH:
+        case tag_values::Railway::RAILWAY_CROSSING:
+            must_on_track = true;
+            break;
+        default:
+            break;
+        }
+    }
+    if (must_on_track) {
         m_must_on_track_handles.emplace(node.id(), m_must_on_track.add_item(node));
     } else if (public_transport && !strcmp(public_transport, "stop_position")) {
         m_must_on_track_handles.emplace(node.id(), m_must_on_track.add_item(node));
     }
-    handle_stop(node, public_transport, railway);
-    if (railway && m_output.options().crossings && (!strcmp(railway, "level_crossing") || !strcmp(railway, "crossing"))) {
-        handle_crossing(node);
+    handle_stop(node, tags);
+    if (m_output.options().crossings && (railway_value == tag_values::Railway::LEVEL_CROSSING
+            || railway_value == tag_values::Railway::CROSSING)) {
+        handle_crossing(node, tags);
     }
 }
 
-void RailwayHandlerPass1::handle_crossing(const osmium::Node& node) {
+void RailwayHandlerPass1::handle_crossing(const osmium::Node& node, const feature_tags_type& tags) {
     assert(m_output.options().crossings);
-    const char* barrier = node.get_value_by_key("crossing:barrier");
-    const char* lights = node.get_value_by_key("crossing:light");
+    const char* barrier = tags[FeatureTagIndexes::crossing_barrier];
+    const char* lights = tags[FeatureTagIndexes::crossing_light];
     std::string barrier_value;
     std::string lights_value;
     if (!barrier) {
@@ -179,17 +246,39 @@ void RailwayHandlerPass1::handle_crossing(const osmium::Node& node) {
     add_crossing_node(node, CrossingIndexes::barrier, barrier_value.c_str(), CrossingIndexes::lights, lights_value.c_str());
 }
 
-void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const char* public_transport, const char* railway) {
+/*static*/ bool RailwayHandlerPass1::is_station(const char* public_transport, const char* railway,
+        const char* amenity) {
+    return (public_transport && !strcmp(public_transport, "station"))
+            || (railway && (!strcmp(railway, "station") || !strcmp(railway, "halt")
+                    || !strcmp(railway, "tram_stop") || (amenity && !strcmp(amenity, "bus_station"))));
+}
+
+/*static*/ bool RailwayHandlerPass1::is_platform(const char* public_transport, const char* railway) {
+    return (public_transport && !strcmp(public_transport, "platform")) || (railway && !strcmp(railway, "platform"));
+}
+
+/*static*/ bool RailwayHandlerPass1::needs_way_geometry(const osmium::Way& way, const Options& options) {
+    if (way.tags().empty() || !(options.stations || options.platforms) || !has_relevant_tags(way.tags())) {
+        return false;
+    }
+    const feature_tags_type tags = feature_tags.extract(way.tags());
+    const char* railway = tags[FeatureTagIndexes::railway];
+    const char* public_transport = tags[FeatureTagIndexes::public_transport];
+    return (options.stations && is_station(public_transport, railway, tags[FeatureTagIndexes::amenity]))
+            || (options.platforms && is_platform(public_transport, railway));
+}
+
+void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const feature_tags_type& tags) {
+    const char* railway = tags[FeatureTagIndexes::railway];
+    const char* public_transport = tags[FeatureTagIndexes::public_transport];
     if (m_output.options().stations) {
-        if ((public_transport && !strcmp(public_transport, "station"))
-                || (railway && (!strcmp(railway, "station") || !strcmp(railway, "halt")
-                        || !strcmp(railway, "tram_stop") || object.tags().has_tag("amenity", "bus_station")))) {
+        if (is_station(public_transport, railway, tags[FeatureTagIndexes::amenity])) {
             switch (object.type()) {
             case osmium::item_type::node :
-                add_stop_pltf_node(*m_stations, static_cast<const osmium::Node&>(object), false, true);
+                add_stop_pltf_node(*m_stations, static_cast<const osmium::Node&>(object), tags, false, true);
                 break;
             case osmium::item_type::way :
-                add_stop_pltf_way(*m_stations_l, static_cast<const osmium::Way&>(object), false, true);
+                add_stop_pltf_way(*m_stations_l, static_cast<const osmium::Way&>(object), tags, false, true);
                 break;
             default:
                 break;
@@ -198,13 +287,13 @@ void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const cha
         }
     }
     if (m_output.options().platforms) {
-        if ((public_transport && !strcmp(public_transport, "platform")) || (railway && !strcmp(railway, "platform"))) {
+        if (is_platform(public_transport, railway)) {
             switch (object.type()) {
             case osmium::item_type::node :
-                add_stop_pltf_node(*m_platforms, static_cast<const osmium::Node&>(object), true, false);
+                add_stop_pltf_node(*m_platforms, static_cast<const osmium::Node&>(object), tags, true, false);
                 break;
             case osmium::item_type::way :
-                add_stop_pltf_way(*m_platforms_l, static_cast<const osmium::Way&>(object), true, false);
+                add_stop_pltf_way(*m_platforms_l, static_cast<const osmium::Way&>(object), tags, true, false);
                 break;
             default:
                 break;
@@ -216,20 +305,24 @@ void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const cha
         return;
     }
     if (m_output.options().stops && public_transport && !strcmp(public_transport, "stop_position")) {
-        add_stop_pltf_node(*m_stops, static_cast<const osmium::Node&>(object), true, false);
+        add_stop_pltf_node(*m_stops, static_cast<const osmium::Node&>(object), tags, true, false);
         return;
     }
-    if ((m_output.options().stops || m_output.options().platforms) && object.tags().has_tag("highway", "bus_stop") && !object.tags().has_key("public_transport")) {
-        add_stop_pltf_node(*m_stops_only_highway, static_cast<const osmium::Node&>(object), false, false);
+    if ((m_output.options().stops || m_output.options().platforms) && !public_transport) {
+        const char* highway = tags[FeatureTagIndexes::highway];
+        if (highway && !strcmp(highway, "bus_stop")) {
+            add_stop_pltf_node(*m_stops_only_highway, static_cast<const osmium::Node&>(object), tags, false, false);
+        }
     }
 }
 
 void RailwayHandlerPass1::way(const osmium::Way& way) {
+    if (way.tags().empty() || !has_relevant_tags(way.tags())) {
+        return;
+    }
     try {
         if (m_output.options().stops || m_output.options().stations || m_output.options().platforms) {
-            const char* railway = way.get_value_by_key("railway");
-            const char* public_transport = way.get_value_by_key("public_transport");
-            handle_stop(way, public_transport, railway);
+            handle_stop(way, feature_tags.extract(way.tags()));
         }
     } catch (osmium::invalid_location& err) {
         m_output.verbose_output() << err.what() << '\n';
@@ -241,72 +334,68 @@ void RailwayHandlerPass1::add_crossing_node(const osmium::Node& node, const int
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(*m_crossings, m_output.factory().create_point(node));
+    OutputFeature feature = m_output.create_point_feature(*m_crossings, node);
     set_node_id(feature, node);
-    std::string the_timestamp (node.timestamp().to_iso());
-    feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
+    m_output.set_timestamp_field(feature, FieldIndexes::lastchange, node.timestamp());
     if (third_field_value) {
         feature.set_field(third_field_index, third_field_value);
     }
     if (fourth_field_value) {
         feature.set_field(fourth_field_index, fourth_field_value);
     }
-    feature.add_to_layer();
+    m_output.writer().add_feature(feature);
 }
 
-void RailwayHandlerPass1::add_stop_pltf_node(gdalcpp::Layer& layer, const osmium::Node& node, bool refs, bool amenity) {
+void RailwayHandlerPass1::add_stop_pltf_node(OutputLayer& layer, const osmium::Node& node, const feature_tags_type& tags,
+        bool refs, bool amenity) {
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(layer, m_output.factory().create_point(node));
+    OutputFeature feature = m_output.create_point_feature(layer, node);
     set_node_id(feature, node);
-    set_fields(feature, node, refs, amenity);
-    feature.add_to_layer();
+    set_fields(feature, node, tags, refs, amenity);
+    m_output.writer().add_feature(feature);
 }
 
-void RailwayHandlerPass1::add_stop_pltf_way(gdalcpp::Layer& layer, const osmium::Way& way, bool refs, bool amenity) {
+void RailwayHandlerPass1::add_stop_pltf_way(OutputLayer& layer, const osmium::Way& way, const feature_tags_type& tags,
+        bool refs, bool amenity) {
     if (!m_output.coordinates_valid(way)) {
         return;
     }
     try {
-        gdalcpp::Feature feature(layer, m_output.factory().create_linestring(way));
+        OutputFeature feature = m_output.create_linestring_feature(layer, way);
         set_way_id(feature, way);
-        set_fields(feature, way, refs, amenity);
-        feature.add_to_layer();
+        set_fields(feature, way, tags, refs, amenity);
+        m_output.writer().add_feature(feature);
     } catch (osmium::geometry_error& err) {
         m_output.verbose_output() << err.what() << '\n';
     }
 }
 
-/*static*/ void RailwayHandlerPass1::set_fields(gdalcpp::Feature& feature, const osmium::OSMObject& object,
-        bool refs, bool amenity) {
-    std::string the_timestamp (object.timestamp().to_iso());
-    feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
-    feature.set_field(StopsPlatformsStationIndexes::railway, object.get_value_by_key("railway", ""));
-    feature.set_field(StopsPlatformsStationIndexes::public_transport, object.get_value_by_key("public_transport", ""));
-    feature.set_field(StopsPlatformsStationIndexes::highway, object.get_value_by_key("highway", ""));
-    feature.set_field(StopsPlatformsStationIndexes::name, object.get_value_by_key("name", ""));
-    feature.set_field(StopsPlatformsStationIndexes::network, object.get_value_by_key("network", ""));
-    feature.set_field(StopsPlatformsStationIndexes::_operator, object.get_value_by_key("operator", ""));
+void RailwayHandlerPass1::set_fields(OutputFeature& feature, const osmium::OSMObject& object,
+        const feature_tags_type& tags, bool refs, bool amenity) {
+    m_output.set_timestamp_field(feature, FieldIndexes::lastchange, object.timestamp());
+    feature.set_field(StopsPlatformsStationIndexes::railway, tags[FeatureTagIndexes::railway]);
+    feature.set_field(StopsPlatformsStationIndexes::public_transport, tags[FeatureTagIndexes::public_transport]);
+    feature.set_field(StopsPlatformsStationIndexes::highway, tags[FeatureTagIndexes::highway]);
+    feature.set_field(StopsPlatformsStationIndexes::name, tags[FeatureTagIndexes::name]);
+    feature.set_field(StopsPlatformsStationIndexes::network, tags[FeatureTagIndexes::network]);
+    feature.set_field(StopsPlatformsStationIndexes::_operator, tags[FeatureTagIndexes::_operator]);
     if (refs) {
-        feature.set_field(StopsPlatformsIndexes::ref, object.get_value_by_key("ref", ""));
-        feature.set_field(StopsPlatformsIndexes::local_ref, object.get_value_by_key("local_ref", ""));
+        feature.set_field(StopsPlatformsIndexes::ref, tags[FeatureTagIndexes::ref]);
+        feature.set_field(StopsPlatformsIndexes::local_ref, tags[FeatureTagIndexes::local_ref]);
     }
     if (amenity) {
-        feature.set_field(StationsIndexes::amenity, object.get_value_by_key("amenity", ""));
+        feature.set_field(StationsIndexes::amenity, tags[FeatureTagIndexes::amenity]);
     }
 }
 
-/*static*/ void RailwayHandlerPass1::set_node_id(gdalcpp::Feature& feature, const osmium::Node& node) {
-    static char idbuffer[20];
-    sprintf(idbuffer, "%ld", node.id());
-    feature.set_field(FieldIndexes::node_id, idbuffer);
+void RailwayHandlerPass1::set_node_id(OutputFeature& feature, const osmium::Node& node) {
+    m_output.set_id_field(feature, FieldIndexes::node_id, node.id());
 }
 
-/*static*/ void RailwayHandlerPass1::set_way_id(gdalcpp::Feature& feature, const osmium::Way& way) {
-    static char idbuffer[20];
-    sprintf(idbuffer, "%ld", way.id());
-    feature.set_field(FieldIndexes::way_id, idbuffer);
+void RailwayHandlerPass1::set_way_id(OutputFeature& feature, const osmium::Way& way) {
+    m_output.set_id_field(feature, FieldIndexes::way_id, way.id());
 }
 
 void RailwayHandlerPass1::relation(const osmium::Relation&) {}
@@ -15,12 +15,16 @@
 #include <osmium/storage/item_stash.hpp>
 
 #include "ogr_output_base.hpp"
+#include "tag_extractor.hpp"
 
 /**
  * This handler class creates the level crossings layer and populates the map of nodes which have
  * to be referenced by a way because their tags require it (signals, points, stop positions etc.).
  */
 class RailwayHandlerPass1 : public osmium::handler::Handler {
+    /// values of the tags the handler reads, extracted once per object
+    using feature_tags_type = TagExtractor<11>::values_type;
+
     OGROutputBase m_output;
 
     /// item stash holds OSM objects to all nodes which have to be referenced by a way
@@ -30,39 +34,67 @@ class RailwayHandlerPass1 : public osmium::handler::Handler {
     std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& m_must_on_track_handles;
 
     /// GDAL layer for level crossings
-    std::unique_ptr<gdalcpp::Layer> m_crossings;
+    std::unique_ptr<OutputLayer> m_crossings;
 
     /// GDAL layer for platforms
-    std::unique_ptr<gdalcpp::Layer> m_platforms;
-    std::unique_ptr<gdalcpp::Layer> m_platforms_l;
+    std::unique_ptr<OutputLayer> m_platforms;
+    std::unique_ptr<OutputLayer> m_platforms_l;
 
     /// GDAL layer for stations
-    std::unique_ptr<gdalcpp::Layer> m_stations;
-    std::unique_ptr<gdalcpp::Layer> m_stations_l;
+    std::unique_ptr<OutputLayer> m_stations;
+    std::unique_ptr<OutputLayer> m_stations_l;
 
     /// GDAL layer for stops
-    std::unique_ptr<gdalcpp::Layer> m_stops;
+    std::unique_ptr<OutputLayer> m_stops;
 
     /// GDAL layer for stops/platforms which onyl have highway=bus_stop but no public_transport=*
-    std::unique_ptr<gdalcpp::Layer> m_stops_only_highway;
+    std::unique_ptr<OutputLayer> m_stops_only_highway;
 
-    void handle_crossing(const osmium::Node& node);
+    void handle_crossing(const osmium::Node& node, const feature_tags_type& tags);
 
     void add_crossing_node(const osmium::Node& node, const int third_field_index,
             const char* third_field_value, const int fourth_field_index, const char* fourth_field_value);
 
-    void handle_stop(const osmium::OSMObject& object, const char* public_transport, const char* railway);
-
-    void add_stop_pltf_node(gdalcpp::Layer& layer, const osmium::Node& node, bool refs, bool amenity);
-
-    void add_stop_pltf_way(gdalcpp::Layer& layer, const osmium::Way& way, bool refs, bool amenity);
+    void handle_stop(const osmium::OSMObject& object, const feature_tags_type& tags);
 
-    static void set_fields(gdalcpp::Feature& feature, const osmium::OSMObject& object,
+    void add_stop_pltf_node(OutputLayer& layer, const osmium::Node& node, const feature_tags_type& tags,
             bool refs, bool amenity);
 
-    static void set_node_id(gdalcpp::Feature& feature, const osmium::Node& node);
+    void add_stop_pltf_way(OutputLayer& layer, const osmium::Way& way, const feature_tags_type& tags,
+            bool refs, bool amenity);
 
-    static void set_way_id(gdalcpp::Feature& feature, const osmium::Way& way);
+    void set_fields(OutputFeature& feature, const osmium::OSMObject& object,
+            const feature_tags_type& tags, bool refs, bool amenity);
+
+    void set_node_id(OutputFeature& feature, const osmium::Node& node);
+
+    void set_way_id(OutputFeature& feature, const osmium::Way& way);
+
+    /**
+     * Check if the tags of an object contain any key this handler is interested in
+     * (`railway=*`, `public_transport=*` or `highway=bus_stop`).
+     *
+     * The tag list is walked only once. This is much cheaper than the lookups done by
+     * the handler methods and filters out the vast majority of all nodes and ways.
+     */
+    static bool has_relevant_tags(const osmium::TagList& tags);
+
+    /**
+     * Check if an object is a station.
+     *
+     * \param public_transport value of the `public_transport` tag (might be nullptr)
+     * \param railway value of the `railway` tag (might be nullptr)
+     * \param amenity value of the `amenity` tag (might be nullptr)
+     */
+    static bool is_station(const char* public_transport, const char* railway, const char* amenity);
+
+    /**
+     * Check if an object is a platform.
+     *
+     * \param public_transport value of the `public_transport` tag (might be nullptr)
+     * \param railway value of the `railway` tag (might be nullptr)
+     */
+    static bool is_platform(const char* public_transport, const char* railway);
 
 public:
 
@@ -72,6 +104,12 @@ public:
             osmium::ItemStash& signals, std::unordered_map<osmium::object_id_type,
             osmium::ItemStash::handle_type>& must_on_track_handles);
 
+    /**
+     * Check if the way() method will build a geometry for this way, i.e. if it needs the
+     * locations of the nodes of the way.
+     */
+    static bool needs_way_geometry(const osmium::Way& way, const Options& options);
+
     void node(const osmium::Node& node);
 
     void way(const osmium::Way&);
@@ -6,6 +6,7 @@
  */
 
 #include "railway_handler_pass2.hpp"
+#include "tag_extractor.hpp"
 
 /// indexes of fields
 struct FieldIndexes {
@@ -16,6 +17,28 @@ struct FieldIndexes {
     static constexpr int error = 3;
 };
 
+/// indexes of the values returned by point_tags
+struct PointTagIndexes {
+    static constexpr size_t switch_type = 0;
+    static constexpr size_t ref = 1;
+};
+
+/// indexes of the values returned by on_track_tags
+struct OnTrackTagIndexes {
+    static constexpr size_t railway = 0;
+    static constexpr size_t public_transport = 1;
+};
+
+namespace {
+
+    /// tags of points
+    const TagExtractor<2> point_tags {"railway:switch", "ref"};
+
+    /// tags of nodes which have to be referenced by a way
+    const TagExtractor<2> on_track_tags {"railway", "public_transport"};
+
+} // namespace
+
 RailwayHandlerPass2::RailwayHandlerPass2(OGRWriter& writer, osmium::index::IdSetDense<osmium::unsigned_object_id_type>& via_nodes,
         std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& must_on_track_handles,
         osmium::ItemStash& must_on_track, Options& options, osmium::util::VerboseOutput& verbose_output) :
@@ -28,39 +51,53 @@ RailwayHandlerPass2::RailwayHandlerPass2(OGRWriter& writer, osmium::index::IdSet
     // add fields to layers
     if (options.points) {
         m_points = m_output.writer().create_layer_ptr("points", wkbPoint);
-        m_points->add_field("node_id", OFTString, 10);
-        m_points->add_field("lastchange", OFTString, 21);
+        m_output.add_id_field(*m_points, "node_id");
+        m_output.add_timestamp_field(*m_points, "lastchange");
         m_points->add_field("type", OFTString, 50);
         m_points->add_field("ref", OFTString, 50);
     }
-    m_on_track.add_field("node_id", OFTString, 10);
-    m_on_track.add_field("lastchange", OFTString, 21);
+    m_output.add_id_field(m_on_track, "node_id");
+    m_output.add_timestamp_field(m_on_track, "lastchange");
     m_on_track.add_field("type", OFTString, 21);
     m_on_track.add_field("error", OFTString, 21);
 }
 
 void RailwayHandlerPass2::node(const osmium::Node& node) {
-    if (!m_options.points) {
+    if (!m_options.points || node.tags().empty()) {
         return;
     }
     const char* railway = node.get_value_by_key("railway");
     if (railway && !strcmp(railway, "switch")) {
-        handle_point(node);
+        if (m_defer_points) {
+            m_deferred_points_handles.push_back(m_deferred_points.add_item(node));
+        } else {
+            handle_point(node);
+        }
+    }
+}
+
+void RailwayHandlerPass2::defer_points() {
+    m_defer_points = true;
+}
+
+void RailwayHandlerPass2::write_deferred_points() {
+    for (const osmium::ItemStash::handle_type handle : m_deferred_points_handles) {
+        handle_point(static_cast<const osmium::Node&>(m_deferred_points.get_item(handle)));
     }
+    m_deferred_points_handles.clear();
+    m_deferred_points.clear();
 }
 
 void RailwayHandlerPass2::handle_point(const osmium::Node& node) {
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(*m_points, m_output.factory().create_point(node));
-    static char idbuffer[20];
-    sprintf(idbuffer, "%ld", node.id());
-    feature.set_field(FieldIndexes::node_id, idbuffer);
-    std::string the_timestamp (node.timestamp().to_iso());
-    feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
-
-    const char* switch_type = node.get_value_by_key("railway:switch");
+    OutputFeature feature = m_output.create_point_feature(*m_points, node);
+    m_output.set_id_field(feature, FieldIndexes::node_id, node.id());
+    m_output.set_timestamp_field(feature, FieldIndexes::lastchange, node.timestamp());
+
+    const TagExtractor<2>::values_type tags = point_tags.extract(node.tags());
+    const char* switch_type = tags[PointTagIndexes::switch_type];
     if (switch_type && (!strcmp(switch_type, "default") || !strcmp(switch_type, "double_slip"))) {
         feature.set_field(FieldIndexes::type, switch_type);
     } else if (switch_type && !strcmp(switch_type, "single_slip")) {
@@ -75,9 +112,8 @@ void RailwayHandlerPass2::handle_point(const osmium::Node& node) {
         feature.set_field(FieldIndexes::type, "");
     }
 
-    const char* ref = node.get_value_by_key("ref", "");
-    feature.set_field(FieldIndexes::ref, ref);
-    feature.add_to_layer();
+    feature.set_field(FieldIndexes::ref, tags[PointTagIndexes::ref]);
+    m_output.writer().add_feature(feature);
 }
 
 void RailwayHandlerPass2::way(const osmium::Way& way) {
@@ -97,8 +133,9 @@ void RailwayHandlerPass2::after_ways() {
     for (auto it = m_must_on_track_handles.begin(); it != m_must_on_track_handles.end(); ++it) {
         // get node by handle
         const osmium::Node& node = static_cast<const osmium::Node&>(m_must_on_track.get_item(it->second));
-        const char* railway = node.get_value_by_key("railway");
-        const char* public_transport = node.get_value_by_key("public_transport");
+        const TagExtractor<2>::values_type tags = on_track_tags.extract(node.tags());
+        const char* railway = tags[OnTrackTagIndexes::railway];
+        const char* public_transport = tags[OnTrackTagIndexes::public_transport];
         if (!railway && !public_transport) {
             continue;
         } else if (railway && !public_transport && !m_options.points) {
@@ -107,19 +144,16 @@ void RailwayHandlerPass2::after_ways() {
         if (!m_output.coordinates_valid(node)) {
             continue;
         }
-        gdalcpp::Feature feature(m_on_track, m_output.factory().create_point(node));
-        static char idbuffer[20];
-        sprintf(idbuffer, "%ld", node.id());
-        feature.set_field(FieldIndexes::node_id, idbuffer);
-        std::string the_timestamp (node.timestamp().to_iso());
-        feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
+        OutputFeature feature = m_output.create_point_feature(m_on_track, node);
+        m_output.set_id_field(feature, FieldIndexes::node_id, node.id());
+        m_output.set_timestamp_field(feature, FieldIndexes::lastchange, node.timestamp());
         feature.set_field(FieldIndexes::error, "not on a way");
         if (public_transport) {
             feature.set_field(FieldIndexes::type, public_transport);
         } else {
             feature.set_field(FieldIndexes::type, railway);
         }
-        feature.add_to_layer();
+        m_output.writer().add_feature(feature);
     }
 }
 
@@ -10,6 +10,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 #include <osmium/handler.hpp>
 #include <osmium/index/id_set.hpp>
@@ -37,10 +38,23 @@ class RailwayHandlerPass2 : public osmium::handler::Handler {
     Options& m_options;
 
     /// GDAL layer for nodes which should be referenced by a way but are not
-    gdalcpp::Layer m_on_track;
+    OutputLayer m_on_track;
 
     /// GDAL layer for points (`railway=switch`)
-    std::unique_ptr<gdalcpp::Layer> m_points;
+    std::unique_ptr<OutputLayer> m_points;
+
+    /**
+     * If true, points are not written when they are read but kept in m_deferred_points
+     * until write_deferred_points() is called. This is necessary if this handler runs
+     * before the turn restrictions have been read.
+     */
+    bool m_defer_points = false;
+
+    /// item stash holds all points (`railway=switch`) which have not been written yet
+    osmium::ItemStash m_deferred_points;
+
+    /// handles of the points in m_deferred_points in the order they were read
+    std::vector<osmium::ItemStash::handle_type> m_deferred_points_handles;
 
     void handle_point(const osmium::Node& node);
 
@@ -57,6 +71,17 @@ public:
 
     void after_ways();
 
+    /**
+     * Keep points in memory until write_deferred_points() is called instead of writing them immediately.
+     */
+    void defer_points();
+
+    /**
+     * Write all points which have been kept back. Call this method after all turn restrictions
+     * have been read.
+     */
+    void write_deferred_points();
+
     void relation(const osmium::Relation&);
 };
 
@@ -8,11 +8,20 @@
 #include <osmium/osm/item_type.hpp>
 
 #include "route_manager.hpp"
+#include "tag_values.hpp"
 
 
 RouteManager::RouteManager(OGRWriter& ogr_writer, Options& options, osmium::util::VerboseOutput& verbose_output) :
         m_writer(ogr_writer, options, verbose_output),
-        m_checker(m_writer) { }
+        m_checker(m_writer) {
+    if (options.threads > 1) {
+        m_pool.reset(new RouteValidationPool(options.threads, m_writer,
+                [this](const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
+                        PTv2Checker& checker) {
+                    check_route(relation, member_objects, checker);
+                }));
+    }
+}
 
 bool RouteManager::new_relation(const osmium::Relation& relation) const noexcept {
     const char* type = relation.get_value_by_key("type");
@@ -23,12 +32,30 @@ bool RouteManager::new_relation(const osmium::Relation& relation) const noexcept
     if (!route) {
         return false;
     }
-    if (!strcmp(route, "train") || !strcmp(route, "light_rail") || !strcmp(route, "subway")
-            || !strcmp(route, "tram") || !strcmp(route, "bus") || !strcmp(route, "ferry")
-            || !strcmp(route, "trolleybus") || !strcmp(route, "share_taxi")) {
+    switch (tag_values::route(route)) {
+    case tag_values::Route::TRAIN:
+    case tag_values::Route::LIGHT_RAIL:
+    case tag_values::Route::SUBWAY:
+    case tag_values::Route::TRAM:
+    case tag_values::Route::BUS:
+    case tag_values::Route::FERRY:
+    case tag_values::Route::TROLLEYBUS:
+    case tag_values::Route::SHARE_TAXI:
         return is_ptv2(relation);
+    default:
+        return false;
     }
-    return false;
+}
+
+bool RouteManager::new_member(const osmium::Relation& /*relation*/, const osmium::RelationMember& member, std::size_t /*n*/) {
+    if (member.type() == osmium::item_type::way) {
+        m_member_way_ids.set(member.positive_ref());
+    }
+    return true;
+}
+
+const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& RouteManager::member_way_ids() const noexcept {
+    return m_member_way_ids;
 }
 
 void RouteManager::complete_relation(const osmium::Relation& relation) {
@@ -37,16 +64,36 @@ void RouteManager::complete_relation(const osmium::Relation& relation) {
 
 void RouteManager::process_route(const osmium::Relation& relation) {
     std::vector<const osmium::OSMObject*> member_objects;
-    std::vector<const char*> roles;
     member_objects.reserve(relation.members().size());
-    roles.reserve(relation.members().size());
     for (const osmium::RelationMember& member : relation.members()) {
         const osmium::OSMObject* object = this->get_member_object(member);
         member_objects.push_back(object);
+    }
+    if (m_pool) {
+        m_pool->add(relation, member_objects);
+    } else {
+        check_route(relation, member_objects, m_checker);
+    }
+    m_writer.print_messages();
+}
+
+void RouteManager::finish() {
+    if (m_pool) {
+        m_pool->finish();
+    }
+    m_writer.write_aggregated_errors();
+    m_writer.print_messages();
+}
+
+void RouteManager::check_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
+        PTv2Checker& checker) {
+    std::vector<const char*> roles;
+    roles.reserve(relation.members().size());
+    for (const osmium::RelationMember& member : relation.members()) {
         roles.push_back(member.role());
     }
     if (is_ptv2(relation)) {
-        RouteError validation_result = is_valid(relation, member_objects);
+        RouteError validation_result = is_valid(relation, member_objects, checker);
         if (validation_result == RouteError::CLEAN) {
             m_writer.write_valid_route(relation, member_objects, roles);
             return;
@@ -64,11 +111,7 @@ bool RouteManager::is_ptv2(const osmium::Relation& relation) const noexcept {
     return true;
 }
 
-RouteError RouteManager::is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects) {
-    RouteError result = RouteError::CLEAN;
-    result |= m_checker.check_roles_order_and_type(relation, member_objects);
-    if (m_checker.find_gaps(relation, member_objects) > 0) {
-        result |= RouteError::UNORDERED_GAP;
-    }
-    return result;
+RouteError RouteManager::is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
+        PTv2Checker& checker) {
+    return checker.validate(relation, member_objects);
 }
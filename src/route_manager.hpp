@@ -8,8 +8,10 @@
 #ifndef SRC_ROUTE_COLLECTOR_HPP_
 #define SRC_ROUTE_COLLECTOR_HPP_
 
+#include <osmium/index/id_set.hpp>
 #include <osmium/relations/relations_manager.hpp>
 #include "ptv2_checker.hpp"
+#include "route_validation_pool.hpp"
 
 /**
  * The RouteManager class assembles relations and their members we are interested in.
@@ -18,9 +20,24 @@ class RouteManager : public osmium::relations::RelationsManager<RouteManager, tr
     RouteWriter m_writer;
     PTv2Checker m_checker;
 
+    /// threads validating the routes, empty if routes are validated by the reading thread
+    std::unique_ptr<RouteValidationPool> m_pool;
+
+    /// IDs of all ways which are members of a route relation we are interested in
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> m_member_way_ids;
+
     bool is_ptv2(const osmium::Relation& relation) const noexcept;
 
-    RouteError is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects);
+    RouteError is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
+            PTv2Checker& checker);
+
+    /**
+     * Validate a route and write it.
+     *
+     * This method can be called by multiple threads at the same time if each thread uses its own checker.
+     */
+    void check_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
+            PTv2Checker& checker);
 
 public:
     RouteManager() = delete;
@@ -29,9 +46,27 @@ public:
 
     bool new_relation(const osmium::Relation& relation) const noexcept;
 
+    bool new_member(const osmium::Relation& relation, const osmium::RelationMember& member, std::size_t n);
+
+    /**
+     * Get the IDs of all ways which are members of a route relation we are interested in.
+     *
+     * The set is complete after the first pass (reading the relations). Negative IDs are
+     * stored as their absolute value (osmium::RelationMember::positive_ref()).
+     */
+    const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& member_way_ids() const noexcept;
+
     void complete_relation(const osmium::Relation& relation);
 
     void process_route(const osmium::Relation& relation);
+
+    /**
+     * Wait until all routes have been validated if they are validated by multiple threads and
+     * write the aggregated errors.
+     *
+     * Call this method after the last relation has been completed.
+     */
+    void finish();
 };
 
 
@@ -0,0 +1,114 @@
+/*
+ * route_validation_pool.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "route_validation_pool.hpp"
+
+constexpr size_t RouteValidationPool::missing_member;
+constexpr size_t RouteValidationPool::max_queue_size;
+
+RouteValidationPool::RouteValidationPool(unsigned int thread_count, RouteWriter& writer, validate_func_type validate) :
+    m_writer(writer),
+    m_validate(std::move(validate)) {
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back(&RouteValidationPool::work, this);
+    }
+}
+
+RouteValidationPool::~RouteValidationPool() {
+    try {
+        finish();
+    } catch (...) {
+        // Exceptions have to be handled by calling finish() explicitly.
+    }
+}
+
+void RouteValidationPool::add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects) {
+    size_t size = relation.padded_size();
+    for (const osmium::OSMObject* object : member_objects) {
+        if (object) {
+            size += object->padded_size();
+        }
+    }
+    std::unique_ptr<Task> task {new Task(size)};
+    task->buffer.add_item(relation);
+    task->buffer.commit();
+    task->member_offsets.reserve(member_objects.size());
+    for (const osmium::OSMObject* object : member_objects) {
+        if (object) {
+            task->member_offsets.push_back(task->buffer.committed());
+            task->buffer.add_item(*object);
+            task->buffer.commit();
+        } else {
+            task->member_offsets.push_back(missing_member);
+        }
+    }
+    std::unique_lock<std::mutex> lock {m_mutex};
+    m_queue_not_full.wait(lock, [this]() {
+        return m_queue.size() < max_queue_size;
+    });
+    m_queue.push_back(std::move(task));
+    m_queue_not_empty.notify_one();
+}
+
+void RouteValidationPool::work() {
+    PTv2Checker checker(m_writer);
+    while (true) {
+        std::unique_ptr<Task> task;
+        {
+            std::unique_lock<std::mutex> lock {m_mutex};
+            m_queue_not_empty.wait(lock, [this]() {
+                return m_done || !m_queue.empty();
+            });
+            if (m_queue.empty()) {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queue_not_full.notify_one();
+        }
+        try {
+            run_task(*task, checker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+}
+
+void RouteValidationPool::run_task(Task& task, PTv2Checker& checker) {
+    const osmium::Relation& relation = task.buffer.get<osmium::Relation>(0);
+    std::vector<const osmium::OSMObject*> member_objects;
+    member_objects.reserve(task.member_offsets.size());
+    for (const size_t offset : task.member_offsets) {
+        if (offset == missing_member) {
+            member_objects.push_back(nullptr);
+        } else {
+            member_objects.push_back(&task.buffer.get<osmium::OSMObject>(offset));
+        }
+    }
+    m_validate(relation, member_objects, checker);
+}
+
+void RouteValidationPool::finish() {
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_done = true;
+    }
+    m_queue_not_empty.notify_all();
+    for (std::thread& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    if (m_exception) {
+        std::exception_ptr exception = m_exception;
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * route_validation_pool.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_ROUTE_VALIDATION_POOL_HPP_
+#define SRC_ROUTE_VALIDATION_POOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+
+#include "ptv2_checker.hpp"
+
+/**
+ * Pool of threads validating and writing complete route relations.
+ *
+ * The relation and its members are copied into a buffer owned by the task because the
+ * RelationsManager removes them from its stash after the relation has been handed over.
+ * Each thread has its own PTv2Checker. The checkers share one RouteWriter.
+ */
+class RouteValidationPool {
+public:
+    /// function validating a relation and writing it
+    using validate_func_type = std::function<void(const osmium::Relation&,
+            std::vector<const osmium::OSMObject*>&, PTv2Checker&)>;
+
+private:
+    struct Task {
+        osmium::memory::Buffer buffer;
+
+        /// offsets of the member objects in the buffer, missing_member if the member is not available
+        std::vector<size_t> member_offsets;
+
+        explicit Task(size_t initial_size) :
+            buffer(initial_size, osmium::memory::Buffer::auto_grow::yes),
+            member_offsets() {
+        }
+    };
+
+    /// offset of missing members
+    static constexpr size_t missing_member = static_cast<size_t>(-1);
+
+    /// maximum number of relations waiting for validation
+    static constexpr size_t max_queue_size = 1024;
+
+    RouteWriter& m_writer;
+
+    validate_func_type m_validate;
+
+    std::vector<std::thread> m_threads;
+
+    std::deque<std::unique_ptr<Task>> m_queue;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_queue_not_empty;
+
+    std::condition_variable m_queue_not_full;
+
+    /// set to true after all relations have been added
+    bool m_done = false;
+
+    /// first exception thrown by a thread, rethrown by finish()
+    std::exception_ptr m_exception;
+
+    void work();
+
+    void run_task(Task& task, PTv2Checker& checker);
+
+public:
+    RouteValidationPool() = delete;
+
+    RouteValidationPool(const RouteValidationPool&) = delete;
+
+    RouteValidationPool& operator=(const RouteValidationPool&) = delete;
+
+    /**
+     * \param thread_count number of threads
+     * \param writer writer shared by the checkers of all threads
+     * \param validate function called for each relation
+     */
+    RouteValidationPool(unsigned int thread_count, RouteWriter& writer, validate_func_type validate);
+
+    ~RouteValidationPool();
+
+    /**
+     * Copy a relation and its members and add them to the queue. This method blocks
+     * if the queue is full.
+     */
+    void add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects);
+
+    /**
+     * Wait until all relations have been validated and stop the threads.
+     *
+     * Exceptions thrown by a thread are rethrown.
+     */
+    void finish();
+};
+
+#endif /* SRC_ROUTE_VALIDATION_POOL_HPP_ */
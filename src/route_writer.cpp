@@ -5,8 +5,16 @@
  *      Author: Michael Reichert <michael.reichert@geofabrik.de>
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include <ogr_core.h>
 #include "route_writer.hpp"
+#include "tag_extractor.hpp"
 
 /// indexes of fields – all layers
 struct FieldIndexes {
@@ -49,14 +57,154 @@ struct ErrorFieldIndexes {
     static constexpr int error = 9;
 };
 
+/// indexes of fields – error lines layer if errors are aggregated
+struct AggregatedErrorFieldIndexes {
+    static constexpr int rel_count = 10;
+    static constexpr int rel_ids = 11;
+};
+
+/// indexes of the values returned by route_tags
+struct RouteTagIndexes {
+    static constexpr size_t name = 0;
+    static constexpr size_t ref = 1;
+    static constexpr size_t from = 2;
+    static constexpr size_t to = 3;
+    static constexpr size_t via = 4;
+    static constexpr size_t route = 5;
+    static constexpr size_t _operator = 6;
+};
+
+/// indexes of fields – route_ways layer
+struct RouteWayFieldIndexes {
+    static constexpr int way_id = 0;
+};
+
+/// indexes of fields – route_members layer
+struct RouteMemberFieldIndexes {
+    static constexpr int rel_id = 0;
+    static constexpr int sequence = 1;
+    static constexpr int way_id = 2;
+    static constexpr int role = 3;
+};
+
+namespace {
+
+    /// WKB geometry type of multilinestrings
+    constexpr uint32_t wkb_multilinestring = 5;
+
+    /// byte order marker of little-endian (NDR) WKB
+    constexpr char wkb_ndr = 1;
+
+    /// tags of route relations written to the output layers
+    const TagExtractor<7> route_tags {"name", "ref", "from", "to", "via", "route", "operator"};
+
+    using route_tags_type = TagExtractor<7>::values_type;
+
+    /**
+     * Set the fields which all route and error layers have in common.
+     */
+    void set_route_fields(OutputFeature& feature, const route_tags_type& tags) {
+        feature.set_field(FieldIndexes::name, tags[RouteTagIndexes::name]);
+        feature.set_field(FieldIndexes::ref, tags[RouteTagIndexes::ref]);
+        feature.set_field(FieldIndexes::from, tags[RouteTagIndexes::from]);
+        feature.set_field(FieldIndexes::to, tags[RouteTagIndexes::to]);
+        feature.set_field(FieldIndexes::via, tags[RouteTagIndexes::via]);
+        feature.set_field(FieldIndexes::route, tags[RouteTagIndexes::route]);
+    }
+
+    void append_uint32(std::string& wkb, const uint32_t value) {
+        wkb.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    /**
+     * Build a WKB multilinestring from WKB linestrings built by the WKB factory.
+     *
+     * The WKB of a multilinestring is a header followed by the WKB of its linestrings.
+     * Therefore the linestrings are copied once into a buffer of the final size.
+     */
+    std::string assemble_multilinestring(const std::vector<WayGeometryCache::geometry_type>& linestrings) {
+        size_t size = 1 + 2 * sizeof(uint32_t);
+        for (const auto& linestring : linestrings) {
+            size += linestring->size();
+        }
+        std::string wkb;
+        wkb.reserve(size);
+        wkb += wkb_ndr;
+        append_uint32(wkb, wkb_multilinestring);
+        append_uint32(wkb, static_cast<uint32_t>(linestrings.size()));
+        for (const auto& linestring : linestrings) {
+            wkb.append(*linestring);
+        }
+        return wkb;
+    }
+
+} // namespace
+
+/*static*/ wkb_factory_type& RouteWriter::thread_wkb_factory() {
+    // The geometry factory keeps the geometry under construction. Each thread needs its own one.
+    static thread_local wkb_factory_type factory;
+    return factory;
+}
+
+void RouteWriter::add_message(const char* message, bool error /* = false */) {
+    std::lock_guard<std::mutex> lock {m_messages_mutex};
+    m_messages.push_back(Message{message, error});
+}
+
+void RouteWriter::print_messages() {
+    std::vector<Message> messages;
+    {
+        std::lock_guard<std::mutex> lock {m_messages_mutex};
+        messages.swap(m_messages);
+    }
+    for (const Message& message : messages) {
+        if (message.error) {
+            std::cerr << message.text << '\n';
+        } else {
+            m_verbose_output << message.text << '\n';
+        }
+    }
+}
+
+WayGeometryCache::geometry_type RouteWriter::way_geometry(const osmium::Way& way) {
+    WayGeometryCache::geometry_type geometry = m_way_geometries.get(way.id());
+    if (geometry) {
+        return geometry;
+    }
+    return m_way_geometries.add(way.id(), thread_wkb_factory().create_linestring(way));
+}
+
+void RouteWriter::write_route_member(const osmium::Relation& relation, const size_t sequence, const osmium::Way& way,
+        const char* role) {
+    OutputFeature member(*m_route_members, std::string{});
+    set_id_field(member, RouteMemberFieldIndexes::rel_id, relation.id());
+    member.set_integer_field(RouteMemberFieldIndexes::sequence, sequence);
+    set_id_field(member, RouteMemberFieldIndexes::way_id, way.id());
+    member.set_field(RouteMemberFieldIndexes::role, role);
+    m_writer.add_feature(member);
+    {
+        std::lock_guard<std::mutex> lock {m_route_ways_mutex};
+        if (!m_route_way_ids.insert(way.id()).second) {
+            return;
+        }
+    }
+    // Each way is built only once in this mode, caching its geometry would not help.
+    OutputFeature feature(*m_route_ways, thread_wkb_factory().create_linestring(way));
+    set_id_field(feature, RouteWayFieldIndexes::way_id, way.id());
+    m_writer.add_feature(feature);
+}
+
 RouteWriter::RouteWriter(OGRWriter& writer, Options& options,
     osmium::util::VerboseOutput& verbose_output) :
         OGROutputBase(writer, verbose_output, options),
-        m_ptv2_routes_valid(m_writer.create_layer("ptv2_routes_valid", wkbMultiLineString)),
-        m_ptv2_routes_invalid(m_writer.create_layer("ptv2_routes_invalid", wkbMultiLineString)),
+        m_ptv2_routes_valid(m_writer.create_layer("ptv2_routes_valid",
+                options.normalized_routes ? wkbNone : wkbMultiLineString)),
+        m_ptv2_routes_invalid(m_writer.create_layer("ptv2_routes_invalid",
+                options.normalized_routes ? wkbNone : wkbMultiLineString)),
         m_ptv2_error_lines(m_writer.create_layer("ptv2_error_lines", wkbLineString)),
-        m_ptv2_error_points(m_writer.create_layer("ptv2_error_points", wkbPoint)) {
-    m_ptv2_routes_valid.add_field("rel_id", OFTString, 10);
+        m_ptv2_error_points(m_writer.create_layer("ptv2_error_points", wkbPoint)),
+        m_way_geometries(options.way_cache_size) {
+    add_id_field(m_ptv2_routes_valid, "rel_id");
     m_ptv2_routes_valid.add_field("from", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_valid.add_field("to", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_valid.add_field("via", OFTString, MAX_FIELD_LENGTH);
@@ -64,7 +212,7 @@ RouteWriter::RouteWriter(OGRWriter& writer, Options& options,
     m_ptv2_routes_valid.add_field("name", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_valid.add_field("route", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_valid.add_field("operator", OFTString, MAX_FIELD_LENGTH);
-    m_ptv2_routes_invalid.add_field("rel_id", OFTString, 10);
+    add_id_field(m_ptv2_routes_invalid, "rel_id");
     m_ptv2_routes_invalid.add_field("from", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_invalid.add_field("to", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_routes_invalid.add_field("via", OFTString, MAX_FIELD_LENGTH);
@@ -86,33 +234,47 @@ RouteWriter::RouteWriter(OGRWriter& writer, Options& options,
     m_ptv2_routes_invalid.add_field("stop_is_not_node", OFTString, 1);
     m_ptv2_routes_invalid.add_field("error_over_non_ferry", OFTString, 1);
     m_ptv2_routes_invalid.add_field("stops_misordered", OFTString, 1);
-    m_ptv2_error_lines.add_field("rel_id", OFTString, 10);
+    add_id_field(m_ptv2_error_lines, "rel_id");
     m_ptv2_error_lines.add_field("from", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_lines.add_field("to", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_lines.add_field("via", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_lines.add_field("ref", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_lines.add_field("name", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_lines.add_field("route", OFTString, MAX_FIELD_LENGTH);
-    m_ptv2_error_lines.add_field("way_id", OFTString, 10);
-    m_ptv2_error_lines.add_field("node_id", OFTString, 10);
+    add_id_field(m_ptv2_error_lines, "way_id");
+    add_id_field(m_ptv2_error_lines, "node_id");
     m_ptv2_error_lines.add_field("error", OFTString, 50);
-    m_ptv2_error_points.add_field("rel_id", OFTString, 10);
+    if (options.aggregate_errors) {
+        m_ptv2_error_lines.add_field("rel_count", OFTInteger, 10);
+        m_ptv2_error_lines.add_field("rel_ids", OFTString, 0);
+    }
+    add_id_field(m_ptv2_error_points, "rel_id");
     m_ptv2_error_points.add_field("from", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_points.add_field("to", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_points.add_field("via", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_points.add_field("ref", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_points.add_field("name", OFTString, MAX_FIELD_LENGTH);
     m_ptv2_error_points.add_field("route", OFTString, MAX_FIELD_LENGTH);
-    m_ptv2_error_points.add_field("way_id", OFTString, 10);
-    m_ptv2_error_points.add_field("node_id", OFTString, 10);
+    add_id_field(m_ptv2_error_points, "way_id");
+    add_id_field(m_ptv2_error_points, "node_id");
     m_ptv2_error_points.add_field("error", OFTString, 50);
+    if (options.normalized_routes) {
+        m_route_ways = m_writer.create_layer_ptr("route_ways", wkbLineString);
+        add_id_field(*m_route_ways, "way_id");
+        m_route_members = m_writer.create_layer_ptr("route_members", wkbNone);
+        add_id_field(*m_route_members, "rel_id");
+        m_route_members->add_field("sequence", OFTInteger, 10);
+        add_id_field(*m_route_members, "way_id");
+        m_route_members->add_field("role", OFTString, MAX_FIELD_LENGTH);
+    }
 }
 
 
 
 void RouteWriter::write_valid_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
         std::vector<const char*>& roles) {
-    OGRMultiLineString* ml = new OGRMultiLineString();
+    std::vector<WayGeometryCache::geometry_type> linestrings;
+    linestrings.reserve(member_objects.size());
     for (size_t i = 0; i < member_objects.size(); ++i) {
         const osmium::OSMObject* member = member_objects.at(i);
         if (!member || member->type() != osmium::item_type::way) {
@@ -127,60 +289,60 @@ void RouteWriter::write_valid_route(const osmium::Relation& relation, std::vecto
             continue;
         }
         try {
-            std::unique_ptr<OGRLineString> geom = m_factory.create_linestring(*way);
-            ml->addGeometry(geom.get());
+            if (m_route_members) {
+                write_route_member(relation, i, *way, role);
+            } else {
+                linestrings.push_back(way_geometry(*way));
+            }
         }
         catch (osmium::geometry_error& e) {
-            m_verbose_output << e.what() << '\n';
+            add_message(e.what());
         }
     }
-    gdalcpp::Feature feature(m_ptv2_routes_valid, std::unique_ptr<OGRGeometry> (ml));
-    static char idbuffer[20];
-    sprintf(idbuffer, "%ld", relation.id());
-    feature.set_field(FieldIndexes::rel_id, idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(ValidInvalidFieldIndexes::_operator, relation.get_value_by_key("operator"));
-    feature.add_to_layer();
+    // In normalized mode, the geometry is written to the route_ways table.
+    OutputFeature feature(m_ptv2_routes_valid, m_route_members ? std::string{} : assemble_multilinestring(linestrings));
+    set_id_field(feature, FieldIndexes::rel_id, relation.id());
+    const route_tags_type tags = route_tags.extract(relation.tags());
+    set_route_fields(feature, tags);
+    feature.set_field(ValidInvalidFieldIndexes::_operator, tags[RouteTagIndexes::_operator]);
+    m_writer.add_feature(feature);
 }
 
 void RouteWriter::write_invalid_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
         RouteError validation_result) {
-    OGRMultiLineString* ml = new OGRMultiLineString();
-    for (const osmium::OSMObject* member : member_objects) {
+    std::vector<WayGeometryCache::geometry_type> linestrings;
+    linestrings.reserve(member_objects.size());
+    auto member_it = relation.members().cbegin();
+    for (size_t i = 0; i < member_objects.size(); ++i, ++member_it) {
+        const osmium::OSMObject* member = member_objects.at(i);
         if (!member) {
             continue;
         }
         if (member->type() != osmium::item_type::way) {
             continue;
         }
+        const char* role = member_it->role();
         const osmium::Way* way = static_cast<const osmium::Way*>(member);
         if (!coordinates_valid(way->nodes())) {
             continue;
         }
         try {
-            std::unique_ptr<OGRLineString> geom = m_factory.create_linestring(*way);
-            ml->addGeometry(geom.get());
+            if (m_route_members) {
+                write_route_member(relation, i, *way, role);
+            } else {
+                linestrings.push_back(way_geometry(*way));
+            }
         }
         catch (osmium::geometry_error& e) {
-            std::cerr << e.what() << std::endl;
+            add_message(e.what(), true);
         }
     }
-    gdalcpp::Feature feature(m_ptv2_routes_invalid, std::unique_ptr<OGRGeometry>(ml));
-    static char idbuffer[20];
-    sprintf(idbuffer, "%ld", relation.id());
-    feature.set_field(FieldIndexes::rel_id, idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(ValidInvalidFieldIndexes::_operator, relation.get_value_by_key("operator"));
+    // In normalized mode, the geometry is written to the route_ways table.
+    OutputFeature feature(m_ptv2_routes_invalid, m_route_members ? std::string{} : assemble_multilinestring(linestrings));
+    set_id_field(feature, FieldIndexes::rel_id, relation.id());
+    const route_tags_type tags = route_tags.extract(relation.tags());
+    set_route_fields(feature, tags);
+    feature.set_field(ValidInvalidFieldIndexes::_operator, tags[RouteTagIndexes::_operator]);
     if ((validation_result & RouteError::OVER_NON_RAIL) == RouteError::OVER_NON_RAIL) {
         feature.set_field(InvalidFieldIndexes::error_over_non_rail, "T");
     }
@@ -223,7 +385,7 @@ void RouteWriter::write_invalid_route(const osmium::Relation& relation, std::vec
     if ((validation_result & RouteError::STOP_MISORDERED) == RouteError::STOP_MISORDERED) {
         feature.set_field(InvalidFieldIndexes::stops_misordered, "T");
     }
-    feature.add_to_layer();
+    m_writer.add_feature(feature);
 }
 
 #ifdef TEST_NO_ERROR_WRITING
@@ -236,31 +398,77 @@ void RouteWriter::write_error_way(const osmium::Relation& relation, const osmium
         return;
     }
     try {
-        gdalcpp::Feature feature(m_ptv2_error_lines, m_factory.create_linestring(*way));
-        static char way_idbuffer[20];
-        sprintf(way_idbuffer, "%ld", way->id());
-        feature.set_field(ErrorFieldIndexes::way_id, way_idbuffer);
-        static char node_idbuffer[20];
-        sprintf(node_idbuffer, "%ld", node_ref);
-        feature.set_field(ErrorFieldIndexes::node_id, node_idbuffer);
-        static char rel_idbuffer[20];
-        sprintf(rel_idbuffer, "%ld", relation.id());
-        feature.set_field(FieldIndexes::rel_id, rel_idbuffer);
-        feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-        feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-        feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-        feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-        feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-        feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-        feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
+        if (m_options.aggregate_errors) {
+            aggregate_error_way(relation, node_ref, error_text, *way);
+            return;
+        }
+        OutputFeature feature(m_ptv2_error_lines, std::string(*way_geometry(*way)));
+        set_id_field(feature, ErrorFieldIndexes::way_id, way->id());
+        set_id_field(feature, ErrorFieldIndexes::node_id, node_ref);
+        set_id_field(feature, FieldIndexes::rel_id, relation.id());
+        set_route_fields(feature, route_tags.extract(relation.tags()));
         feature.set_field(ErrorFieldIndexes::error, error_text);
-        feature.add_to_layer();
+        m_writer.add_feature(feature);
     } catch (osmium::geometry_error& err) {
-        m_verbose_output << err.what() << '\n';
+        add_message(err.what());
     }
 }
 #endif
 
+void RouteWriter::aggregate_error_way(const osmium::Relation& relation, const osmium::object_id_type node_ref,
+        const char* error_text, const osmium::Way& way) {
+    WayGeometryCache::geometry_type geometry = way_geometry(way);
+    std::lock_guard<std::mutex> lock {m_aggregated_errors_mutex};
+    AggregatedError& error = m_aggregated_errors[std::make_tuple(way.id(), node_ref, std::string{error_text})];
+    if (!error.geometry) {
+        error.geometry = std::move(geometry);
+    }
+    // A relation can report the same error on the same way more than once.
+    if (std::find(error.rel_ids.begin(), error.rel_ids.end(), relation.id()) != error.rel_ids.end()) {
+        return;
+    }
+    if (error.rel_ids.empty()) {
+        for (const char* value : route_tags.extract(relation.tags(), "")) {
+            error.tags.emplace_back(value);
+        }
+    } else {
+        // The tags are only written if a single relation reports the error.
+        std::vector<std::string>().swap(error.tags);
+    }
+    error.rel_ids.push_back(relation.id());
+}
+
+void RouteWriter::write_aggregated_errors() {
+    std::string rel_ids;
+    for (auto& entry : m_aggregated_errors) {
+        AggregatedError& error = entry.second;
+        std::sort(error.rel_ids.begin(), error.rel_ids.end());
+        rel_ids.clear();
+        for (const osmium::object_id_type rel_id : error.rel_ids) {
+            if (!rel_ids.empty()) {
+                rel_ids += ',';
+            }
+            rel_ids += std::to_string(rel_id);
+        }
+        OutputFeature feature(m_ptv2_error_lines, std::string(*error.geometry));
+        set_id_field(feature, FieldIndexes::rel_id, error.rel_ids.front());
+        set_id_field(feature, ErrorFieldIndexes::way_id, std::get<0>(entry.first));
+        set_id_field(feature, ErrorFieldIndexes::node_id, std::get<1>(entry.first));
+        if (error.rel_ids.size() == 1) {
+            route_tags_type tags;
+            for (size_t i = 0; i < tags.size(); ++i) {
+                tags[i] = error.tags.at(i).c_str();
+            }
+            set_route_fields(feature, tags);
+        }
+        feature.set_field(ErrorFieldIndexes::error, std::get<2>(entry.first).c_str());
+        feature.set_integer_field(AggregatedErrorFieldIndexes::rel_count, error.rel_ids.size());
+        feature.set_field(AggregatedErrorFieldIndexes::rel_ids, rel_ids.c_str());
+        m_writer.add_feature(feature);
+    }
+    m_aggregated_errors.clear();
+}
+
 void RouteWriter::write_error_point(const osmium::Relation& relation, const osmium::NodeRef* node_ref,
         const char* error_text, const osmium::object_id_type way_id) {
     write_error_point(relation, node_ref->ref(), node_ref->location(), error_text, way_id);
@@ -275,25 +483,13 @@ void RouteWriter::write_error_point(const osmium::Relation& relation, const osmi
     if (!coordinates_valid(location)) {
         return;
     }
-    gdalcpp::Feature feature(m_ptv2_error_points, m_factory.create_point(location));
-    static char way_idbuffer[20];
-    sprintf(way_idbuffer, "%ld", way_id);
-    feature.set_field(ErrorFieldIndexes::way_id, way_idbuffer);
-    static char node_idbuffer[20];
-    sprintf(node_idbuffer, "%ld", node_ref);
-    feature.set_field(ErrorFieldIndexes::node_id, node_idbuffer);
-    static char rel_idbuffer[20];
-    sprintf(rel_idbuffer, "%ld", relation.id());
-    feature.set_field(FieldIndexes::rel_id, rel_idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
+    OutputFeature feature(m_ptv2_error_points, thread_wkb_factory().create_point(location));
+    set_id_field(feature, ErrorFieldIndexes::way_id, way_id);
+    set_id_field(feature, ErrorFieldIndexes::node_id, node_ref);
+    set_id_field(feature, FieldIndexes::rel_id, relation.id());
+    set_route_fields(feature, route_tags.extract(relation.tags()));
     feature.set_field(ErrorFieldIndexes::error, error_text);
-    feature.add_to_layer();
+    m_writer.add_feature(feature);
 }
 #endif
 
@@ -8,9 +8,18 @@
 #ifndef SRC_ROUTE_WRITER_HPP_
 #define SRC_ROUTE_WRITER_HPP_
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
 #include <osmium/osm/relation.hpp>
 
 #include "ogr_output_base.hpp"
+#include "way_geometry_cache.hpp"
 
 enum class RouteType : char {
     NONE,
@@ -79,12 +88,102 @@ inline RouteError operator&(const RouteError&a , const RouteError& b) {
 /**
  * The RouteWriter class writes routes as multilinestrings and their errors (points and linestrings) to
  * the output dataset.
+ *
+ * All write methods can be called by multiple threads at the same time.
  */
 class RouteWriter : public OGROutputBase {
-    gdalcpp::Layer m_ptv2_routes_valid;
-    gdalcpp::Layer m_ptv2_routes_invalid;
-    gdalcpp::Layer m_ptv2_error_lines;
-    gdalcpp::Layer m_ptv2_error_points;
+    OutputLayer m_ptv2_routes_valid;
+    OutputLayer m_ptv2_routes_invalid;
+    OutputLayer m_ptv2_error_lines;
+    OutputLayer m_ptv2_error_points;
+
+    /// ways of routes, only written if Options::normalized_routes is set
+    std::unique_ptr<OutputLayer> m_route_ways;
+
+    /// member ways of routes, only written if Options::normalized_routes is set
+    std::unique_ptr<OutputLayer> m_route_members;
+
+    /// IDs of the ways written to m_route_ways
+    std::unordered_set<osmium::object_id_type> m_route_way_ids;
+
+    /// protects m_route_way_ids
+    std::mutex m_route_ways_mutex;
+
+    /// linestrings of ways shared by multiple routes
+    WayGeometryCache m_way_geometries;
+
+    /// error line reported by one or many relations
+    struct AggregatedError {
+        WayGeometryCache::geometry_type geometry;
+        std::vector<osmium::object_id_type> rel_ids;
+
+        /// tags of the relation written to the error lines layer, cleared if a second relation reports the error
+        std::vector<std::string> tags;
+    };
+
+    /**
+     * Error lines collected if Options::aggregate_errors is set, key is way ID, node ID
+     * and error text.
+     */
+    std::map<std::tuple<osmium::object_id_type, osmium::object_id_type, std::string>, AggregatedError> m_aggregated_errors;
+
+    /// protects m_aggregated_errors
+    std::mutex m_aggregated_errors_mutex;
+
+    struct Message {
+        std::string text;
+
+        /// print to std::cerr instead of the verbose output
+        bool error;
+    };
+
+    /**
+     * Messages for the verbose output and std::cerr. The write methods are called by the
+     * validation threads but the verbose output may only be used by the reading thread.
+     */
+    std::vector<Message> m_messages;
+
+    /// protects m_messages
+    std::mutex m_messages_mutex;
+
+    /**
+     * Add a message to be printed by print_messages().
+     *
+     * \param message text
+     * \param error Print the message to std::cerr instead of the verbose output.
+     */
+    void add_message(const char* message, bool error = false);
+
+    /**
+     * Get the WKB geometry factory of the current thread.
+     */
+    static wkb_factory_type& thread_wkb_factory();
+
+    /**
+     * Get the linestring of a way as WKB from the cache or build it.
+     *
+     * \throws osmium::geometry_error if the linestring cannot be built
+     */
+    WayGeometryCache::geometry_type way_geometry(const osmium::Way& way);
+
+    /**
+     * Write a member way of a route to the route_members table and its geometry to the
+     * route_ways table unless it has been written for another route already. The geometry
+     * is only built for ways which have not been written yet.
+     *
+     * \throws osmium::geometry_error if the geometry cannot be built, the member has been
+     *         written already then
+     */
+    void write_route_member(const osmium::Relation& relation, const size_t sequence, const osmium::Way& way,
+            const char* role);
+
+    /**
+     * Collect an error line instead of writing it.
+     *
+     * \throws osmium::geometry_error if the linestring cannot be built
+     */
+    void aggregate_error_way(const osmium::Relation& relation, const osmium::object_id_type node_ref,
+            const char* error_text, const osmium::Way& way);
 
 public:
     RouteWriter() = delete;
@@ -108,6 +207,22 @@ public:
 
     void write_error_object(const osmium::Relation& relation, const osmium::OSMObject* object, const osmium::object_id_type node_id,
             const char* error_text);
+
+    /**
+     * Write the error lines collected if Options::aggregate_errors is set. There is one feature
+     * per way, node and error with the IDs of all relations reporting it.
+     *
+     * This method must not be called while other threads write.
+     */
+    void write_aggregated_errors();
+
+    /**
+     * Print the messages collected by the write methods to the verbose output or std::cerr
+     * in the order they have been added.
+     *
+     * This method must only be called by the thread which uses the verbose output.
+     */
+    void print_messages();
 };
 
 
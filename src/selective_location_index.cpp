@@ -0,0 +1,61 @@
+/*
+ * selective_location_index.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "selective_location_index.hpp"
+
+#include <algorithm>
+
+SelectiveLocationIndex::SelectiveLocationIndex(const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& needed_nodes) :
+    m_needed_nodes(needed_nodes),
+    m_locations() {
+    m_locations.reserve(m_needed_nodes.size());
+}
+
+void SelectiveLocationIndex::set(const osmium::unsigned_object_id_type id, const osmium::Location value) {
+    if (m_needed_nodes.get(id)) {
+        m_locations.emplace_back(id, value);
+    }
+}
+
+osmium::Location SelectiveLocationIndex::get(const osmium::unsigned_object_id_type id) const {
+    const osmium::Location location = get_noexcept(id);
+    if (!location) {
+        throw osmium::not_found{id};
+    }
+    return location;
+}
+
+osmium::Location SelectiveLocationIndex::get_noexcept(const osmium::unsigned_object_id_type id) const noexcept {
+    const auto it = std::lower_bound(m_locations.begin(), m_locations.end(), id,
+            [](const element_type& element, const osmium::unsigned_object_id_type search_id) {
+                return element.first < search_id;
+            });
+    if (it == m_locations.end() || it->first != id) {
+        return osmium::Location{};
+    }
+    return it->second;
+}
+
+size_t SelectiveLocationIndex::size() const {
+    return m_locations.size();
+}
+
+size_t SelectiveLocationIndex::used_memory() const {
+    return sizeof(element_type) * m_locations.capacity();
+}
+
+void SelectiveLocationIndex::clear() {
+    m_locations.clear();
+    m_locations.shrink_to_fit();
+}
+
+void SelectiveLocationIndex::sort() {
+    // Nodes of sorted input files arrive in ascending order.
+    if (!std::is_sorted(m_locations.begin(), m_locations.end())) {
+        std::sort(m_locations.begin(), m_locations.end());
+    }
+}
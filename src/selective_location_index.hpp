@@ -0,0 +1,55 @@
+/*
+ * selective_location_index.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_SELECTIVE_LOCATION_INDEX_HPP_
+#define SRC_SELECTIVE_LOCATION_INDEX_HPP_
+
+#include <utility>
+#include <vector>
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+/**
+ * Location index which stores only the locations of nodes whose IDs are contained in a given set.
+ *
+ * The locations are stored in a sorted array of ID-location pairs. Call sort() after all nodes
+ * have been added and before the first lookup. osmium::handler::NodeLocationsForWays does this
+ * automatically.
+ */
+class SelectiveLocationIndex : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+    using element_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+    /// IDs of the nodes to be stored
+    const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& m_needed_nodes;
+
+    std::vector<element_type> m_locations;
+
+public:
+    SelectiveLocationIndex() = delete;
+
+    explicit SelectiveLocationIndex(const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& needed_nodes);
+
+    void set(const osmium::unsigned_object_id_type id, const osmium::Location value) final;
+
+    osmium::Location get(const osmium::unsigned_object_id_type id) const final;
+
+    osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final;
+
+    size_t size() const final;
+
+    size_t used_memory() const final;
+
+    void clear() final;
+
+    void sort() final;
+};
+
+#endif /* SRC_SELECTIVE_LOCATION_INDEX_HPP_ */
@@ -0,0 +1,175 @@
+/*
+ * spatial_index_builder.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "spatial_index_builder.hpp"
+#include "hilbert_curve.hpp"
+#include "sqlite_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include <sqlite3.h>
+
+namespace {
+
+    /// size of the header of a SpatiaLite geometry blob up to the end of the MBR
+    constexpr int blob_header_size = 39;
+
+    /// offset of the MBR in a SpatiaLite geometry blob
+    constexpr size_t blob_mbr_offset = 6;
+
+    /**
+     * Database connection which is closed when it goes out of scope.
+     */
+    class Connection {
+        const std::string& m_filename;
+        sqlite3* m_database = nullptr;
+
+    public:
+        Connection(const std::string& filename, const int flags) :
+            m_filename(filename) {
+            check(sqlite3_open_v2(m_filename.c_str(), &m_database, flags, nullptr), "open database");
+        }
+
+        ~Connection() {
+            sqlite3_close(m_database);
+        }
+
+        void check(int result, const char* action) {
+            sqlite_check(m_database, m_filename, result, action);
+        }
+
+        void exec(const std::string& sql) {
+            check(sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, nullptr), sql.c_str());
+        }
+
+        sqlite3_stmt* prepare(const std::string& sql) {
+            sqlite3_stmt* statement = nullptr;
+            check(sqlite3_prepare_v2(m_database, sql.c_str(), -1, &statement, nullptr), sql.c_str());
+            return statement;
+        }
+    };
+
+} // namespace
+
+SpatialIndexBuilder::SpatialIndexBuilder(const std::string& filename, osmium::util::VerboseOutput& verbose_output) :
+    m_filename(filename),
+    m_verbose_output(verbose_output) {
+}
+
+std::vector<SpatialIndexBuilder::GeometryColumn> SpatialIndexBuilder::read_geometry_columns() {
+    std::vector<GeometryColumn> columns;
+    Connection connection {m_filename, SQLITE_OPEN_READONLY};
+    sqlite3_stmt* select = connection.prepare("SELECT f_table_name, f_geometry_column FROM geometry_columns "
+            "WHERE spatial_index_enabled = 0");
+    int step;
+    while ((step = sqlite3_step(select)) == SQLITE_ROW) {
+        columns.emplace_back();
+        columns.back().table = reinterpret_cast<const char*>(sqlite3_column_text(select, 0));
+        columns.back().column = reinterpret_cast<const char*>(sqlite3_column_text(select, 1));
+    }
+    sqlite3_finalize(select);
+    connection.check(step, "read geometry_columns");
+    return columns;
+}
+
+void SpatialIndexBuilder::read_entries(GeometryColumn& column) {
+    Connection connection {m_filename, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX};
+    sqlite3_stmt* select = connection.prepare("SELECT rowid, " + sqlite_quote_identifier(column.column) + " FROM "
+            + sqlite_quote_identifier(column.table));
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+    int step;
+    while ((step = sqlite3_step(select)) == SQLITE_ROW) {
+        const unsigned char* blob = static_cast<const unsigned char*>(sqlite3_column_blob(select, 1));
+        // skip NULL geometries and big-endian blobs
+        if (!blob || sqlite3_column_bytes(select, 1) < blob_header_size || blob[0] != 0x00 || blob[1] != 0x01) {
+            continue;
+        }
+        double mbr[4];
+        std::memcpy(mbr, blob + blob_mbr_offset, sizeof(mbr));
+        Entry entry {0, sqlite3_column_int64(select, 0), mbr[0], mbr[1], mbr[2], mbr[3]};
+        min_x = std::min(min_x, entry.min_x);
+        min_y = std::min(min_y, entry.min_y);
+        max_x = std::max(max_x, entry.max_x);
+        max_y = std::max(max_y, entry.max_y);
+        column.entries.push_back(entry);
+    }
+    sqlite3_finalize(select);
+    connection.check(step, "read geometries");
+    const HilbertCurve curve {min_x, min_y, max_x, max_y};
+    for (Entry& entry : column.entries) {
+        entry.hilbert_index = curve.index((entry.min_x + entry.max_x) / 2, (entry.min_y + entry.max_y) / 2);
+    }
+    std::sort(column.entries.begin(), column.entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.hilbert_index < rhs.hilbert_index;
+    });
+}
+
+void SpatialIndexBuilder::build() {
+    std::vector<GeometryColumn> columns = read_geometry_columns();
+    {
+        std::vector<std::thread> threads;
+        for (GeometryColumn& column : columns) {
+            threads.emplace_back([this, &column]() {
+                try {
+                    read_entries(column);
+                } catch (...) {
+                    column.exception = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    for (GeometryColumn& column : columns) {
+        if (column.exception) {
+            std::rethrow_exception(column.exception);
+        }
+    }
+
+    Connection connection {m_filename, SQLITE_OPEN_READWRITE};
+    connection.exec("PRAGMA journal_mode=OFF");
+    connection.exec("PRAGMA synchronous=OFF");
+    for (GeometryColumn& column : columns) {
+        m_verbose_output << "  " << column.table << ": " << column.entries.size() << " bounding boxes\n";
+        const std::string index_name = sqlite_quote_identifier("idx_" + column.table + "_" + column.column);
+        connection.exec("BEGIN");
+        connection.exec("CREATE VIRTUAL TABLE " + index_name + " USING rtree(pkid, xmin, xmax, ymin, ymax)");
+        sqlite3_stmt* insert = connection.prepare("INSERT INTO " + index_name + " VALUES (?, ?, ?, ?, ?)");
+        for (const Entry& entry : column.entries) {
+            sqlite3_bind_int64(insert, 1, entry.id);
+            sqlite3_bind_double(insert, 2, entry.min_x);
+            sqlite3_bind_double(insert, 3, entry.max_x);
+            sqlite3_bind_double(insert, 4, entry.min_y);
+            sqlite3_bind_double(insert, 5, entry.max_y);
+            const int result = sqlite3_step(insert);
+            if (result != SQLITE_DONE) {
+                sqlite3_finalize(insert);
+                connection.check(result, "insert bounding box");
+            }
+            sqlite3_reset(insert);
+        }
+        sqlite3_finalize(insert);
+        sqlite3_stmt* update = connection.prepare("UPDATE geometry_columns SET spatial_index_enabled = 1 "
+                "WHERE f_table_name = ? AND f_geometry_column = ?");
+        sqlite3_bind_text(update, 1, column.table.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(update, 2, column.column.c_str(), -1, SQLITE_TRANSIENT);
+        const int result = sqlite3_step(update);
+        sqlite3_finalize(update);
+        connection.check(result, "enable spatial index");
+        connection.exec("COMMIT");
+        // release memory early
+        column.entries.clear();
+        column.entries.shrink_to_fit();
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * spatial_index_builder.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_SPATIAL_INDEX_BUILDER_HPP_
+#define SRC_SPATIAL_INDEX_BUILDER_HPP_
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <osmium/util/verbose_output.hpp>
+
+/**
+ * Build the SpatiaLite spatial indexes (R*Tree virtual tables `idx_<table>_<column>`) of all
+ * geometry columns of a finished SpatiaLite database.
+ *
+ * The bounding boxes are read from the headers of the geometry blobs by one thread per geometry
+ * column. Each thread sorts its bounding boxes by the Hilbert index of their centre. The sorted
+ * bounding boxes are inserted into the R*Tree in one transaction per index because SQLite
+ * supports only one writer. Inserting them in spatial order keeps the R*Tree nodes compact.
+ *
+ * The database must not be opened by another connection at the same time.
+ */
+class SpatialIndexBuilder {
+
+    struct Entry {
+        uint64_t hilbert_index;
+        int64_t id;
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+    };
+
+    struct GeometryColumn {
+        std::string table;
+        std::string column;
+        std::vector<Entry> entries;
+        std::exception_ptr exception;
+    };
+
+    std::string m_filename;
+
+    /// reference to output manager for STDERR
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    std::vector<GeometryColumn> read_geometry_columns();
+
+    /**
+     * Read and sort the bounding boxes of all geometries of a column. This method opens
+     * its own connection and can be called by multiple threads at the same time.
+     */
+    void read_entries(GeometryColumn& column);
+
+public:
+    SpatialIndexBuilder() = delete;
+
+    SpatialIndexBuilder(const std::string& filename, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Build the spatial indexes of all geometry columns and enable them in the table
+     * `geometry_columns`.
+     *
+     * \throws std::runtime_error if an SQLite error occurs
+     */
+    void build();
+};
+
+#endif /* SRC_SPATIAL_INDEX_BUILDER_HPP_ */
@@ -0,0 +1,349 @@
+/*
+ * spatialite_writer.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "spatialite_writer.hpp"
+#include "sqlite_utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+    /// WKB and SpatiaLite geometry class types
+    constexpr uint32_t geometry_point = 1;
+    constexpr uint32_t geometry_linestring = 2;
+    constexpr uint32_t geometry_multilinestring = 5;
+
+    /// markers of the SpatiaLite geometry blob format
+    constexpr char blob_start = 0x00;
+    constexpr char blob_little_endian = 0x01;
+    constexpr char blob_mbr_end = 0x7C;
+    constexpr char blob_entity = 0x69;
+    constexpr char blob_end = static_cast<char>(0xFE);
+
+    /// offset of the MBR in a SpatiaLite geometry blob
+    constexpr size_t blob_mbr_offset = 6;
+
+    /**
+     * Read little-endian WKB and write a SpatiaLite geometry blob while tracking the bounding box.
+     */
+    class BlobEncoder {
+        const char* m_data;
+        const char* m_end;
+        std::string& m_blob;
+
+        double m_min_x = std::numeric_limits<double>::max();
+        double m_min_y = std::numeric_limits<double>::max();
+        double m_max_x = std::numeric_limits<double>::lowest();
+        double m_max_y = std::numeric_limits<double>::lowest();
+
+        template <typename T>
+        T read() {
+            if (m_end - m_data < static_cast<std::ptrdiff_t>(sizeof(T))) {
+                throw std::runtime_error{"WKB geometry is truncated"};
+            }
+            T value;
+            std::memcpy(&value, m_data, sizeof(T));
+            m_data += sizeof(T);
+            return value;
+        }
+
+        template <typename T>
+        void write(const T value) {
+            m_blob.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        uint32_t read_header() {
+            if (read<char>() != blob_little_endian) {
+                throw std::runtime_error{"Big-endian WKB is not supported"};
+            }
+            return read<uint32_t>();
+        }
+
+        void copy_point() {
+            const double x = read<double>();
+            const double y = read<double>();
+            m_min_x = std::min(m_min_x, x);
+            m_min_y = std::min(m_min_y, y);
+            m_max_x = std::max(m_max_x, x);
+            m_max_y = std::max(m_max_y, y);
+            write(x);
+            write(y);
+        }
+
+        void copy_linestring() {
+            const uint32_t count = read<uint32_t>();
+            write(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                copy_point();
+            }
+        }
+
+    public:
+        BlobEncoder(const std::string& wkb, std::string& blob) :
+            m_data(wkb.data()),
+            m_end(wkb.data() + wkb.size()),
+            m_blob(blob) {
+        }
+
+        void encode(const int srid) {
+            m_blob.clear();
+            m_blob += blob_start;
+            m_blob += blob_little_endian;
+            write(static_cast<int32_t>(srid));
+            // placeholder for the MBR
+            m_blob.append(4 * sizeof(double), '\0');
+            m_blob += blob_mbr_end;
+            const uint32_t type = read_header();
+            write(type);
+            switch (type) {
+            case geometry_point:
+                copy_point();
+                break;
+            case geometry_linestring:
+                copy_linestring();
+                break;
+            case geometry_multilinestring: {
+                const uint32_t count = read<uint32_t>();
+                write(count);
+                for (uint32_t i = 0; i < count; ++i) {
+                    if (read_header() != geometry_linestring) {
+                        throw std::runtime_error{"Invalid member of a WKB multilinestring"};
+                    }
+                    m_blob += blob_entity;
+                    write(geometry_linestring);
+                    copy_linestring();
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error{"Unsupported WKB geometry type " + std::to_string(type)};
+            }
+            m_blob += blob_end;
+            if (m_min_x > m_max_x) {
+                // empty geometry
+                m_min_x = m_min_y = m_max_x = m_max_y = 0;
+            }
+            const double mbr[4] = {m_min_x, m_min_y, m_max_x, m_max_y};
+            std::memcpy(&m_blob[blob_mbr_offset], mbr, sizeof(mbr));
+        }
+    };
+
+    const char* geometry_type_name(const OGRwkbGeometryType type) {
+        switch (type) {
+        case wkbPoint:
+            return "POINT";
+        case wkbLineString:
+            return "LINESTRING";
+        case wkbMultiLineString:
+            return "MULTILINESTRING";
+        default:
+            throw std::runtime_error{"Unsupported geometry type for SpatiaLite output"};
+        }
+    }
+
+} // namespace
+
+SpatialiteWriter::SpatialiteWriter(const std::string& filename, int srid, int transaction_size) :
+    m_filename(filename),
+    m_srid(srid),
+    m_transaction_size(transaction_size) {
+    check(sqlite3_open_v2(m_filename.c_str(), &m_database, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr),
+            "open database");
+    // same settings as used for GDAL's SQLite driver
+    exec("PRAGMA journal_mode=OFF");
+    exec("PRAGMA synchronous=OFF");
+    exec("PRAGMA locking_mode=EXCLUSIVE");
+    exec("PRAGMA temp_store=MEMORY");
+    exec("PRAGMA cache_size=-614400");
+    exec("CREATE TABLE spatial_ref_sys (srid INTEGER NOT NULL PRIMARY KEY, auth_name TEXT NOT NULL, "
+            "auth_srid INTEGER NOT NULL, ref_sys_name TEXT NOT NULL DEFAULT 'Unknown', proj4text TEXT NOT NULL, "
+            "srtext TEXT NOT NULL DEFAULT 'Undefined')");
+    exec("CREATE TABLE geometry_columns (f_table_name TEXT NOT NULL, f_geometry_column TEXT NOT NULL, "
+            "geometry_type INTEGER NOT NULL, coord_dimension INTEGER NOT NULL, srid INTEGER NOT NULL, "
+            "spatial_index_enabled INTEGER NOT NULL, CONSTRAINT pk_geom_cols PRIMARY KEY (f_table_name, f_geometry_column))");
+    if (m_srid == 3857) {
+        exec("INSERT INTO spatial_ref_sys (srid, auth_name, auth_srid, ref_sys_name, proj4text) VALUES "
+                "(3857, 'epsg', 3857, 'WGS 84 / Pseudo-Mercator', '+proj=merc +a=6378137 +b=6378137 +lat_ts=0 "
+                "+lon_0=0 +x_0=0 +y_0=0 +k=1 +units=m +nadgrids=@null +wktext +no_defs')");
+    } else {
+        exec("INSERT INTO spatial_ref_sys (srid, auth_name, auth_srid, ref_sys_name, proj4text) VALUES "
+                "(4326, 'epsg', 4326, 'WGS 84', '+proj=longlat +datum=WGS84 +no_defs')");
+    }
+    begin_transaction();
+}
+
+SpatialiteWriter::~SpatialiteWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Errors have to be handled by calling close() explicitly.
+    }
+}
+
+const std::string& SpatialiteWriter::filename() const noexcept {
+    return m_filename;
+}
+
+void SpatialiteWriter::check(int result, const char* action) {
+    sqlite_check(m_database, m_filename, result, action);
+}
+
+void SpatialiteWriter::exec(const char* sql) {
+    check(sqlite3_exec(m_database, sql, nullptr, nullptr, nullptr), sql);
+}
+
+void SpatialiteWriter::begin_transaction() {
+    exec("BEGIN");
+    m_in_transaction = 0;
+}
+
+void SpatialiteWriter::commit_transaction() {
+    exec("COMMIT");
+}
+
+size_t SpatialiteWriter::create_table(const char* name, OGRwkbGeometryType type) {
+    m_tables.emplace_back(name, type);
+    return m_tables.size() - 1;
+}
+
+void SpatialiteWriter::add_column(size_t table_id, const char* name, OGRFieldType type, int width) {
+    Table& table = m_tables.at(table_id);
+    if (table.insert) {
+        throw std::runtime_error{"Cannot add columns to table " + table.name + " after features have been inserted"};
+    }
+    std::string definition = sqlite_quote_identifier(name);
+    switch (type) {
+    case OFTInteger:
+        definition += " INTEGER";
+        break;
+    case OFTInteger64:
+        definition += " BIGINT";
+        break;
+    case OFTReal:
+        definition += " FLOAT";
+        break;
+    case OFTDateTime:
+        definition += " DATETIME";
+        break;
+    default:
+        if (width > 0) {
+            definition += " VARCHAR(";
+            definition += std::to_string(width);
+            definition += ')';
+        } else {
+            definition += " VARCHAR";
+        }
+        break;
+    }
+    table.columns.push_back(std::move(definition));
+    table.column_types.push_back(type);
+}
+
+void SpatialiteWriter::prepare_insert(Table& table) {
+    const bool has_geometry = table.geometry_type != wkbNone;
+    std::string create {"CREATE TABLE "};
+    create += sqlite_quote_identifier(table.name);
+    create += " (\"ogc_fid\" INTEGER PRIMARY KEY AUTOINCREMENT";
+    if (has_geometry) {
+        create += ", \"GEOMETRY\" ";
+        create += geometry_type_name(table.geometry_type);
+    }
+    std::string insert {"INSERT INTO "};
+    insert += sqlite_quote_identifier(table.name);
+    insert += " VALUES (NULL";
+    if (has_geometry) {
+        insert += ", ?";
+    }
+    for (size_t i = 0; i < table.columns.size(); ++i) {
+        create += ", ";
+        create += table.columns[i];
+        if (table.column_types[i] == OFTDateTime) {
+            // date/time values are bound as seconds since the epoch
+            insert += ", strftime('%Y-%m-%dT%H:%M:%SZ', ?, 'unixepoch')";
+        } else {
+            insert += ", ?";
+        }
+    }
+    create += ')';
+    insert += ')';
+    exec(create.c_str());
+    if (has_geometry) {
+        std::string metadata {"INSERT INTO geometry_columns VALUES ("};
+        // The table name has to be lower case in the metadata tables of SpatiaLite.
+        std::string lower_name = table.name;
+        std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+        metadata += '\'';
+        metadata += lower_name;
+        metadata += "', 'geometry', ";
+        metadata += std::to_string(static_cast<int>(table.geometry_type));
+        metadata += ", 2, ";
+        metadata += std::to_string(m_srid);
+        metadata += ", 0)";
+        exec(metadata.c_str());
+    }
+    check(sqlite3_prepare_v2(m_database, insert.c_str(), -1, &table.insert, nullptr), insert.c_str());
+}
+
+void SpatialiteWriter::insert(size_t table_id, const FeatureRecord& record) {
+    Table& table = m_tables.at(table_id);
+    if (!table.insert) {
+        prepare_insert(table);
+    }
+    int first_field = 1;
+    if (table.geometry_type != wkbNone) {
+        if (record.wkb.empty()) {
+            // features without a geometry, e.g. routes with --normalized-routes
+            check(sqlite3_bind_null(table.insert, 1), "bind geometry");
+        } else {
+            wkb_to_blob(record.wkb, m_srid, m_blob);
+            check(sqlite3_bind_blob(table.insert, 1, m_blob.data(), static_cast<int>(m_blob.size()), SQLITE_STATIC),
+                    "bind geometry");
+        }
+        first_field = 2;
+    }
+    for (const FeatureRecord::Field& field : record.fields) {
+        if (field.type == FeatureRecord::FieldType::STRING) {
+            check(sqlite3_bind_text(table.insert, first_field + field.index, record.string_value(field),
+                    static_cast<int>(field.length), SQLITE_STATIC), "bind field");
+        } else {
+            check(sqlite3_bind_int64(table.insert, first_field + field.index, field.value), "bind field");
+        }
+    }
+    check(sqlite3_step(table.insert), "insert feature");
+    sqlite3_reset(table.insert);
+    sqlite3_clear_bindings(table.insert);
+    if (++m_in_transaction >= m_transaction_size) {
+        commit_transaction();
+        begin_transaction();
+    }
+}
+
+void SpatialiteWriter::close() {
+    if (!m_database) {
+        return;
+    }
+    for (Table& table : m_tables) {
+        if (!table.insert) {
+            // create empty tables
+            prepare_insert(table);
+        }
+        sqlite3_finalize(table.insert);
+        table.insert = nullptr;
+    }
+    commit_transaction();
+    check(sqlite3_close(m_database), "close database");
+    m_database = nullptr;
+}
+
+/*static*/ void SpatialiteWriter::wkb_to_blob(const std::string& wkb, int srid, std::string& blob) {
+    BlobEncoder encoder(wkb, blob);
+    encoder.encode(srid);
+}
@@ -0,0 +1,148 @@
+/*
+ * spatialite_writer.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_SPATIALITE_WRITER_HPP_
+#define SRC_SPATIALITE_WRITER_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gdalcpp.hpp>
+#include <sqlite3.h>
+
+#include "feature_record.hpp"
+
+/**
+ * Write layers to a SpatiaLite database using the SQLite C API directly.
+ *
+ * The layer tables have the same columns as the ones written by GDAL's SQLite driver with
+ * `SPATIALITE=YES`: an `ogc_fid` primary key, a `GEOMETRY` column and the attribute columns.
+ * Only the metadata tables `spatial_ref_sys` and `geometry_columns` (SpatiaLite 4 layout)
+ * are written. The other SpatiaLite metadata tables (`geometry_columns_auth`,
+ * `geometry_columns_statistics`, `spatialite_history` etc.) and the geometry constraint
+ * triggers are not created. GDAL's SQLite driver reads such databases but SpatiaLite
+ * functions which rely on the missing metadata might not work.
+ *
+ * Geometries are passed as little-endian WKB and converted to SpatiaLite geometry blobs.
+ */
+class SpatialiteWriter {
+
+    struct Table {
+        std::string name;
+
+        OGRwkbGeometryType geometry_type;
+
+        /// column definitions of the attribute columns
+        std::vector<std::string> columns;
+
+        /// types of the attribute columns
+        std::vector<OGRFieldType> column_types;
+
+        /// prepared INSERT statement, created when the first feature is inserted
+        sqlite3_stmt* insert = nullptr;
+
+        Table(const char* table_name, OGRwkbGeometryType type) :
+            name(table_name),
+            geometry_type(type),
+            columns(),
+            column_types() {
+        }
+    };
+
+    std::string m_filename;
+
+    sqlite3* m_database = nullptr;
+
+    int m_srid;
+
+    /// number of features inserted in a transaction
+    int m_transaction_size;
+
+    /// number of features inserted in the current transaction
+    int m_in_transaction = 0;
+
+    std::vector<Table> m_tables;
+
+    /// buffer for the geometry blob of the current feature
+    std::string m_blob;
+
+    void exec(const char* sql);
+
+    void check(int result, const char* action);
+
+    void prepare_insert(Table& table);
+
+    void begin_transaction();
+
+    void commit_transaction();
+
+public:
+    SpatialiteWriter() = delete;
+
+    SpatialiteWriter(const SpatialiteWriter&) = delete;
+
+    SpatialiteWriter& operator=(const SpatialiteWriter&) = delete;
+
+    /**
+     * Create a new database.
+     *
+     * \param filename name of the database file
+     * \param srid EPSG code of the coordinate system
+     * \param transaction_size number of features inserted per transaction
+     */
+    SpatialiteWriter(const std::string& filename, int srid, int transaction_size);
+
+    ~SpatialiteWriter();
+
+    const std::string& filename() const noexcept;
+
+    /**
+     * Create a table.
+     *
+     * \returns ID of the table
+     */
+    size_t create_table(const char* name, OGRwkbGeometryType type);
+
+    /**
+     * Add a column to a table. Columns cannot be added after the first feature has been inserted.
+     */
+    void add_column(size_t table_id, const char* name, OGRFieldType type, int width);
+
+    /**
+     * Insert a feature.
+     *
+     * The geometry has to be little-endian WKB (it is ignored for tables without geometry). An empty
+     * geometry is written as NULL.
+     * Field indexes start at 0 for the first attribute column. Date/time values are stored
+     * as ISO 8601 strings like GDAL does.
+     *
+     * \param table_id ID of the table
+     * \param record feature
+     */
+    void insert(size_t table_id, const FeatureRecord& record);
+
+    /**
+     * Commit the current transaction and close the database.
+     */
+    void close();
+
+    /**
+     * Convert a WKB geometry into the SpatiaLite geometry blob format.
+     *
+     * Supported are points, linestrings and multilinestrings without Z and M coordinates.
+     *
+     * \param wkb geometry as little-endian WKB
+     * \param srid EPSG code of the coordinate system
+     * \param blob buffer for the result (its previous contents are removed)
+     *
+     * \throws std::runtime_error if the geometry type is not supported
+     */
+    static void wkb_to_blob(const std::string& wkb, int srid, std::string& blob);
+};
+
+#endif /* SRC_SPATIALITE_WRITER_HPP_ */
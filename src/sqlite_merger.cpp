@@ -0,0 +1,154 @@
+/*
+ * sqlite_merger.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "sqlite_merger.hpp"
+#include "sqlite_utils.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace {
+
+    /**
+     * Is this table a SpatiaLite metadata table whose rows have to be merged?
+     */
+    bool is_metadata_table(const std::string& name) {
+        return name == "spatial_ref_sys" || name.compare(0, 16, "geometry_columns") == 0;
+    }
+
+    /**
+     * Roll back the open transaction and detach the source database unless release() has
+     * been called.
+     */
+    class SourceGuard {
+
+        sqlite3* m_database;
+
+        bool m_active = true;
+
+    public:
+        explicit SourceGuard(sqlite3* database) noexcept :
+            m_database(database) {
+        }
+
+        SourceGuard(const SourceGuard&) = delete;
+
+        SourceGuard& operator=(const SourceGuard&) = delete;
+
+        ~SourceGuard() {
+            if (!m_active) {
+                return;
+            }
+            // Errors are ignored because an exception is being handled already.
+            if (!sqlite3_get_autocommit(m_database)) {
+                sqlite3_exec(m_database, "ROLLBACK", nullptr, nullptr, nullptr);
+            }
+            sqlite3_exec(m_database, "DETACH DATABASE source", nullptr, nullptr, nullptr);
+        }
+
+        void release() noexcept {
+            m_active = false;
+        }
+    };
+
+} // namespace
+
+SQLiteMerger::SQLiteMerger(const std::string& filename) :
+    m_filename(filename) {
+    check(sqlite3_open_v2(m_filename.c_str(), &m_database, SQLITE_OPEN_READWRITE, nullptr), "open database");
+    exec("PRAGMA journal_mode=OFF");
+    exec("PRAGMA synchronous=OFF");
+}
+
+SQLiteMerger::~SQLiteMerger() {
+    try {
+        close();
+    } catch (...) {
+        // Errors have to be handled by calling close() explicitly.
+    }
+}
+
+void SQLiteMerger::check(int result, const char* action) {
+    sqlite_check(m_database, m_filename, result, action);
+}
+
+void SQLiteMerger::exec(const std::string& sql) {
+    check(sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, nullptr), sql.c_str());
+}
+
+void SQLiteMerger::merge(const std::string& source_filename) {
+    sqlite3_stmt* attach = nullptr;
+    check(sqlite3_prepare_v2(m_database, "ATTACH DATABASE ? AS source", -1, &attach, nullptr), "attach database");
+    sqlite3_bind_text(attach, 1, source_filename.c_str(), -1, SQLITE_TRANSIENT);
+    const int result = sqlite3_step(attach);
+    sqlite3_finalize(attach);
+    check(result, "attach database");
+    SourceGuard guard {m_database};
+
+    // name and creation statement of all tables of the source database which do not exist
+    // in the destination database, names of the metadata tables which exist in both
+    std::vector<std::pair<std::string, std::string>> new_tables;
+    std::vector<std::string> metadata_tables;
+    sqlite3_stmt* select = nullptr;
+    check(sqlite3_prepare_v2(m_database, "SELECT s.name, s.sql, m.name IS NOT NULL FROM source.sqlite_master AS s "
+            "LEFT JOIN main.sqlite_master AS m ON m.type = 'table' AND m.name = s.name "
+            "WHERE s.type = 'table' AND s.name NOT LIKE 'sqlite\\_%' ESCAPE '\\'", -1, &select, nullptr),
+            "list tables");
+    int step;
+    while ((step = sqlite3_step(select)) == SQLITE_ROW) {
+        std::string name {reinterpret_cast<const char*>(sqlite3_column_text(select, 0))};
+        const bool exists = sqlite3_column_int(select, 2);
+        if (!exists) {
+            new_tables.emplace_back(std::move(name), reinterpret_cast<const char*>(sqlite3_column_text(select, 1)));
+        } else if (is_metadata_table(name)) {
+            metadata_tables.push_back(std::move(name));
+        }
+        // Other tables which exist in both databases are SpatiaLite internals which are equal.
+    }
+    sqlite3_finalize(select);
+    check(step, "list tables");
+
+    // creation statements of all indexes and triggers of the source database which do not
+    // exist in the destination database (automatic indexes have no statement)
+    std::vector<std::string> new_indexes_triggers;
+    check(sqlite3_prepare_v2(m_database, "SELECT s.sql FROM source.sqlite_master AS s "
+            "WHERE s.type IN ('index', 'trigger') AND s.sql IS NOT NULL "
+            "AND NOT EXISTS (SELECT 1 FROM main.sqlite_master AS m WHERE m.name = s.name) "
+            "ORDER BY s.type = 'trigger'", -1, &select, nullptr),
+            "list indexes and triggers");
+    while ((step = sqlite3_step(select)) == SQLITE_ROW) {
+        new_indexes_triggers.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(select, 0)));
+    }
+    sqlite3_finalize(select);
+    check(step, "list indexes and triggers");
+
+    exec("BEGIN");
+    for (const auto& table : new_tables) {
+        exec(table.second);
+        exec("INSERT INTO main." + sqlite_quote_identifier(table.first) + " SELECT * FROM source." + sqlite_quote_identifier(table.first));
+    }
+    // Metadata rows are copied after the tables they refer to have been created.
+    for (const auto& table : metadata_tables) {
+        exec("INSERT OR IGNORE INTO main." + sqlite_quote_identifier(table) + " SELECT * FROM source." + sqlite_quote_identifier(table));
+    }
+    // Indexes and triggers are created after the rows have been copied. Indexes are built
+    // faster at once and the triggers must not fire for the copied rows.
+    for (const auto& sql : new_indexes_triggers) {
+        exec(sql);
+    }
+    exec("COMMIT");
+    exec("DETACH DATABASE source");
+    guard.release();
+}
+
+void SQLiteMerger::close() {
+    if (!m_database) {
+        return;
+    }
+    check(sqlite3_close(m_database), "close database");
+    m_database = nullptr;
+}
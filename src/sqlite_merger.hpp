@@ -0,0 +1,62 @@
+/*
+ * sqlite_merger.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_SQLITE_MERGER_HPP_
+#define SRC_SQLITE_MERGER_HPP_
+
+#include <string>
+
+#include <sqlite3.h>
+
+/**
+ * Copy the tables of SQLite/SpatiaLite databases into another database.
+ *
+ * Each source database is attached to the destination database. Tables which do not exist
+ * in the destination database yet are created with the statement they were created with and
+ * their rows are copied with `INSERT INTO ... SELECT * FROM ...`. Because both tables have
+ * the same definition, SQLite copies the records without decoding them. The rows of the
+ * SpatiaLite metadata tables (`spatial_ref_sys` and `geometry_columns*`) are merged.
+ * Indexes and triggers which do not exist in the destination database are created after the
+ * rows have been copied.
+ */
+class SQLiteMerger {
+
+    std::string m_filename;
+
+    sqlite3* m_database = nullptr;
+
+    void exec(const std::string& sql);
+
+    void check(int result, const char* action);
+
+public:
+    SQLiteMerger() = delete;
+
+    SQLiteMerger(const SQLiteMerger&) = delete;
+
+    SQLiteMerger& operator=(const SQLiteMerger&) = delete;
+
+    /**
+     * \param filename existing database to copy the tables into
+     */
+    explicit SQLiteMerger(const std::string& filename);
+
+    ~SQLiteMerger();
+
+    /**
+     * Copy all tables, indexes and triggers of a database into the destination database.
+     *
+     * The changes are rolled back and the source database is detached if copying fails.
+     *
+     * \throws std::runtime_error if an SQLite call fails
+     */
+    void merge(const std::string& source_filename);
+
+    void close();
+};
+
+#endif /* SRC_SQLITE_MERGER_HPP_ */
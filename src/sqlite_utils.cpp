@@ -0,0 +1,34 @@
+/*
+ * sqlite_utils.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "sqlite_utils.hpp"
+
+#include <stdexcept>
+
+std::string sqlite_quote_identifier(const std::string& identifier) {
+    std::string result {"\""};
+    for (const char c : identifier) {
+        if (c == '"') {
+            result += '"';
+        }
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+void sqlite_check(sqlite3* database, const std::string& filename, int result, const char* action) {
+    if (result != SQLITE_OK && result != SQLITE_DONE && result != SQLITE_ROW) {
+        std::string message {"SQLite error in "};
+        message += filename;
+        message += " (";
+        message += action;
+        message += "): ";
+        message += database ? sqlite3_errmsg(database) : sqlite3_errstr(result);
+        throw std::runtime_error{message};
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * sqlite_utils.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_SQLITE_UTILS_HPP_
+#define SRC_SQLITE_UTILS_HPP_
+
+#include <string>
+
+#include <sqlite3.h>
+
+/**
+ * Quote an SQL identifier (table or column name) with double quotes.
+ */
+std::string sqlite_quote_identifier(const std::string& identifier);
+
+/**
+ * Throw an exception if the result code of an SQLite function call indicates an error.
+ *
+ * \param database database connection (can be nullptr if opening the database failed)
+ * \param filename name of the database file (used in the error message)
+ * \param result result code
+ * \param action description of the failed action (used in the error message)
+ *
+ * \throws std::runtime_error
+ */
+void sqlite_check(sqlite3* database, const std::string& filename, int result, const char* action);
+
+#endif /* SRC_SQLITE_UTILS_HPP_ */
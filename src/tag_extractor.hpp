@@ -0,0 +1,84 @@
+/*
+ * tag_extractor.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_TAG_EXTRACTOR_HPP_
+#define SRC_TAG_EXTRACTOR_HPP_
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+
+#include <osmium/osm/tag.hpp>
+
+#include "tag_values.hpp"
+
+/**
+ * Read the values of a fixed set of keys from a tag list in a single pass.
+ *
+ * OSMObject::get_value_by_key() walks the whole tag list for every key. An extractor is set
+ * up once with the keys a layer needs and fills all values at once. The index of a value
+ * is the index of its key in the list passed to the constructor.
+ *
+ * Instances are immutable after construction and can be shared by multiple threads.
+ */
+template <std::size_t N>
+class TagExtractor {
+public:
+    using values_type = std::array<const char*, N>;
+
+private:
+    std::array<const char*, N> m_keys;
+
+    /// hashes of m_keys, compared before the keys themselves
+    std::array<uint32_t, N> m_hashes;
+
+public:
+    TagExtractor() = delete;
+
+    /**
+     * \param keys exactly N keys, the pointers have to stay valid as long as the extractor
+     */
+    template <typename... TKeys>
+    TagExtractor(TKeys... keys) :
+        m_keys{{static_cast<const char*>(keys)...}} {
+        static_assert(sizeof...(TKeys) == N, "TagExtractor<N> needs exactly N keys");
+        for (std::size_t i = 0; i < N; ++i) {
+            m_hashes[i] = tag_values::hash(m_keys[i]);
+        }
+    }
+
+    /**
+     * Get the values of all keys.
+     *
+     * \param tags tag list to read
+     * \param default_value value of keys which are missing
+     *
+     * \returns values of the keys, the pointers point into the tag list
+     */
+    values_type extract(const osmium::TagList& tags, const char* default_value = nullptr) const {
+        values_type values;
+        values.fill(default_value);
+        std::bitset<N> found;
+        for (const osmium::Tag& tag : tags) {
+            const uint32_t key_hash = tag_values::hash(tag.key());
+            for (std::size_t i = 0; i < N; ++i) {
+                if (m_hashes[i] == key_hash && !found[i] && !std::strcmp(m_keys[i], tag.key())) {
+                    values[i] = tag.value();
+                    found.set(i);
+                    break;
+                }
+            }
+            if (found.all()) {
+                break;
+            }
+        }
+        return values;
+    }
+};
+
+#endif /* SRC_TAG_EXTRACTOR_HPP_ */
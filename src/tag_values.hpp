@@ -0,0 +1,172 @@
+/*
+ * tag_values.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_TAG_VALUES_HPP_
+#define SRC_TAG_VALUES_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Classification of the values of frequently checked tags.
+ *
+ * A value is hashed once (FNV-1a) and dispatched by a switch statement whose case labels are
+ * hashes computed at compile time. A single strcmp() with the value of the matching label
+ * rules out hash collisions with unknown values. Collisions between two known values of the
+ * same key are detected by the compiler as duplicate case labels.
+ */
+namespace tag_values {
+
+    /// values of the `railway` key
+    enum class Railway : char {
+        UNKNOWN = 0,
+        RAIL,
+        LIGHT_RAIL,
+        TRAM,
+        SUBWAY,
+        FUNICULAR,
+        PRESERVED,
+        MINIATURE,
+        NARROW_GAUGE,
+        SIGNAL,
+        STOP,
+        BUFFER_STOP,
+        LEVEL_CROSSING,
+        CROSSING,
+        MILESTONE,
+        DERAIL,
+        ISOLATED_TRACK_SECTION,
+        SWITCH,
+        RAILWAY_CROSSING,
+        STATION,
+        HALT,
+        TRAM_STOP,
+        PLATFORM
+    };
+
+    /// values of the `highway` key
+    enum class Highway : char {
+        UNKNOWN = 0,
+        MOTORWAY,
+        MOTORWAY_LINK,
+        TRUNK,
+        TRUNK_LINK,
+        PRIMARY,
+        PRIMARY_LINK,
+        SECONDARY,
+        SECONDARY_LINK,
+        TERTIARY,
+        TERTIARY_LINK,
+        UNCLASSIFIED,
+        RESIDENTIAL,
+        SERVICE,
+        TRACK,
+        PEDESTRIAN,
+        LIVING_STREET,
+        BUS_GUIDEWAY,
+        BUSWAY
+    };
+
+    /// values of the `route` key of route relations
+    enum class Route : char {
+        UNKNOWN = 0,
+        TRAIN,
+        LIGHT_RAIL,
+        SUBWAY,
+        TRAM,
+        BUS,
+        TROLLEYBUS,
+        FERRY,
+        AERIALWAY,
+        SHARE_TAXI
+    };
+
+    /**
+     * FNV-1a hash of a null-terminated string, usable in constant expressions.
+     */
+    constexpr uint32_t hash(const char* str, const uint32_t value = 2166136261u) noexcept {
+        return *str ? hash(str + 1, (value ^ static_cast<uint8_t>(*str)) * 16777619u) : value;
+    }
+
+    /**
+     * Return the classification of a value if it equals the value of the matching case label.
+     */
+    template <typename TEnum>
+    inline TEnum verified(const char* value, const char* expected, const TEnum result) noexcept {
+        return std::strcmp(value, expected) ? TEnum::UNKNOWN : result;
+    }
+
+    inline Railway railway(const char* value) noexcept {
+        switch (hash(value)) {
+        case hash("rail"): return verified(value, "rail", Railway::RAIL);
+        case hash("light_rail"): return verified(value, "light_rail", Railway::LIGHT_RAIL);
+        case hash("tram"): return verified(value, "tram", Railway::TRAM);
+        case hash("subway"): return verified(value, "subway", Railway::SUBWAY);
+        case hash("funicular"): return verified(value, "funicular", Railway::FUNICULAR);
+        case hash("preserved"): return verified(value, "preserved", Railway::PRESERVED);
+        case hash("miniature"): return verified(value, "miniature", Railway::MINIATURE);
+        case hash("narrow_gauge"): return verified(value, "narrow_gauge", Railway::NARROW_GAUGE);
+        case hash("signal"): return verified(value, "signal", Railway::SIGNAL);
+        case hash("stop"): return verified(value, "stop", Railway::STOP);
+        case hash("buffer_stop"): return verified(value, "buffer_stop", Railway::BUFFER_STOP);
+        case hash("level_crossing"): return verified(value, "level_crossing", Railway::LEVEL_CROSSING);
+        case hash("crossing"): return verified(value, "crossing", Railway::CROSSING);
+        case hash("milestone"): return verified(value, "milestone", Railway::MILESTONE);
+        case hash("derail"): return verified(value, "derail", Railway::DERAIL);
+        case hash("isolated_track_section"): return verified(value, "isolated_track_section", Railway::ISOLATED_TRACK_SECTION);
+        case hash("switch"): return verified(value, "switch", Railway::SWITCH);
+        case hash("railway_crossing"): return verified(value, "railway_crossing", Railway::RAILWAY_CROSSING);
+        case hash("station"): return verified(value, "station", Railway::STATION);
+        case hash("halt"): return verified(value, "halt", Railway::HALT);
+        case hash("tram_stop"): return verified(value, "tram_stop", Railway::TRAM_STOP);
+        case hash("platform"): return verified(value, "platform", Railway::PLATFORM);
+        default: return Railway::UNKNOWN;
+        }
+    }
+
+    inline Highway highway(const char* value) noexcept {
+        switch (hash(value)) {
+        case hash("motorway"): return verified(value, "motorway", Highway::MOTORWAY);
+        case hash("motorway_link"): return verified(value, "motorway_link", Highway::MOTORWAY_LINK);
+        case hash("trunk"): return verified(value, "trunk", Highway::TRUNK);
+        case hash("trunk_link"): return verified(value, "trunk_link", Highway::TRUNK_LINK);
+        case hash("primary"): return verified(value, "primary", Highway::PRIMARY);
+        case hash("primary_link"): return verified(value, "primary_link", Highway::PRIMARY_LINK);
+        case hash("secondary"): return verified(value, "secondary", Highway::SECONDARY);
+        case hash("secondary_link"): return verified(value, "secondary_link", Highway::SECONDARY_LINK);
+        case hash("tertiary"): return verified(value, "tertiary", Highway::TERTIARY);
+        case hash("tertiary_link"): return verified(value, "tertiary_link", Highway::TERTIARY_LINK);
+        case hash("unclassified"): return verified(value, "unclassified", Highway::UNCLASSIFIED);
+        case hash("residential"): return verified(value, "residential", Highway::RESIDENTIAL);
+        case hash("service"): return verified(value, "service", Highway::SERVICE);
+        case hash("track"): return verified(value, "track", Highway::TRACK);
+        case hash("pedestrian"): return verified(value, "pedestrian", Highway::PEDESTRIAN);
+        case hash("living_street"): return verified(value, "living_street", Highway::LIVING_STREET);
+        case hash("bus_guideway"): return verified(value, "bus_guideway", Highway::BUS_GUIDEWAY);
+        case hash("busway"): return verified(value, "busway", Highway::BUSWAY);
+        default: return Highway::UNKNOWN;
+        }
+    }
+
+    inline Route route(const char* value) noexcept {
+        switch (hash(value)) {
+        case hash("train"): return verified(value, "train", Route::TRAIN);
+        case hash("light_rail"): return verified(value, "light_rail", Route::LIGHT_RAIL);
+        case hash("subway"): return verified(value, "subway", Route::SUBWAY);
+        case hash("tram"): return verified(value, "tram", Route::TRAM);
+        case hash("bus"): return verified(value, "bus", Route::BUS);
+        case hash("trolleybus"): return verified(value, "trolleybus", Route::TROLLEYBUS);
+        case hash("ferry"): return verified(value, "ferry", Route::FERRY);
+        case hash("aerialway"): return verified(value, "aerialway", Route::AERIALWAY);
+        case hash("share_taxi"): return verified(value, "share_taxi", Route::SHARE_TAXI);
+        default: return Route::UNKNOWN;
+        }
+    }
+
+} // namespace tag_values
+
+#endif /* SRC_TAG_VALUES_HPP_ */
@@ -0,0 +1,46 @@
+/*
+ * way_geometry_cache.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "way_geometry_cache.hpp"
+
+WayGeometryCache::WayGeometryCache(size_t capacity) :
+    m_capacity(capacity) {
+    m_index.reserve(capacity);
+}
+
+WayGeometryCache::geometry_type WayGeometryCache::get(const osmium::object_id_type way_id) {
+    if (m_capacity == 0) {
+        return geometry_type{};
+    }
+    std::lock_guard<std::mutex> lock {m_mutex};
+    auto it = m_index.find(way_id);
+    if (it == m_index.end()) {
+        return geometry_type{};
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->second;
+}
+
+WayGeometryCache::geometry_type WayGeometryCache::add(const osmium::object_id_type way_id, std::string&& wkb) {
+    geometry_type geometry = std::make_shared<const std::string>(std::move(wkb));
+    if (m_capacity == 0) {
+        return geometry;
+    }
+    std::lock_guard<std::mutex> lock {m_mutex};
+    auto it = m_index.find(way_id);
+    if (it != m_index.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+    m_entries.emplace_front(way_id, geometry);
+    m_index.emplace(way_id, m_entries.begin());
+    if (m_entries.size() > m_capacity) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    return geometry;
+}
@@ -0,0 +1,75 @@
+/*
+ * way_geometry_cache.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_WAY_GEOMETRY_CACHE_HPP_
+#define SRC_WAY_GEOMETRY_CACHE_HPP_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <osmium/osm/types.hpp>
+
+/**
+ * Bounded cache of the linestring geometries of ways (as WKB) keyed by way ID.
+ *
+ * Ways shared by many routes are projected and converted only once. If the cache is full,
+ * the least recently used geometry is evicted. Geometries are shared with the callers, so
+ * an evicted geometry stays valid as long as a caller holds it.
+ *
+ * All methods can be called by multiple threads at the same time.
+ */
+class WayGeometryCache {
+public:
+    using geometry_type = std::shared_ptr<const std::string>;
+
+private:
+    using entry_type = std::pair<osmium::object_id_type, geometry_type>;
+
+    /// entries, the most recently used one first
+    std::list<entry_type> m_entries;
+
+    std::unordered_map<osmium::object_id_type, std::list<entry_type>::iterator> m_index;
+
+    /// protects m_entries and m_index
+    std::mutex m_mutex;
+
+    /// maximum number of entries, 0 disables the cache
+    size_t m_capacity;
+
+public:
+    WayGeometryCache() = delete;
+
+    WayGeometryCache(const WayGeometryCache&) = delete;
+
+    WayGeometryCache& operator=(const WayGeometryCache&) = delete;
+
+    /**
+     * \param capacity maximum number of cached geometries, 0 disables the cache
+     */
+    explicit WayGeometryCache(size_t capacity);
+
+    /**
+     * Get the geometry of a way.
+     *
+     * \returns the geometry or an empty pointer if the way is not cached
+     */
+    geometry_type get(const osmium::object_id_type way_id);
+
+    /**
+     * Add the geometry of a way. If another thread has added the same way in the meantime,
+     * its geometry is kept.
+     *
+     * \returns the cached geometry of the way
+     */
+    geometry_type add(const osmium::object_id_type way_id, std::string&& wkb);
+};
+
+#endif /* SRC_WAY_GEOMETRY_CACHE_HPP_ */
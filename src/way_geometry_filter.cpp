@@ -0,0 +1,18 @@
+/*
+ * way_geometry_filter.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "way_geometry_filter.hpp"
+#include "railway_handler_pass1.hpp"
+
+WayGeometryFilter::WayGeometryFilter(const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& member_ways,
+        const Options& options) :
+        m_member_ways(member_ways),
+        m_options(options) {}
+
+bool WayGeometryFilter::operator()(const osmium::Way& way) const {
+    return m_member_ways.get(way.positive_id()) || RailwayHandlerPass1::needs_way_geometry(way, m_options);
+}
@@ -0,0 +1,41 @@
+/*
+ * way_geometry_filter.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef SRC_WAY_GEOMETRY_FILTER_HPP_
+#define SRC_WAY_GEOMETRY_FILTER_HPP_
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "options.hpp"
+
+/**
+ * Decide if the geometry of a way will be built by any handler, i.e. if the
+ * locations of its nodes are required.
+ *
+ * This is the case for members of route relations (RouteManager) and for
+ * platforms and stations (RailwayHandlerPass1).
+ */
+class WayGeometryFilter {
+    /**
+     * IDs of all ways which are members of route relations. Negative IDs are stored as their
+     * absolute value, a way sharing it with a member is accepted needlessly.
+     */
+    const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& m_member_ways;
+
+    const Options& m_options;
+
+public:
+    WayGeometryFilter() = delete;
+
+    WayGeometryFilter(const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& member_ways,
+            const Options& options);
+
+    bool operator()(const osmium::Way& way) const;
+};
+
+#endif /* SRC_WAY_GEOMETRY_FILTER_HPP_ */
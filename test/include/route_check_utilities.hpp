@@ -0,0 +1,38 @@
+/*
+ * route_check_utilities.hpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+/**
+ * Helper methods used by the tests of PTv2Checker.
+ */
+
+#ifndef TEST_INCLUDE_ROUTE_CHECK_UTILITIES_HPP_
+#define TEST_INCLUDE_ROUTE_CHECK_UTILITIES_HPP_
+
+#include <vector>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <ptv2_checker.hpp>
+
+namespace test_utils {
+
+    /**
+     * Run check_roles_order_and_type() and find_gaps() separately and combine their results the
+     * way PTv2Checker::validate() is expected to do.
+     */
+    inline RouteError run_separate_checks(PTv2Checker& checker, const osmium::Relation& relation,
+            std::vector<const osmium::OSMObject*>& objects) {
+        RouteError error = checker.check_roles_order_and_type(relation, objects);
+        if (checker.find_gaps(relation, objects) > 0) {
+            error |= RouteError::UNORDERED_GAP;
+        }
+        return error;
+    }
+
+}
+
+
+#endif /* TEST_INCLUDE_ROUTE_CHECK_UTILITIES_HPP_ */
@@ -0,0 +1,53 @@
+/*
+ * test_block_delta_map.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <block_delta_map.hpp>
+
+using map_type = BlockDeltaMap<osmium::unsigned_object_id_type, osmium::Location>;
+
+TEST_CASE("block delta map returns locations added in ascending order") {
+    map_type map;
+    const size_t count = 3 * map_type::block_size + 7;
+    for (size_t i = 0; i < count; ++i) {
+        map.set(10 + 3 * i, osmium::Location{static_cast<int32_t>(i * 1000) - 50000, 900000000 - static_cast<int32_t>(i * 17)});
+    }
+    map.sort();
+    REQUIRE(map.size() == count);
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(map.get(10 + 3 * i) == (osmium::Location{static_cast<int32_t>(i * 1000) - 50000, 900000000 - static_cast<int32_t>(i * 17)}));
+    }
+    REQUIRE_FALSE(map.get_noexcept(11));
+    REQUIRE_FALSE(map.get_noexcept(1));
+    REQUIRE_FALSE(map.get_noexcept(10 + 3 * count));
+    REQUIRE_THROWS_AS(map.get(12), osmium::not_found);
+}
+
+TEST_CASE("block delta map handles large coordinate differences") {
+    map_type map;
+    map.set(1, osmium::Location{-1800000000, -900000000});
+    map.set(2, osmium::Location{1800000000, 900000000});
+    map.set(1000000000000, osmium::Location{-1800000000, 900000000});
+    REQUIRE(map.get(1) == (osmium::Location{-1800000000, -900000000}));
+    REQUIRE(map.get(2) == (osmium::Location{1800000000, 900000000}));
+    REQUIRE(map.get(1000000000000) == (osmium::Location{-1800000000, 900000000}));
+}
+
+TEST_CASE("block delta map accepts IDs out of order") {
+    map_type map;
+    map.set(100, osmium::Location{1, 1});
+    map.set(200, osmium::Location{2, 2});
+    map.set(150, osmium::Location{3, 3});
+    map.set(50, osmium::Location{4, 4});
+    map.sort();
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.get(150) == (osmium::Location{3, 3}));
+    REQUIRE(map.get(50) == (osmium::Location{4, 4}));
+    REQUIRE(map.get(200) == (osmium::Location{2, 2}));
+    REQUIRE_FALSE(map.get_noexcept(75));
+}
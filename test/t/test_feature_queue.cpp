@@ -0,0 +1,77 @@
+/*
+ * test_feature_queue.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <feature_queue.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    std::unique_ptr<FeatureRecord> make_record(const size_t layer, const char* name) {
+        std::unique_ptr<FeatureRecord> record {new FeatureRecord{layer, std::string{"wkb"}}};
+        record->add_string(0, name);
+        return record;
+    }
+
+} // namespace
+
+TEST_CASE("feature queue writes all features in order") {
+    std::vector<std::string> written;
+    FeatureQueue queue {[&written](FeatureRecord& record) {
+        written.push_back(std::to_string(record.layer_id) + record.wkb + record.string_value(record.fields.front()));
+    }};
+    for (size_t i = 0; i < 1000; ++i) {
+        queue.push(make_record(i, "a"));
+    }
+    queue.flush();
+    REQUIRE(written.size() == 1000);
+    for (size_t i = 0; i < written.size(); ++i) {
+        CHECK(written[i] == std::to_string(i) + "wkba");
+    }
+}
+
+TEST_CASE("feature queue writes queued features before it is destroyed") {
+    std::vector<size_t> written;
+    {
+        FeatureQueue queue {[&written](FeatureRecord& record) {
+            // give the main thread a chance to destroy the queue while features are queued
+            std::this_thread::yield();
+            written.push_back(record.layer_id);
+        }};
+        for (size_t i = 0; i < 100; ++i) {
+            queue.push(make_record(i, "b"));
+        }
+    }
+    REQUIRE(written.size() == 100);
+    CHECK(written.back() == 99);
+}
+
+TEST_CASE("feature queue rethrows exceptions of the writer thread") {
+    std::vector<size_t> written;
+    FeatureQueue queue {[&written](FeatureRecord& record) {
+        if (record.layer_id == 2) {
+            throw std::runtime_error{"write failed"};
+        }
+        written.push_back(record.layer_id);
+    }};
+    for (size_t i = 0; i < 5; ++i) {
+        queue.push(make_record(i, "c"));
+    }
+    REQUIRE_THROWS_AS(queue.flush(), const std::runtime_error&);
+    REQUIRE(written.size() == 4);
+
+    // the exception is reported only once
+    queue.push(make_record(5, "c"));
+    REQUIRE_NOTHROW(queue.flush());
+    REQUIRE(written.size() == 5);
+}
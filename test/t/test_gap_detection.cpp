@@ -7,6 +7,7 @@
 
 #include "catch.hpp"
 #include "object_builder_utilities.hpp"
+#include "route_check_utilities.hpp"
 
 #include <sys/stat.h>
 #include <stdio.h>
@@ -351,3 +352,115 @@ TEST_CASE("check if gap detection works") {
         exit(1);
     }
 }
+
+
+TEST_CASE("validate() reports gaps like find_gaps()") {
+    Options options;
+    options.output_directory = ".tmp-";
+    options.output_format = "GeoJSON";
+    srand (time(NULL));
+    options.output_directory += std::to_string(rand());
+    options.output_directory += "-testoutput.sqlite";
+    if (test_utils::file_exists(options.output_directory)) {
+        std::cerr << options.output_directory << " already exists!\n";
+        exit(1);
+    }
+    if (mkdir(options.output_directory.c_str(), 0744) != 0) {
+        std::cerr << "Failed to create directory " << options.output_directory << '\n';
+        exit(1);
+    }
+
+    osmium::util::VerboseOutput vout {false};
+    OGRWriter ogr_writer{options, vout};
+    RouteWriter writer (ogr_writer, options, vout);
+    PTv2Checker checker(writer);
+
+    std::vector<osmium::item_type> types = {NODE, NODE, WAY, WAY, WAY};
+    std::vector<osmium::object_id_type> ids = {1, 2, 1, 2, 3};
+    std::vector<std::string> roles = {"platform", "platform", "", "", ""};
+
+    std::map<std::string, std::string> tags1;
+    tags1.emplace("highway", "secondary");
+
+    static constexpr int buffer_size = 10 * 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+
+    std::map<std::string, std::string> tags_rel = test_utils::get_bus_route_tags();
+
+    SECTION("three ways, no gaps") {
+        std::vector<const osmium::NodeRef*> node_refs1 {new osmium::NodeRef(1), new osmium::NodeRef(2), new osmium::NodeRef(3), new osmium::NodeRef(4)};
+        std::vector<const osmium::NodeRef*> node_refs2 {new osmium::NodeRef(4), new osmium::NodeRef(5), new osmium::NodeRef(6), new osmium::NodeRef(7)};
+        std::vector<const osmium::NodeRef*> node_refs3 {new osmium::NodeRef(7), new osmium::NodeRef(8), new osmium::NodeRef(9)};
+
+        osmium::Way& way1 = test_utils::create_way(buffer, 1, node_refs1, tags1);
+        buffer.commit();
+        osmium::Way& way2 = test_utils::create_way(buffer, 2, node_refs2, tags1);
+        buffer.commit();
+        osmium::Way& way3 = test_utils::create_way(buffer, 3, node_refs3, tags1);
+        buffer.commit();
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr, &way1, &way2, &way3};
+
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK(error == RouteError::CLEAN);
+    }
+
+    SECTION("three ways, gaps between first and second") {
+        std::vector<const osmium::NodeRef*> node_refs1 {new osmium::NodeRef(1), new osmium::NodeRef(2), new osmium::NodeRef(3), new osmium::NodeRef(4)};
+        std::vector<const osmium::NodeRef*> node_refs2 {new osmium::NodeRef(5), new osmium::NodeRef(6), new osmium::NodeRef(7)};
+        std::vector<const osmium::NodeRef*> node_refs3 {new osmium::NodeRef(7), new osmium::NodeRef(8), new osmium::NodeRef(9)};
+
+        osmium::Way& way1 = test_utils::create_way(buffer, 1, node_refs1, tags1);
+        buffer.commit();
+        osmium::Way& way2 = test_utils::create_way(buffer, 2, node_refs2, tags1);
+        buffer.commit();
+        osmium::Way& way3 = test_utils::create_way(buffer, 3, node_refs3, tags1);
+        buffer.commit();
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr, &way1, &way2, &way3};
+
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK(error == RouteError::UNORDERED_GAP);
+    }
+
+    SECTION("three ways, second way is a roundabout but not connected to anything") {
+        std::vector<const osmium::NodeRef*> node_refs1 {new osmium::NodeRef(1), new osmium::NodeRef(2), new osmium::NodeRef(3), new osmium::NodeRef(4)};
+        std::vector<const osmium::NodeRef*> node_refs2 {new osmium::NodeRef(12), new osmium::NodeRef(5), new osmium::NodeRef(6), new osmium::NodeRef(13), new osmium::NodeRef(12)};
+        std::vector<const osmium::NodeRef*> node_refs3 {new osmium::NodeRef(7), new osmium::NodeRef(8), new osmium::NodeRef(9)};
+
+        std::map<std::string, std::string> tags_roundabout;
+        tags_roundabout.emplace("highway", "secondary");
+        tags_roundabout.emplace("junction", "roundabout");
+
+        osmium::Way& way1 = test_utils::create_way(buffer, 1, node_refs1, tags1);
+        buffer.commit();
+        osmium::Way& way2 = test_utils::create_way(buffer, 2, node_refs2, tags_roundabout);
+        buffer.commit();
+        osmium::Way& way3 = test_utils::create_way(buffer, 3, node_refs3, tags1);
+        buffer.commit();
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr, &way1, &way2, &way3};
+
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK(error == RouteError::UNORDERED_GAP);
+    }
+
+    SECTION("platforms only") {
+        std::vector<osmium::item_type> platform_types = {NODE, NODE};
+        std::vector<osmium::object_id_type> platform_ids = {1, 2};
+        std::vector<std::string> platform_roles = {"platform", "platform"};
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, platform_ids, platform_types, platform_roles);
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr};
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK((error & RouteError::UNORDERED_GAP) == RouteError::CLEAN);
+    }
+
+    if (test_utils::delete_directory(options.output_directory.c_str()) != 0) {
+        std::cerr << " deleting " << options.output_directory << " after running the unit test failed!\n";
+        exit(1);
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ * test_hilbert_sort.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <feature_spool.hpp>
+#include <hilbert_curve.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    template <typename T>
+    void put(std::string& buffer, const T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    std::string wkb_header(const uint32_t type) {
+        std::string wkb {'\x01'};
+        put(wkb, type);
+        return wkb;
+    }
+
+    std::string wkb_linestring(const std::vector<std::pair<double, double>>& points) {
+        std::string wkb = wkb_header(2);
+        put(wkb, static_cast<uint32_t>(points.size()));
+        for (const auto& point : points) {
+            put(wkb, point.first);
+            put(wkb, point.second);
+        }
+        return wkb;
+    }
+
+} // namespace
+
+TEST_CASE("Hilbert curve visits the cells of a small grid in order") {
+    // The first 16 positions of the curve cover the 4x4 cells in the corner of the grid.
+    std::vector<std::pair<uint32_t, uint32_t>> cells(16);
+    std::vector<bool> visited(16, false);
+    for (uint32_t x = 0; x < 4; ++x) {
+        for (uint32_t y = 0; y < 4; ++y) {
+            const uint64_t index = HilbertCurve::index(x, y);
+            REQUIRE(index < 16);
+            REQUIRE_FALSE(visited[index]);
+            visited[index] = true;
+            cells[index] = std::make_pair(x, y);
+        }
+    }
+    REQUIRE(cells.front() == std::make_pair(0u, 0u));
+    // consecutive positions are neighbouring cells
+    for (size_t i = 1; i < cells.size(); ++i) {
+        const int dx = std::abs(static_cast<int>(cells[i].first) - static_cast<int>(cells[i - 1].first));
+        const int dy = std::abs(static_cast<int>(cells[i].second) - static_cast<int>(cells[i - 1].second));
+        REQUIRE(dx + dy == 1);
+    }
+}
+
+TEST_CASE("Hilbert curve clamps points outside its extent") {
+    const HilbertCurve curve {0.0, 0.0, 10.0, 10.0};
+    REQUIRE(curve.index(0.0, 0.0) == 0);
+    REQUIRE(curve.index(-5.0, -1.0) == 0);
+    REQUIRE(curve.index(-5.0, 5.0) == curve.index(0.0, 5.0));
+    REQUIRE(curve.index(15.0, 20.0) == curve.index(10.0, 10.0));
+    REQUIRE(curve.index(10.0, 10.0) == HilbertCurve::index(65535u, 65535u));
+    REQUIRE(curve.index(5.0, 5.0) != curve.index(5.0, 6.0));
+}
+
+TEST_CASE("Hilbert curve maps far away and non-finite coordinates to its border") {
+    const HilbertCurve curve {0.0, 0.0, 10.0, 10.0};
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    REQUIRE(curve.index(1e300, 1e300) == curve.index(10.0, 10.0));
+    REQUIRE(curve.index(inf, -inf) == curve.index(10.0, 0.0));
+    REQUIRE(curve.index(nan, 5.0) == curve.index(0.0, 5.0));
+    REQUIRE(curve.index(nan, nan) == 0);
+    const HilbertCurve empty {3.0, 4.0, 3.0, 4.0};
+    REQUIRE(empty.index(inf, inf) == 0);
+}
+
+TEST_CASE("Hilbert curve of an empty extent maps everything to the first cell") {
+    const HilbertCurve curve {3.0, 4.0, 3.0, 4.0};
+    REQUIRE(curve.index(3.0, 4.0) == 0);
+    REQUIRE(curve.index(100.0, -100.0) == 0);
+}
+
+TEST_CASE("centre of WKB geometries") {
+    double x = 0;
+    double y = 0;
+    SECTION("point") {
+        std::string wkb = wkb_header(1);
+        put(wkb, 1.5);
+        put(wkb, -2.5);
+        REQUIRE(FeatureSpool::wkb_centre(wkb, x, y));
+        REQUIRE(x == 1.5);
+        REQUIRE(y == -2.5);
+    }
+    SECTION("linestring") {
+        REQUIRE(FeatureSpool::wkb_centre(wkb_linestring({{0.0, 0.0}, {4.0, 1.0}, {-2.0, 3.0}}), x, y));
+        REQUIRE(x == 1.0);
+        REQUIRE(y == 1.5);
+    }
+    SECTION("multilinestring") {
+        std::string wkb = wkb_header(5);
+        put(wkb, static_cast<uint32_t>(2));
+        wkb += wkb_linestring({{10.0, 50.0}, {11.0, 51.0}});
+        wkb += wkb_linestring({{8.0, 52.0}, {9.0, 48.0}});
+        REQUIRE(FeatureSpool::wkb_centre(wkb, x, y));
+        REQUIRE(x == 9.5);
+        REQUIRE(y == 50.0);
+    }
+    SECTION("empty multilinestring") {
+        std::string wkb = wkb_header(5);
+        put(wkb, static_cast<uint32_t>(0));
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+}
+
+TEST_CASE("centre of truncated or unsupported WKB geometries") {
+    double x = 0;
+    double y = 0;
+    SECTION("empty") {
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(std::string{}, x, y));
+    }
+    SECTION("big-endian") {
+        std::string wkb = wkb_linestring({{0.0, 0.0}, {1.0, 1.0}});
+        wkb[0] = '\x00';
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+    SECTION("polygon") {
+        std::string wkb = wkb_header(3);
+        put(wkb, static_cast<uint32_t>(0));
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+    SECTION("point without y") {
+        std::string wkb = wkb_header(1);
+        put(wkb, 1.5);
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+    SECTION("linestring with missing points") {
+        std::string wkb = wkb_linestring({{0.0, 0.0}, {1.0, 1.0}});
+        wkb.resize(wkb.size() - 8);
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+    SECTION("multilinestring with missing linestring") {
+        std::string wkb = wkb_header(5);
+        put(wkb, static_cast<uint32_t>(2));
+        wkb += wkb_linestring({{10.0, 50.0}, {11.0, 51.0}});
+        wkb += '\x01';
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+    SECTION("multilinestring with truncated linestring header") {
+        std::string wkb = wkb_header(5);
+        put(wkb, static_cast<uint32_t>(1));
+        wkb += wkb_header(2);
+        REQUIRE_FALSE(FeatureSpool::wkb_centre(wkb, x, y));
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * test_location_index_selector.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <location_index_selector.hpp>
+
+#include <stdexcept>
+
+TEST_CASE("parse memory sizes") {
+    SECTION("plain number of bytes") {
+        CHECK(LocationIndexSelector::parse_memory_size("0") == 0);
+        CHECK(LocationIndexSelector::parse_memory_size("123456") == 123456);
+    }
+
+    SECTION("suffixes are powers of 1024") {
+        CHECK(LocationIndexSelector::parse_memory_size("3K") == 3 * 1024ULL);
+        CHECK(LocationIndexSelector::parse_memory_size("800M") == 800 * 1024ULL * 1024);
+        CHECK(LocationIndexSelector::parse_memory_size("12G") == 12 * 1024ULL * 1024 * 1024);
+        CHECK(LocationIndexSelector::parse_memory_size("2T") == 2 * 1024ULL * 1024 * 1024 * 1024);
+    }
+
+    SECTION("suffixes are case insensitive") {
+        CHECK(LocationIndexSelector::parse_memory_size("1k") == 1024);
+        CHECK(LocationIndexSelector::parse_memory_size("1g") == 1024ULL * 1024 * 1024);
+    }
+}
+
+TEST_CASE("invalid memory sizes are rejected") {
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size(""), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("1MB"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("M"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("-1"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("1X"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size(" 1G"), const std::invalid_argument&);
+}
+
+TEST_CASE("overflowing memory sizes are rejected") {
+    CHECK(LocationIndexSelector::parse_memory_size("18446744073709551615") == 18446744073709551615ULL);
+    CHECK(LocationIndexSelector::parse_memory_size("16777215T") == 16777215ULL << 40);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("18446744073709551616"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("16777216T"), const std::invalid_argument&);
+    CHECK_THROWS_AS(LocationIndexSelector::parse_memory_size("18014398509481984K"), const std::invalid_argument&);
+}
@@ -0,0 +1,111 @@
+/*
+ * test_memoized_classification.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+#include <gdalcpp.hpp>
+#include <ptv2_checker.hpp>
+
+static osmium::item_type NODE = osmium::item_type::node;
+static osmium::item_type WAY = osmium::item_type::way;
+
+
+TEST_CASE("memoized classification of members is valid for all route types") {
+    Options options;
+    options.output_directory = ".tmp-";
+    options.output_format = "GeoJSON";
+    srand (time(NULL));
+    options.output_directory += std::to_string(rand());
+    options.output_directory += "-testoutput.sqlite";
+    if (test_utils::file_exists(options.output_directory)) {
+        std::cerr << options.output_directory << " already exists!\n";
+        exit(1);
+    }
+    if (mkdir(options.output_directory.c_str(), 0744) != 0) {
+        std::cerr << "Failed to create directory " << options.output_directory << '\n';
+        exit(1);
+    }
+
+    osmium::util::VerboseOutput vout {false};
+    OGRWriter ogr_writer{options, vout};
+    RouteWriter writer (ogr_writer, options, vout);
+    PTv2Checker checker(writer);
+
+    static constexpr int buffer_size = 10 * 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    std::map<std::string, std::string> road_tags;
+    road_tags.emplace("highway", "secondary");
+    std::map<std::string, std::string> rail_tags;
+    rail_tags.emplace("railway", "rail");
+    std::map<std::string, std::string> bus_stop_tags;
+    bus_stop_tags.emplace("highway", "bus_stop");
+    std::vector<const osmium::NodeRef*> node_refs {new osmium::NodeRef(1, osmium::Location(9.0, 49.0)),
+        new osmium::NodeRef(2, osmium::Location(9.1, 49.0))};
+
+    osmium::Way& road = test_utils::create_way(buffer, 1, node_refs, road_tags);
+    buffer.commit();
+    osmium::Way& rail = test_utils::create_way(buffer, 2, node_refs, rail_tags);
+    buffer.commit();
+    osmium::Node& stop = test_utils::create_new_node(buffer, 3, osmium::Location(9.0, 49.0), bus_stop_tags);
+    buffer.commit();
+    std::vector<osmium::item_type> types = {NODE, WAY};
+    std::vector<osmium::object_id_type> ids = {3, 1};
+    std::vector<std::string> roles = {"stop", ""};
+    osmium::Relation& relation = test_utils::create_relation(buffer, 1, test_utils::get_bus_route_tags(), ids, types, roles);
+    buffer.commit();
+
+    SECTION("ways") {
+        // repeated lookups for different route types return the same results as the first one
+        for (int i = 0; i < 2; ++i) {
+            CHECK(checker.is_way_usable(relation, RouteType::BUS, &road) == RouteError::CLEAN);
+            CHECK(checker.is_way_usable(relation, RouteType::TRAIN, &road) == RouteError::OVER_NON_RAIL);
+            CHECK(checker.is_way_usable(relation, RouteType::TRAIN, &rail) == RouteError::CLEAN);
+            CHECK(checker.is_way_usable(relation, RouteType::BUS, &rail) == RouteError::OVER_NON_ROAD);
+        }
+    }
+
+    SECTION("stops") {
+        for (int i = 0; i < 2; ++i) {
+            CHECK(checker.check_stop_tags(relation, &stop, RouteType::BUS) == RouteError::CLEAN);
+            CHECK(checker.check_stop_tags(relation, &stop, RouteType::TRAIN) == RouteError::STOP_TAG_MISSING);
+            CHECK(checker.check_stop_tags(relation, &stop, RouteType::NONE) == RouteError::CLEAN);
+        }
+    }
+
+    SECTION("platforms") {
+        rail.set_id(3);
+        for (int i = 0; i < 2; ++i) {
+            CHECK(checker.check_platform_tags(relation, RouteType::BUS, &stop) == RouteError::CLEAN);
+            CHECK(checker.check_platform_tags(relation, RouteType::TRAIN, &stop) == RouteError::PLTF_TAG_MISSING);
+            CHECK(checker.check_platform_tags(relation, RouteType::NONE, &stop) == RouteError::CLEAN);
+            // a way with the same ID as the node is classified on its own
+            CHECK(checker.check_platform_tags(relation, RouteType::BUS, &rail) == RouteError::PLTF_TAG_MISSING);
+        }
+    }
+
+    SECTION("memoized classifications are forgotten if the table is full") {
+        CHECK(checker.is_way_usable(relation, RouteType::TRAIN, &road) == RouteError::OVER_NON_RAIL);
+        for (osmium::object_id_type id = 10; id < 10 + 300 * 1000; ++id) {
+            road.set_id(id);
+            REQUIRE(checker.is_way_usable(relation, RouteType::BUS, &road) == RouteError::CLEAN);
+        }
+        // The classification of way 1 has been dropped. A way with the same ID is classified again.
+        rail.set_id(1);
+        CHECK(checker.is_way_usable(relation, RouteType::TRAIN, &rail) == RouteError::CLEAN);
+    }
+
+    if (test_utils::delete_directory(options.output_directory.c_str()) != 0) {
+        std::cerr << " deleting " << options.output_directory << " after running the unit test failed!\n";
+        exit(1);
+    }
+}
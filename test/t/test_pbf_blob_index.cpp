@@ -0,0 +1,230 @@
+/*
+ * test_pbf_blob_index.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <pbf_blob_index.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <utime.h>
+#include <zlib.h>
+
+namespace {
+
+    void add_varint(std::string& buffer, uint64_t value) {
+        while (value >= 0x80u) {
+            buffer += static_cast<char>((value & 0x7fu) | 0x80u);
+            value >>= 7;
+        }
+        buffer += static_cast<char>(value);
+    }
+
+    void add_bytes_field(std::string& buffer, const uint64_t field, const std::string& value) {
+        add_varint(buffer, (field << 3) | 2);
+        add_varint(buffer, value.size());
+        buffer += value;
+    }
+
+    void add_varint_field(std::string& buffer, const uint64_t field, const uint64_t value) {
+        add_varint(buffer, field << 3);
+        add_varint(buffer, value);
+    }
+
+    /**
+     * PrimitiveGroup with one field of the given number (1: node, 2: dense nodes, 3: way,
+     * 4: relation). The content of the object does not matter for the blob index.
+     */
+    std::string group(const uint64_t field) {
+        std::string object;
+        add_varint_field(object, 1, 42);
+        std::string result;
+        add_bytes_field(result, field, object);
+        return result;
+    }
+
+    std::string primitive_block(std::initializer_list<std::string> groups) {
+        std::string block;
+        // string table with an empty string
+        add_bytes_field(block, 1, std::string("\x0a\x00", 2));
+        for (const std::string& g : groups) {
+            add_bytes_field(block, 2, g);
+        }
+        return block;
+    }
+
+    std::string raw_blob(const std::string& data) {
+        std::string blob;
+        add_bytes_field(blob, 1, data);
+        add_varint_field(blob, 2, data.size());
+        return blob;
+    }
+
+    std::string zlib_blob(const std::string& data) {
+        uLongf size = compressBound(static_cast<uLong>(data.size()));
+        std::string compressed(size, '\0');
+        REQUIRE(compress(reinterpret_cast<Bytef*>(&compressed[0]), &size, reinterpret_cast<const Bytef*>(data.data()),
+                static_cast<uLong>(data.size())) == Z_OK);
+        compressed.resize(size);
+        std::string blob;
+        add_varint_field(blob, 2, data.size());
+        add_bytes_field(blob, 3, compressed);
+        return blob;
+    }
+
+    /**
+     * Length of the BlobHeader (4 bytes big endian), BlobHeader and Blob
+     */
+    std::string file_block(const std::string& type, const std::string& blob) {
+        std::string header;
+        add_bytes_field(header, 1, type);
+        add_varint_field(header, 3, blob.size());
+        std::string result;
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            result += static_cast<char>((header.size() >> shift) & 0xffu);
+        }
+        return result + header + blob;
+    }
+
+    /**
+     * PBF file which is removed (together with its blob index) when the object goes out of scope.
+     */
+    class TemporaryPBF {
+
+        std::string m_filename;
+
+    public:
+        explicit TemporaryPBF(std::initializer_list<std::string> blocks) :
+            m_filename(".tmp-" + std::to_string(rand()) + "-blob-index.osm.pbf") {
+            std::ofstream outfile {m_filename, std::ios::binary};
+            for (const std::string& block : blocks) {
+                outfile << block;
+            }
+        }
+
+        ~TemporaryPBF() {
+            std::remove(m_filename.c_str());
+            std::remove(PBFBlobIndex::index_filename(m_filename).c_str());
+        }
+
+        const std::string& filename() const noexcept {
+            return m_filename;
+        }
+    };
+
+} // namespace
+
+TEST_CASE("build the blob index of a sorted file") {
+    srand(time(NULL));
+    const std::string header = file_block("OSMHeader", raw_blob(std::string("\x22\x0eOsmSchema-V0.6", 16)));
+    const std::string nodes = file_block("OSMData", zlib_blob(primitive_block({group(2)})));
+    const std::string ways = file_block("OSMData", raw_blob(primitive_block({group(3), group(3)})));
+    const std::string relations = file_block("OSMData", zlib_blob(primitive_block({group(4)})));
+    TemporaryPBF pbf {header, nodes, ways, relations};
+
+    PBFBlobIndex index {pbf.filename()};
+    index.build();
+    const std::vector<BlobIndexEntry>& entries = index.entries();
+    REQUIRE(entries.size() == 4);
+    CHECK(entries[0].offset == 0);
+    CHECK(entries[0].size == header.size());
+    CHECK(entries[0].type == osmium::osm_entity_bits::nothing);
+    CHECK(entries[1].offset == header.size());
+    CHECK(entries[1].size == nodes.size());
+    CHECK(entries[1].type == osmium::osm_entity_bits::node);
+    CHECK(entries[2].offset == header.size() + nodes.size());
+    CHECK(entries[2].size == ways.size());
+    CHECK(entries[2].type == osmium::osm_entity_bits::way);
+    CHECK(entries[3].offset == header.size() + nodes.size() + ways.size());
+    CHECK(entries[3].size == relations.size());
+    CHECK(entries[3].type == osmium::osm_entity_bits::relation);
+    CHECK(index.sorted());
+    CHECK(index.header_size() == header.size());
+
+    SECTION("range of a single type") {
+        CHECK(index.range(osmium::osm_entity_bits::way) == std::make_pair(entries[2].offset, entries[3].offset));
+        CHECK(index.range(osmium::osm_entity_bits::relation) == std::make_pair(entries[3].offset, entries[3].offset + relations.size()));
+    }
+
+    SECTION("range of multiple types") {
+        CHECK(index.range(osmium::osm_entity_bits::node | osmium::osm_entity_bits::way)
+                == std::make_pair(entries[1].offset, entries[3].offset));
+    }
+
+    SECTION("range of a type without blobs is empty") {
+        const std::pair<uint64_t, uint64_t> empty {0, 0};
+        CHECK(index.range(osmium::osm_entity_bits::changeset) == empty);
+    }
+
+    SECTION("cache file is loaded") {
+        REQUIRE(index.save());
+        PBFBlobIndex loaded {pbf.filename()};
+        REQUIRE(loaded.load());
+        REQUIRE(loaded.entries().size() == entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            CHECK(loaded.entries()[i].offset == entries[i].offset);
+            CHECK(loaded.entries()[i].size == entries[i].size);
+            CHECK(loaded.entries()[i].type == entries[i].type);
+        }
+    }
+
+    SECTION("missing cache file is not loaded") {
+        PBFBlobIndex loaded {pbf.filename()};
+        CHECK_FALSE(loaded.load());
+    }
+
+    SECTION("cache file of a modified input file is not loaded") {
+        REQUIRE(index.save());
+        struct utimbuf times;
+        times.actime = 1000000000;
+        times.modtime = 1000000000;
+        REQUIRE(utime(pbf.filename().c_str(), &times) == 0);
+        PBFBlobIndex loaded {pbf.filename()};
+        CHECK_FALSE(loaded.load());
+    }
+}
+
+TEST_CASE("blobs with different types are never skipped") {
+    srand(time(NULL));
+    const std::string header = file_block("OSMHeader", raw_blob(std::string("\x22\x0eOsmSchema-V0.6", 16)));
+    const std::string nodes = file_block("OSMData", raw_blob(primitive_block({group(1)})));
+    const std::string mixed = file_block("OSMData", zlib_blob(primitive_block({group(3), group(2)})));
+    const std::string relations = file_block("OSMData", raw_blob(primitive_block({group(4)})));
+    TemporaryPBF pbf {header, nodes, mixed, relations};
+
+    PBFBlobIndex index {pbf.filename()};
+    index.build();
+    REQUIRE(index.entries().size() == 4);
+    CHECK(index.entries()[1].type == osmium::osm_entity_bits::node);
+    CHECK(index.entries()[2].type == osmium::osm_entity_bits::all);
+    CHECK(index.entries()[3].type == osmium::osm_entity_bits::relation);
+    CHECK_FALSE(index.sorted());
+    CHECK(index.range(osmium::osm_entity_bits::way).first == header.size() + nodes.size());
+    const std::pair<uint64_t, uint64_t> nodes_range {header.size(), header.size() + nodes.size() + mixed.size()};
+    CHECK(index.range(osmium::osm_entity_bits::node) == nodes_range);
+}
+
+TEST_CASE("reading beyond the end of the input file is reported by BlobRangeInput::close()") {
+    srand(time(NULL));
+    const std::string header = file_block("OSMHeader", raw_blob(std::string("\x22\x0eOsmSchema-V0.6", 16)));
+    const std::string nodes = file_block("OSMData", raw_blob(primitive_block({group(1)})));
+    TemporaryPBF pbf {header, nodes};
+
+    BlobRangeInput input {pbf.filename(), header.size(), std::make_pair<uint64_t, uint64_t>(header.size(), header.size() + 2 * nodes.size())};
+    std::ifstream pipe {input.file().filename(), std::ios::binary};
+    const std::string data {std::istreambuf_iterator<char>(pipe), std::istreambuf_iterator<char>()};
+    CHECK(data == header + nodes);
+    CHECK_THROWS(input.close());
+}
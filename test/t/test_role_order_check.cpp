@@ -7,6 +7,7 @@
 
 #include "catch.hpp"
 #include "object_builder_utilities.hpp"
+#include "route_check_utilities.hpp"
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -332,6 +333,175 @@ TEST_CASE("check valid simple bus route") {
             RouteError error = checker.check_roles_order_and_type(relation1, objects);
             CHECK(error== RouteError::CLEAN);
         }
+
+        SECTION("correct stop order on a loop – the stop is served on the second run over its way") {
+            types = {NODE, NODE, NODE, WAY, WAY, WAY, WAY, WAY, WAY};
+            roles = {"stop", "stop", "stop", "", "", "", "", "", ""};
+            std::vector<osmium::object_id_type> ids = {1, 11, 8, 1, 2, 3, 4, 3, 5};
+            std::vector<const osmium::OSMObject*> objects {&node1, &node11, &node8, &way1, &way2, &way3, &way4, &way3, &way5};
+
+            osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+            RouteError error = checker.check_roles_order_and_type(relation1, objects);
+            CHECK(error== RouteError::CLEAN);
+        }
+
+        SECTION("wrong stop order on a loop – the stop is served after the last run over its way") {
+            types = {NODE, NODE, NODE, WAY, WAY, WAY, WAY, WAY, WAY};
+            roles = {"stop", "stop", "stop", "", "", "", "", "", ""};
+            std::vector<osmium::object_id_type> ids = {1, 13, 8, 1, 2, 3, 4, 3, 5};
+            std::vector<const osmium::OSMObject*> objects {&node1, &node13, &node8, &way1, &way2, &way3, &way4, &way3, &way5};
+
+            osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+            RouteError error = checker.check_roles_order_and_type(relation1, objects);
+            CHECK(error== RouteError::STOP_MISORDERED);
+        }
+
+        SECTION("correct stop order on a T-shaped route – the stops are served in both directions") {
+            types = {NODE, NODE, NODE, NODE, NODE, WAY, WAY, WAY, WAY, WAY, WAY};
+            roles = {"stop", "stop", "stop", "stop", "stop", "", "", "", "", "", ""};
+            std::vector<osmium::object_id_type> ids = {1, 2, 8, 2, 1, 1, 2, 3, 3, 2, 1};
+            std::vector<const osmium::OSMObject*> objects {&node1, &node2, &node8, &node2, &node1, &way1, &way2, &way3, &way3, &way2, &way1};
+
+            osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+            RouteError error = checker.check_roles_order_and_type(relation1, objects);
+            CHECK(error== RouteError::CLEAN);
+        }
+
+        SECTION("wrong stop order on a T-shaped route – a stop is served twice on the way back") {
+            types = {NODE, NODE, NODE, NODE, NODE, WAY, WAY, WAY, WAY, WAY, WAY};
+            roles = {"stop", "stop", "stop", "stop", "stop", "", "", "", "", "", ""};
+            std::vector<osmium::object_id_type> ids = {1, 8, 2, 2, 1, 1, 2, 3, 3, 2, 1};
+            std::vector<const osmium::OSMObject*> objects {&node1, &node8, &node2, &node2, &node1, &way1, &way2, &way3, &way3, &way2, &way1};
+
+            osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, tags_rel, ids, types, roles, objects);
+            RouteError error = checker.check_roles_order_and_type(relation1, objects);
+            CHECK((error & RouteError::STOP_MISORDERED) == RouteError::STOP_MISORDERED);
+        }
+    }
+
+    if (test_utils::delete_directory(options.output_directory.c_str()) != 0) {
+        std::cerr << " deleting " << options.output_directory << " after running the unit test failed!\n";
+        exit(1);
+    }
+}
+
+
+TEST_CASE("validate() returns the results of the role/order check and the gap detection") {
+    Options options;
+    options.output_directory = ".tmp-";
+    options.output_format = "GeoJSON";
+    srand (time(NULL));
+    options.output_directory += std::to_string(rand());
+    options.output_directory += "-testoutput.sqlite";
+    if (test_utils::file_exists(options.output_directory)) {
+        std::cerr << options.output_directory << " already exists!\n";
+        exit(1);
+    }
+    if (mkdir(options.output_directory.c_str(), 0744) != 0) {
+        std::cerr << "Failed to create directory " << options.output_directory << '\n';
+        exit(1);
+    }
+
+    osmium::util::VerboseOutput vout {false};
+    OGRWriter ogr_writer{options, vout};
+    RouteWriter writer (ogr_writer, options, vout);
+    PTv2Checker checker(writer);
+
+    static constexpr int buffer_size = 10 * 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+
+    SECTION("train route stops at end") {
+        std::vector<osmium::item_type> types = {WAY, WAY, WAY, NODE, NODE, NODE};
+        std::vector<osmium::object_id_type> ids = {1, 2, 3, 1, 5, 9};
+        std::vector<std::string> roles = {"", "", "", "stop", "stop", "stop"};
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, test_utils::get_train_route_tags(), ids, types, roles);
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK((error & RouteError::STOPPLTF_AFTER_ROUTE) == RouteError::STOPPLTF_AFTER_ROUTE);
+        CHECK((error & RouteError::NO_STOPPLTF_AT_FRONT) == RouteError::NO_STOPPLTF_AT_FRONT);
+    }
+
+    SECTION("unknown roles") {
+        std::vector<osmium::item_type> types = {WAY, WAY, WAY, NODE, NODE, NODE};
+        std::vector<osmium::object_id_type> ids = {1, 2, 3, 1, 5, 9};
+        std::vector<std::string> roles = {"", "", "", "ab", "stop_here", "stop3"};
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, test_utils::get_train_route_tags(), ids, types, roles);
+        std::vector<const osmium::OSMObject*> objects {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK((error & RouteError::UNKNOWN_ROLE) == RouteError::UNKNOWN_ROLE);
+    }
+
+    SECTION("bus route with stops in wrong order, over non-road and with a gap") {
+        std::vector<osmium::item_type> types = {NODE, NODE, WAY, WAY, WAY};
+        std::vector<osmium::object_id_type> ids = {8, 1, 1, 2, 3};
+        std::vector<std::string> roles = {"stop", "stop", "", "", ""};
+
+        std::map<std::string, std::string> stop_pos;
+        stop_pos.emplace("public_transport", "stop_position");
+        std::map<std::string, std::string> tags1;
+        tags1.emplace("highway", "secondary");
+        std::map<std::string, std::string> tags2;
+        tags2.emplace("railway", "rail");
+
+        osmium::Node& node1 = test_utils::create_new_node(buffer, 1, osmium::Location{}, stop_pos);
+        buffer.commit();
+        osmium::Node& node8 = test_utils::create_new_node(buffer, 8, osmium::Location{}, stop_pos);
+        buffer.commit();
+
+        std::vector<const osmium::NodeRef*> node_refs1 {new osmium::NodeRef(1), new osmium::NodeRef(2), new osmium::NodeRef(3), new osmium::NodeRef(4)};
+        std::vector<const osmium::NodeRef*> node_refs2 {new osmium::NodeRef(5), new osmium::NodeRef(6), new osmium::NodeRef(7)};
+        std::vector<const osmium::NodeRef*> node_refs3 {new osmium::NodeRef(7), new osmium::NodeRef(8), new osmium::NodeRef(9)};
+        osmium::Way& way1 = test_utils::create_way(buffer, 1, node_refs1, tags1);
+        buffer.commit();
+        osmium::Way& way2 = test_utils::create_way(buffer, 2, node_refs2, tags2);
+        buffer.commit();
+        osmium::Way& way3 = test_utils::create_way(buffer, 3, node_refs3, tags1);
+        buffer.commit();
+        std::vector<const osmium::OSMObject*> objects {&node8, &node1, &way1, &way2, &way3};
+
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, test_utils::get_bus_route_tags(), ids, types, roles, objects);
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK((error & RouteError::STOP_MISORDERED) == RouteError::STOP_MISORDERED);
+        CHECK((error & RouteError::OVER_NON_ROAD) == RouteError::OVER_NON_ROAD);
+        CHECK((error & RouteError::UNORDERED_GAP) == RouteError::UNORDERED_GAP);
+    }
+
+    SECTION("route without members") {
+        std::vector<osmium::item_type> types;
+        std::vector<osmium::object_id_type> ids;
+        std::vector<std::string> roles;
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, test_utils::get_bus_route_tags(), ids, types, roles);
+        std::vector<const osmium::OSMObject*> objects;
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK(error == RouteError::NO_ROUTE);
+    }
+
+    SECTION("route with stops only") {
+        std::vector<osmium::item_type> types = {NODE, NODE};
+        std::vector<osmium::object_id_type> ids = {1, 2};
+        std::vector<std::string> roles = {"stop", "platform"};
+
+        std::map<std::string, std::string> stop_pos;
+        stop_pos.emplace("public_transport", "stop_position");
+        stop_pos.emplace("bus", "yes");
+        std::map<std::string, std::string> platform;
+        platform.emplace("public_transport", "platform");
+
+        osmium::Node& node1 = test_utils::create_new_node(buffer, 1, osmium::Location{}, stop_pos);
+        buffer.commit();
+        osmium::Node& node2 = test_utils::create_new_node(buffer, 2, osmium::Location{}, platform);
+        buffer.commit();
+        std::vector<const osmium::OSMObject*> objects {&node1, &node2};
+
+        osmium::Relation& relation1 = test_utils::create_relation(buffer, 1, test_utils::get_bus_route_tags(), ids, types, roles, objects);
+        RouteError error = checker.validate(relation1, objects);
+        CHECK(error == test_utils::run_separate_checks(checker, relation1, objects));
+        CHECK((error & RouteError::NO_ROUTE) == RouteError::NO_ROUTE);
+        CHECK((error & RouteError::UNORDERED_GAP) == RouteError::CLEAN);
     }
 
     if (test_utils::delete_directory(options.output_directory.c_str()) != 0) {
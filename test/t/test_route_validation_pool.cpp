@@ -0,0 +1,121 @@
+/*
+ * test_route_validation_pool.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <route_validation_pool.hpp>
+
+static osmium::item_type NODE = osmium::item_type::node;
+static osmium::item_type WAY = osmium::item_type::way;
+
+
+TEST_CASE("route validation pool validates copies of all relations") {
+    Options options;
+    options.output_directory = ".tmp-";
+    options.output_format = "GeoJSON";
+    srand (time(NULL));
+    options.output_directory += std::to_string(rand());
+    options.output_directory += "-testoutput.sqlite";
+    if (test_utils::file_exists(options.output_directory)) {
+        std::cerr << options.output_directory << " already exists!\n";
+        exit(1);
+    }
+    if (mkdir(options.output_directory.c_str(), 0744) != 0) {
+        std::cerr << "Failed to create directory " << options.output_directory << '\n';
+        exit(1);
+    }
+
+    osmium::util::VerboseOutput vout {false};
+    OGRWriter ogr_writer{options, vout};
+    RouteWriter writer (ogr_writer, options, vout);
+
+    // relation ID, ID of the way member and number of missing members seen by the validation function
+    struct Result {
+        osmium::object_id_type relation;
+        osmium::object_id_type way;
+        size_t missing;
+    };
+    std::vector<Result> results;
+    std::mutex results_mutex;
+    auto validate = [&results, &results_mutex](const osmium::Relation& relation,
+            std::vector<const osmium::OSMObject*>& objects, PTv2Checker&) {
+        if (relation.id() == 13) {
+            throw std::runtime_error{"validation failed"};
+        }
+        Result result {relation.id(), 0, 0};
+        for (const osmium::OSMObject* object : objects) {
+            if (object) {
+                result.way = object->id();
+            } else {
+                ++result.missing;
+            }
+        }
+        std::lock_guard<std::mutex> lock {results_mutex};
+        results.push_back(result);
+    };
+
+    static constexpr int buffer_size = 10 * 1000 * 1000;
+    std::map<std::string, std::string> tags_rel = test_utils::get_bus_route_tags();
+    std::map<std::string, std::string> tags1;
+    tags1.emplace("highway", "secondary");
+    std::vector<osmium::item_type> types = {NODE, WAY};
+    std::vector<std::string> roles = {"platform", ""};
+
+    SECTION("all relations are validated") {
+        RouteValidationPool pool {3, writer, validate};
+        for (osmium::object_id_type id = 1; id <= 10; ++id) {
+            // The buffer is destroyed before the relation is validated.
+            osmium::memory::Buffer buffer(buffer_size);
+            std::vector<const osmium::NodeRef*> node_refs {new osmium::NodeRef(1), new osmium::NodeRef(2)};
+            osmium::Way& way = test_utils::create_way(buffer, 100 + id, node_refs, tags1);
+            buffer.commit();
+            std::vector<osmium::object_id_type> ids = {1, 100 + id};
+            std::vector<const osmium::OSMObject*> objects {nullptr, &way};
+            osmium::Relation& relation = test_utils::create_relation(buffer, id, tags_rel, ids, types, roles, objects);
+            buffer.commit();
+            pool.add(relation, objects);
+        }
+        pool.finish();
+        REQUIRE(results.size() == 10);
+        std::sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+            return a.relation < b.relation;
+        });
+        for (osmium::object_id_type id = 1; id <= 10; ++id) {
+            CHECK(results[id - 1].relation == id);
+            CHECK(results[id - 1].way == 100 + id);
+            CHECK(results[id - 1].missing == 1);
+        }
+    }
+
+    SECTION("exceptions of the threads are rethrown by finish()") {
+        RouteValidationPool pool {2, writer, validate};
+        osmium::memory::Buffer buffer(buffer_size);
+        for (osmium::object_id_type id = 12; id <= 14; ++id) {
+            std::vector<osmium::object_id_type> ids = {1, 100 + id};
+            osmium::Relation& relation = test_utils::create_relation(buffer, id, tags_rel, ids, types, roles);
+            buffer.commit();
+            pool.add(relation, std::vector<const osmium::OSMObject*>{nullptr, nullptr});
+        }
+        REQUIRE_THROWS_AS(pool.finish(), const std::runtime_error&);
+        // all other relations are validated nevertheless
+        CHECK(results.size() == 2);
+    }
+
+    if (test_utils::delete_directory(options.output_directory.c_str()) != 0) {
+        std::cerr << " deleting " << options.output_directory << " after running the unit test failed!\n";
+        exit(1);
+    }
+}
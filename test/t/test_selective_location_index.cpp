@@ -0,0 +1,102 @@
+/*
+ * test_selective_location_index.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <needed_nodes_handler.hpp>
+#include <selective_location_index.hpp>
+#include <way_geometry_filter.hpp>
+
+#include <vector>
+
+#include <osmium/index/index.hpp>
+
+TEST_CASE("selective location index stores only needed nodes") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> needed_nodes;
+    needed_nodes.set(2);
+    needed_nodes.set(5);
+    needed_nodes.set(9);
+    SelectiveLocationIndex index {needed_nodes};
+    // input is not sorted by ID
+    index.set(9, osmium::Location{9.0, 49.0});
+    index.set(1, osmium::Location{1.0, 41.0});
+    index.set(5, osmium::Location{5.0, 45.0});
+    index.set(2, osmium::Location{2.0, 42.0});
+    index.set(3, osmium::Location{3.0, 43.0});
+    index.sort();
+
+    REQUIRE(index.size() == 3);
+    REQUIRE(index.get(2) == osmium::Location(2.0, 42.0));
+    REQUIRE(index.get(5) == osmium::Location(5.0, 45.0));
+    REQUIRE(index.get(9) == osmium::Location(9.0, 49.0));
+    REQUIRE_FALSE(index.get_noexcept(1).valid());
+    REQUIRE_FALSE(index.get_noexcept(10).valid());
+    REQUIRE_THROWS_AS(index.get(3), const osmium::not_found&);
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE_FALSE(index.get_noexcept(2).valid());
+}
+
+TEST_CASE("needed nodes handler collects the nodes of ways whose geometry is built") {
+    Options options;
+    options.stations = false;
+    options.platforms = true;
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> member_ways;
+    member_ways.set(1);
+    // member way with a negative ID
+    member_ways.set(7);
+    WayGeometryFilter filter {member_ways, options};
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> needed_nodes;
+    NeededNodesHandler handler {filter, needed_nodes};
+
+    static constexpr int buffer_size = 10 * 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    std::map<std::string, std::string> no_tags;
+    std::map<std::string, std::string> platform_tags;
+    platform_tags.emplace("public_transport", "platform");
+    platform_tags.emplace("railway", "platform");
+    std::vector<const osmium::NodeRef*> node_refs1 {new osmium::NodeRef(1), new osmium::NodeRef(2)};
+    std::vector<const osmium::NodeRef*> node_refs2 {new osmium::NodeRef(3), new osmium::NodeRef(4)};
+    std::vector<const osmium::NodeRef*> node_refs3 {new osmium::NodeRef(5), new osmium::NodeRef(6)};
+    std::vector<const osmium::NodeRef*> node_refs4 {new osmium::NodeRef(8), new osmium::NodeRef(-9)};
+
+    osmium::Way& member = test_utils::create_way(buffer, 1, node_refs1, no_tags);
+    buffer.commit();
+    osmium::Way& other = test_utils::create_way(buffer, 2, node_refs2, no_tags);
+    buffer.commit();
+    osmium::Way& negative_member = test_utils::create_way(buffer, -7, node_refs3, no_tags);
+    buffer.commit();
+    osmium::Way& platform = test_utils::create_way(buffer, 3, node_refs4, platform_tags);
+    buffer.commit();
+
+    REQUIRE(filter(member));
+    REQUIRE_FALSE(filter(other));
+    REQUIRE(filter(negative_member));
+    REQUIRE(filter(platform));
+
+    handler.way(member);
+    handler.way(other);
+    handler.way(negative_member);
+    handler.way(platform);
+    REQUIRE(needed_nodes.get(1));
+    REQUIRE(needed_nodes.get(2));
+    REQUIRE_FALSE(needed_nodes.get(3));
+    REQUIRE_FALSE(needed_nodes.get(4));
+    REQUIRE(needed_nodes.get(5));
+    REQUIRE(needed_nodes.get(6));
+    REQUIRE(needed_nodes.get(8));
+    // locations of nodes with negative IDs are not stored by the location index
+    REQUIRE_FALSE(needed_nodes.get(9));
+
+    SECTION("platforms are ignored if the platforms layer is disabled") {
+        options.platforms = false;
+        REQUIRE_FALSE(filter(platform));
+        REQUIRE(filter(member));
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * test_spatial_index_builder.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <spatial_index_builder.hpp>
+#include <sqlite_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+#include <sqlite3.h>
+
+namespace {
+
+    template <typename T>
+    void put(std::string& buffer, const T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /**
+     * SpatiaLite blob of a linestring with two points. The index builder reads the MBR only.
+     */
+    std::string linestring_blob(const double x1, const double y1, const double x2, const double y2) {
+        std::string blob;
+        blob += '\x00';
+        blob += '\x01';
+        put(blob, static_cast<int32_t>(4326));
+        put(blob, std::min(x1, x2));
+        put(blob, std::min(y1, y2));
+        put(blob, std::max(x1, x2));
+        put(blob, std::max(y1, y2));
+        blob += '\x7C';
+        put(blob, static_cast<uint32_t>(2));
+        put(blob, static_cast<uint32_t>(2));
+        for (const double value : {x1, y1, x2, y2}) {
+            put(blob, value);
+        }
+        blob += '\xFE';
+        return blob;
+    }
+
+    /**
+     * Database connection which is closed when it goes out of scope.
+     */
+    class Database {
+
+        std::string m_filename;
+
+        sqlite3* m_database = nullptr;
+
+    public:
+        explicit Database(const std::string& filename) :
+            m_filename(filename) {
+            sqlite_check(m_database, m_filename, sqlite3_open(m_filename.c_str(), &m_database), "open database");
+        }
+
+        ~Database() {
+            sqlite3_close(m_database);
+        }
+
+        void exec(const std::string& sql) {
+            sqlite_check(m_database, m_filename, sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, nullptr), sql.c_str());
+        }
+
+        void insert_geometry(const std::string& table, const std::string& blob) {
+            sqlite3_stmt* insert = nullptr;
+            sqlite_check(m_database, m_filename, sqlite3_prepare_v2(m_database,
+                    ("INSERT INTO " + table + " (GEOMETRY) VALUES (?)").c_str(), -1, &insert, nullptr), "prepare insert");
+            sqlite3_bind_blob(insert, 1, blob.data(), static_cast<int>(blob.size()), SQLITE_TRANSIENT);
+            const int result = sqlite3_step(insert);
+            sqlite3_finalize(insert);
+            sqlite_check(m_database, m_filename, result, "insert geometry");
+        }
+
+        int64_t query_int(const std::string& sql) {
+            sqlite3_stmt* select = nullptr;
+            sqlite_check(m_database, m_filename, sqlite3_prepare_v2(m_database, sql.c_str(), -1, &select, nullptr), sql.c_str());
+            REQUIRE(sqlite3_step(select) == SQLITE_ROW);
+            const int64_t value = sqlite3_column_int64(select, 0);
+            sqlite3_finalize(select);
+            return value;
+        }
+
+        double query_double(const std::string& sql) {
+            sqlite3_stmt* select = nullptr;
+            sqlite_check(m_database, m_filename, sqlite3_prepare_v2(m_database, sql.c_str(), -1, &select, nullptr), sql.c_str());
+            REQUIRE(sqlite3_step(select) == SQLITE_ROW);
+            const double value = sqlite3_column_double(select, 0);
+            sqlite3_finalize(select);
+            return value;
+        }
+
+        void create_layer(const std::string& table) {
+            exec("CREATE TABLE " + table + " (ogc_fid INTEGER PRIMARY KEY AUTOINCREMENT, GEOMETRY LINESTRING)");
+            exec("INSERT INTO geometry_columns VALUES ('" + table + "', 'geometry', 2, 2, 4326, 0)");
+        }
+    };
+
+} // namespace
+
+TEST_CASE("build spatial indexes") {
+    srand(time(NULL));
+    const std::string filename = ".tmp-" + std::to_string(rand()) + "-spatial-index.sqlite";
+    std::remove(filename.c_str());
+    {
+        Database database {filename};
+        database.exec("CREATE TABLE geometry_columns (f_table_name TEXT NOT NULL, f_geometry_column TEXT NOT NULL, "
+                "geometry_type INTEGER NOT NULL, coord_dimension INTEGER NOT NULL, srid INTEGER NOT NULL, "
+                "spatial_index_enabled INTEGER NOT NULL, CONSTRAINT pk_geom_cols PRIMARY KEY (f_table_name, f_geometry_column))");
+        database.create_layer("lines");
+        database.insert_geometry("lines", linestring_blob(8.5, 49.25, 9.0, 49.5));
+        database.insert_geometry("lines", linestring_blob(-1.0, 2.0, -3.0, 1.5));
+        database.insert_geometry("lines", linestring_blob(120.0, -30.0, 121.0, -31.0));
+        database.create_layer("empty");
+        database.create_layer("identical");
+        for (int i = 0; i < 3; ++i) {
+            database.insert_geometry("identical", linestring_blob(5.0, 6.0, 5.0, 6.0));
+        }
+    }
+
+    osmium::util::VerboseOutput vout {false};
+    SpatialIndexBuilder builder {filename, vout};
+    builder.build();
+
+    Database database {filename};
+    SECTION("spatial indexes are enabled") {
+        CHECK(database.query_int("SELECT count(*) FROM geometry_columns WHERE spatial_index_enabled = 1") == 3);
+    }
+
+    SECTION("one row per feature with the MBR of the blob") {
+        CHECK(database.query_int("SELECT count(*) FROM idx_lines_geometry") == 3);
+        CHECK(database.query_double("SELECT xmin FROM idx_lines_geometry WHERE pkid = 1") == 8.5);
+        CHECK(database.query_double("SELECT xmax FROM idx_lines_geometry WHERE pkid = 1") == 9.0);
+        CHECK(database.query_double("SELECT ymin FROM idx_lines_geometry WHERE pkid = 1") == 49.25);
+        CHECK(database.query_double("SELECT ymax FROM idx_lines_geometry WHERE pkid = 1") == 49.5);
+        CHECK(database.query_double("SELECT xmin FROM idx_lines_geometry WHERE pkid = 2") == -3.0);
+        CHECK(database.query_double("SELECT ymax FROM idx_lines_geometry WHERE pkid = 2") == 2.0);
+        CHECK(database.query_double("SELECT ymin FROM idx_lines_geometry WHERE pkid = 3") == -31.0);
+        CHECK(database.query_int("SELECT count(*) FROM idx_lines_geometry WHERE xmin <= 8.75 AND xmax >= 8.75 "
+                "AND ymin <= 49.3 AND ymax >= 49.3") == 1);
+    }
+
+    SECTION("empty table") {
+        CHECK(database.query_int("SELECT count(*) FROM idx_empty_geometry") == 0);
+    }
+
+    SECTION("all points identical") {
+        CHECK(database.query_int("SELECT count(*) FROM idx_identical_geometry") == 3);
+        CHECK(database.query_int("SELECT count(*) FROM idx_identical_geometry WHERE xmin = 5.0 AND xmax = 5.0 "
+                "AND ymin = 6.0 AND ymax = 6.0") == 3);
+    }
+
+    std::remove(filename.c_str());
+}
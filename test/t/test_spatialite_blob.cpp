@@ -0,0 +1,246 @@
+/*
+ * test_spatialite_blob.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <spatialite_writer.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    /**
+     * Append the raw little-endian bytes of a value to a buffer.
+     */
+    template <typename T>
+    void put(std::string& buffer, const T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put_byte(std::string& buffer, const unsigned char value) {
+        buffer += static_cast<char>(value);
+    }
+
+    std::string wkb_header(const uint32_t type) {
+        std::string wkb;
+        put_byte(wkb, 0x01);
+        put(wkb, type);
+        return wkb;
+    }
+
+    std::string wkb_linestring(const std::vector<std::pair<double, double>>& points) {
+        std::string wkb = wkb_header(2);
+        put(wkb, static_cast<uint32_t>(points.size()));
+        for (const auto& point : points) {
+            put(wkb, point.first);
+            put(wkb, point.second);
+        }
+        return wkb;
+    }
+
+    /**
+     * Start of a SpatiaLite blob up to and including the end of MBR marker.
+     */
+    std::string blob_header(const int32_t srid, const double min_x, const double min_y, const double max_x,
+            const double max_y) {
+        std::string blob;
+        put_byte(blob, 0x00);
+        put_byte(blob, 0x01);
+        put(blob, srid);
+        put(blob, min_x);
+        put(blob, min_y);
+        put(blob, max_x);
+        put(blob, max_y);
+        put_byte(blob, 0x7C);
+        return blob;
+    }
+
+} // namespace
+
+TEST_CASE("point is converted to a SpatiaLite blob") {
+    std::string wkb = wkb_header(1);
+    put(wkb, 1.5);
+    put(wkb, -2.25);
+
+    std::string expected = blob_header(4326, 1.5, -2.25, 1.5, -2.25);
+    put(expected, static_cast<uint32_t>(1));
+    put(expected, 1.5);
+    put(expected, -2.25);
+    put_byte(expected, 0xFE);
+
+    std::string blob;
+    SpatialiteWriter::wkb_to_blob(wkb, 4326, blob);
+    REQUIRE(blob.size() == 60);
+    REQUIRE(blob == expected);
+}
+
+TEST_CASE("linestring is converted to a SpatiaLite blob") {
+    const std::string wkb = wkb_linestring({{0.0, 0.0}, {2.0, 1.0}, {-1.0, 3.0}});
+
+    std::string expected = blob_header(3857, -1.0, 0.0, 2.0, 3.0);
+    put(expected, static_cast<uint32_t>(2));
+    put(expected, static_cast<uint32_t>(3));
+    for (const double value : {0.0, 0.0, 2.0, 1.0, -1.0, 3.0}) {
+        put(expected, value);
+    }
+    put_byte(expected, 0xFE);
+
+    std::string blob {"previous contents"};
+    SpatialiteWriter::wkb_to_blob(wkb, 3857, blob);
+    REQUIRE(blob == expected);
+}
+
+TEST_CASE("multilinestring is converted to a SpatiaLite blob") {
+    std::string wkb = wkb_header(5);
+    put(wkb, static_cast<uint32_t>(2));
+    wkb += wkb_linestring({{10.0, 50.0}, {11.0, 51.0}});
+    wkb += wkb_linestring({{9.0, 52.0}, {9.5, 49.0}});
+
+    std::string expected = blob_header(4326, 9.0, 49.0, 11.0, 52.0);
+    put(expected, static_cast<uint32_t>(5));
+    put(expected, static_cast<uint32_t>(2));
+    put_byte(expected, 0x69);
+    put(expected, static_cast<uint32_t>(2));
+    put(expected, static_cast<uint32_t>(2));
+    for (const double value : {10.0, 50.0, 11.0, 51.0}) {
+        put(expected, value);
+    }
+    put_byte(expected, 0x69);
+    put(expected, static_cast<uint32_t>(2));
+    put(expected, static_cast<uint32_t>(2));
+    for (const double value : {9.0, 52.0, 9.5, 49.0}) {
+        put(expected, value);
+    }
+    put_byte(expected, 0xFE);
+
+    std::string blob;
+    SpatialiteWriter::wkb_to_blob(wkb, 4326, blob);
+    REQUIRE(blob == expected);
+}
+
+TEST_CASE("empty multilinestring gets an empty MBR") {
+    std::string wkb = wkb_header(5);
+    put(wkb, static_cast<uint32_t>(0));
+
+    std::string expected = blob_header(4326, 0.0, 0.0, 0.0, 0.0);
+    put(expected, static_cast<uint32_t>(5));
+    put(expected, static_cast<uint32_t>(0));
+    put_byte(expected, 0xFE);
+
+    std::string blob;
+    SpatialiteWriter::wkb_to_blob(wkb, 4326, blob);
+    REQUIRE(blob == expected);
+}
+
+TEST_CASE("invalid WKB is rejected") {
+    std::string blob;
+    SECTION("truncated point") {
+        std::string wkb = wkb_header(1);
+        put(wkb, 1.5);
+        REQUIRE_THROWS_AS(SpatialiteWriter::wkb_to_blob(wkb, 4326, blob), const std::runtime_error&);
+    }
+    SECTION("big-endian WKB") {
+        std::string wkb = wkb_header(1);
+        wkb[0] = 0x00;
+        REQUIRE_THROWS_AS(SpatialiteWriter::wkb_to_blob(wkb, 4326, blob), const std::runtime_error&);
+    }
+    SECTION("unsupported geometry type") {
+        std::string wkb = wkb_header(3);
+        put(wkb, static_cast<uint32_t>(0));
+        REQUIRE_THROWS_AS(SpatialiteWriter::wkb_to_blob(wkb, 4326, blob), const std::runtime_error&);
+    }
+}
+
+TEST_CASE("SpatiaLite database is written") {
+    srand(time(NULL));
+    const std::string filename = ".tmp-" + std::to_string(rand()) + "-spatialite-writer.sqlite";
+    std::remove(filename.c_str());
+    {
+        SpatialiteWriter writer {filename, 4326, 10};
+        const size_t points = writer.create_table("Points", wkbPoint);
+        writer.add_column(points, "name", OFTString, 10);
+        const size_t lines = writer.create_table("lines", wkbLineString);
+        writer.create_table("empty", wkbMultiLineString);
+        const size_t routes = writer.create_table("routes", wkbMultiLineString);
+
+        std::string wkb = wkb_header(1);
+        put(wkb, 8.5);
+        put(wkb, 49.0);
+        FeatureRecord point {points, std::move(wkb)};
+        point.add_string(0, "stop");
+        writer.insert(points, point);
+        writer.insert(lines, FeatureRecord{lines, wkb_linestring({{1.0, 2.0}, {3.0, -4.0}})});
+        writer.insert(routes, FeatureRecord{routes, std::string{}});
+        writer.close();
+    }
+
+    sqlite3* database = nullptr;
+    REQUIRE(sqlite3_open_v2(filename.c_str(), &database, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+
+    SECTION("geometry_columns rows") {
+        REQUIRE(sqlite3_prepare_v2(database, "SELECT f_table_name, f_geometry_column, geometry_type, coord_dimension, "
+                "srid, spatial_index_enabled FROM geometry_columns ORDER BY f_table_name", -1, &stmt, nullptr) == SQLITE_OK);
+        const std::vector<std::pair<std::string, int>> expected {{"empty", 5}, {"lines", 2}, {"points", 1}, {"routes", 5}};
+        for (const auto& row : expected) {
+            REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+            CHECK(std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))} == row.first);
+            CHECK(std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))} == "geometry");
+            CHECK(sqlite3_column_int(stmt, 2) == row.second);
+            CHECK(sqlite3_column_int(stmt, 3) == 2);
+            CHECK(sqlite3_column_int(stmt, 4) == 4326);
+            CHECK(sqlite3_column_int(stmt, 5) == 0);
+        }
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    }
+
+    SECTION("blob header of a point") {
+        REQUIRE(sqlite3_prepare_v2(database, "SELECT GEOMETRY, name FROM Points", -1, &stmt, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+        const std::string blob {static_cast<const char*>(sqlite3_column_blob(stmt, 0)),
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 0))};
+        CHECK(blob.substr(0, 39) == blob_header(4326, 8.5, 49.0, 8.5, 49.0));
+        CHECK(std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))} == "stop");
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    }
+
+    SECTION("blob header of a linestring") {
+        REQUIRE(sqlite3_prepare_v2(database, "SELECT GEOMETRY FROM lines", -1, &stmt, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+        const std::string blob {static_cast<const char*>(sqlite3_column_blob(stmt, 0)),
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 0))};
+        CHECK(blob.substr(0, 39) == blob_header(4326, 1.0, -4.0, 3.0, 2.0));
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    }
+
+    SECTION("empty geometry is written as NULL") {
+        REQUIRE(sqlite3_prepare_v2(database, "SELECT GEOMETRY FROM routes", -1, &stmt, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+        CHECK(sqlite3_column_type(stmt, 0) == SQLITE_NULL);
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    }
+
+    SECTION("spatial_ref_sys row") {
+        REQUIRE(sqlite3_prepare_v2(database, "SELECT srid, auth_name, auth_srid FROM spatial_ref_sys", -1, &stmt, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+        CHECK(sqlite3_column_int(stmt, 0) == 4326);
+        CHECK(std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))} == "epsg");
+        CHECK(sqlite3_column_int(stmt, 2) == 4326);
+        CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(database);
+    std::remove(filename.c_str());
+}
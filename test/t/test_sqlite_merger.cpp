@@ -0,0 +1,151 @@
+/*
+ * test_sqlite_merger.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <sqlite_merger.hpp>
+#include <sqlite_utils.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+    /**
+     * Database file which is removed when the object goes out of scope.
+     */
+    class TemporaryDatabase {
+
+        std::string m_filename;
+
+        sqlite3* m_database = nullptr;
+
+    public:
+        explicit TemporaryDatabase(const std::string& suffix) :
+            m_filename(".tmp-" + std::to_string(rand()) + "-" + suffix + ".sqlite") {
+            std::remove(m_filename.c_str());
+            sqlite_check(m_database, m_filename, sqlite3_open(m_filename.c_str(), &m_database), "open database");
+        }
+
+        ~TemporaryDatabase() {
+            close();
+            std::remove(m_filename.c_str());
+        }
+
+        const std::string& filename() const noexcept {
+            return m_filename;
+        }
+
+        void exec(const std::string& sql) {
+            sqlite_check(m_database, m_filename, sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, nullptr), sql.c_str());
+        }
+
+        void close() {
+            if (m_database) {
+                sqlite3_close(m_database);
+                m_database = nullptr;
+            }
+        }
+    };
+
+    /**
+     * Query a single integer value.
+     */
+    int64_t query_int(const std::string& filename, const std::string& sql) {
+        sqlite3* database = nullptr;
+        sqlite_check(database, filename, sqlite3_open_v2(filename.c_str(), &database, SQLITE_OPEN_READONLY, nullptr), "open database");
+        sqlite3_stmt* stmt = nullptr;
+        sqlite_check(database, filename, sqlite3_prepare_v2(database, sql.c_str(), -1, &stmt, nullptr), sql.c_str());
+        REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+        const int64_t value = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+        sqlite3_close(database);
+        return value;
+    }
+
+    /**
+     * Create the metadata tables and a layer with an index and a trigger like GDAL does.
+     */
+    void create_layer_file(TemporaryDatabase& db, const std::string& layer, const int rows) {
+        db.exec("CREATE TABLE spatial_ref_sys (srid INTEGER NOT NULL PRIMARY KEY, auth_name TEXT, auth_srid INTEGER, srtext TEXT)");
+        db.exec("CREATE TABLE geometry_columns (f_table_name TEXT NOT NULL, f_geometry_column TEXT NOT NULL, "
+                "geometry_type INTEGER NOT NULL, coord_dimension INTEGER NOT NULL, srid INTEGER, "
+                "spatial_index_enabled INTEGER NOT NULL, PRIMARY KEY (f_table_name, f_geometry_column))");
+        db.exec("INSERT INTO spatial_ref_sys VALUES (4326, 'EPSG', 4326, 'WGS 84')");
+        db.exec("INSERT INTO geometry_columns VALUES ('" + layer + "', 'geometry', 2, 2, 4326, 0)");
+        db.exec("CREATE TABLE " + layer + " (ogc_fid INTEGER PRIMARY KEY, name TEXT, geometry BLOB)");
+        db.exec("CREATE TABLE " + layer + "_log (ogc_fid INTEGER)");
+        for (int i = 1; i <= rows; ++i) {
+            db.exec("INSERT INTO " + layer + " (name) VALUES ('" + layer + std::to_string(i) + "')");
+        }
+        db.exec("CREATE INDEX idx_" + layer + "_name ON " + layer + " (name)");
+        db.exec("CREATE TRIGGER trg_" + layer + " AFTER INSERT ON " + layer
+                + " BEGIN INSERT INTO " + layer + "_log VALUES (NEW.ogc_fid); END");
+        db.close();
+    }
+
+} // namespace
+
+TEST_CASE("merge two SQLite files") {
+    srand(time(NULL));
+    TemporaryDatabase destination {"merger-destination"};
+    TemporaryDatabase source {"merger-source"};
+    create_layer_file(destination, "stops", 3);
+    create_layer_file(source, "routes", 2);
+
+    SQLiteMerger merger {destination.filename()};
+    merger.merge(source.filename());
+    merger.close();
+
+    const std::string& merged = destination.filename();
+    SECTION("rows of both layers") {
+        CHECK(query_int(merged, "SELECT count(*) FROM stops") == 3);
+        CHECK(query_int(merged, "SELECT count(*) FROM routes") == 2);
+        CHECK(query_int(merged, "SELECT count(*) FROM routes_log") == 0);
+    }
+
+    SECTION("shared metadata rows are merged") {
+        CHECK(query_int(merged, "SELECT count(*) FROM spatial_ref_sys") == 1);
+        CHECK(query_int(merged, "SELECT count(*) FROM geometry_columns") == 2);
+        CHECK(query_int(merged, "SELECT srid FROM geometry_columns WHERE f_table_name = 'routes'") == 4326);
+    }
+
+    SECTION("indexes and triggers of the source file are recreated") {
+        CHECK(query_int(merged, "SELECT count(*) FROM sqlite_master WHERE type = 'index' AND name = 'idx_routes_name'") == 1);
+        CHECK(query_int(merged, "SELECT count(*) FROM sqlite_master WHERE type = 'trigger' AND name = 'trg_routes'") == 1);
+        CHECK(query_int(merged, "SELECT count(*) FROM sqlite_master WHERE type = 'index' AND name = 'idx_stops_name'") == 1);
+    }
+}
+
+TEST_CASE("a failed merge is rolled back") {
+    srand(time(NULL));
+    TemporaryDatabase destination {"merger-destination"};
+    TemporaryDatabase broken {"merger-broken"};
+    TemporaryDatabase source {"merger-source"};
+    create_layer_file(destination, "stops", 3);
+    // The metadata rows cannot be copied because geometry_columns has a different number of columns.
+    broken.exec("CREATE TABLE geometry_columns (f_table_name TEXT NOT NULL, f_geometry_column TEXT NOT NULL)");
+    broken.exec("INSERT INTO geometry_columns VALUES ('platforms', 'geometry')");
+    broken.exec("CREATE TABLE platforms (ogc_fid INTEGER PRIMARY KEY, name TEXT)");
+    broken.exec("INSERT INTO platforms (name) VALUES ('platform')");
+    broken.close();
+    create_layer_file(source, "routes", 2);
+
+    SQLiteMerger merger {destination.filename()};
+    REQUIRE_THROWS_AS(merger.merge(broken.filename()), const std::runtime_error&);
+    // The source database has been detached, otherwise attaching the next one fails.
+    merger.merge(source.filename());
+    merger.close();
+
+    const std::string& merged = destination.filename();
+    CHECK(query_int(merged, "SELECT count(*) FROM sqlite_master WHERE name = 'platforms'") == 0);
+    CHECK(query_int(merged, "SELECT count(*) FROM routes") == 2);
+    CHECK(query_int(merged, "SELECT count(*) FROM geometry_columns") == 2);
+}
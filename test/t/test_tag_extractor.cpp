@@ -0,0 +1,113 @@
+/*
+ * test_tag_extractor.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tag_extractor.hpp>
+
+using taglist = std::vector<std::pair<std::string, std::string>>;
+
+namespace {
+
+    const size_t buffer_size = 10000;
+
+    /**
+     * Build a node whose tags are in the given order. Unlike tagmap, the list may contain
+     * a key more than once.
+     */
+    osmium::Node& create_node(osmium::memory::Buffer& buffer, const taglist& tags) {
+        osmium::builder::NodeBuilder node_builder(buffer);
+        osmium::Node& node = static_cast<osmium::Node&>(node_builder.object());
+        node.set_id(1);
+        test_utils::set_dummy_osm_object_attributes(node);
+        node_builder.set_user("");
+        {
+            osmium::builder::TagListBuilder tl_builder(buffer, &node_builder);
+            for (const auto& tag : tags) {
+                tl_builder.add_tag(tag.first, tag.second);
+            }
+        }
+        return node_builder.object();
+    }
+
+} // namespace
+
+TEST_CASE("tag extractor returns the values of all keys") {
+    osmium::memory::Buffer buffer(buffer_size);
+    const osmium::Node& node = test_utils::create_new_node(buffer, 1, osmium::Location{9.0, 50.0},
+            {{"name", "Hauptbahnhof"}, {"public_transport", "station"}, {"railway", "station"}, {"uic_ref", "8000105"}});
+    const TagExtractor<3> extractor {"railway", "public_transport", "name"};
+    const auto values = extractor.extract(node.tags());
+    REQUIRE(values[0] == std::string{"station"});
+    REQUIRE(values[1] == std::string{"station"});
+    REQUIRE(values[2] == std::string{"Hauptbahnhof"});
+}
+
+TEST_CASE("tag extractor returns the default value for missing keys") {
+    osmium::memory::Buffer buffer(buffer_size);
+    const osmium::Node& node = test_utils::create_new_node(buffer, 1, osmium::Location{9.0, 50.0},
+            {{"highway", "bus_stop"}, {"name", "Marktplatz"}});
+    const TagExtractor<3> extractor {"railway", "name", "ref"};
+    SECTION("null pointer by default") {
+        const auto values = extractor.extract(node.tags());
+        REQUIRE_FALSE(values[0]);
+        REQUIRE(values[1] == std::string{"Marktplatz"});
+        REQUIRE_FALSE(values[2]);
+    }
+    SECTION("given default value") {
+        const auto values = extractor.extract(node.tags(), "");
+        REQUIRE(values[0] == std::string{""});
+        REQUIRE(values[1] == std::string{"Marktplatz"});
+        REQUIRE(values[2] == std::string{""});
+    }
+    SECTION("empty tag list") {
+        const osmium::Node& untagged = test_utils::create_new_node(buffer, 2, osmium::Location{9.0, 50.0}, {});
+        const auto values = extractor.extract(untagged.tags(), "none");
+        REQUIRE(values[0] == std::string{"none"});
+        REQUIRE(values[1] == std::string{"none"});
+        REQUIRE(values[2] == std::string{"none"});
+    }
+}
+
+TEST_CASE("tag extractor does not match keys by prefix") {
+    osmium::memory::Buffer buffer(buffer_size);
+    const osmium::Node& node = create_node(buffer, {{"railway:switch", "default"}, {"ref:IFOPT", "de:123"},
+            {"refs", "1"}, {"ref", "7"}});
+    const TagExtractor<2> extractor {"railway", "ref"};
+    const auto values = extractor.extract(node.tags());
+    REQUIRE_FALSE(values[0]);
+    REQUIRE(values[1] == std::string{"7"});
+}
+
+TEST_CASE("tag extractor returns the first value of duplicate keys") {
+    osmium::memory::Buffer buffer(buffer_size);
+    const osmium::Node& node = create_node(buffer, {{"name", "first"}, {"railway", "halt"}, {"name", "second"},
+            {"network", "VRN"}});
+    const TagExtractor<3> extractor {"name", "network", "operator"};
+    const auto values = extractor.extract(node.tags());
+    REQUIRE(values[0] == std::string{"first"});
+    REQUIRE(values[1] == std::string{"VRN"});
+    REQUIRE_FALSE(values[2]);
+}
+
+TEST_CASE("tag extractor stops reading once all keys have been found") {
+    osmium::memory::Buffer buffer(buffer_size);
+    // All keys are found in the first two tags, the tags after them must not change the values.
+    const osmium::Node& node = create_node(buffer, {{"public_transport", "platform"}, {"railway", "platform"},
+            {"railway", "halt"}, {"public_transport", "stop_position"}, {"name", "Gleis 1"}});
+    const TagExtractor<2> extractor {"railway", "public_transport"};
+    const auto values = extractor.extract(node.tags());
+    REQUIRE(values[0] == std::string{"platform"});
+    REQUIRE(values[1] == std::string{"platform"});
+    // the values point into the tag list
+    REQUIRE(values[1] == node.tags().begin()->value());
+}
@@ -0,0 +1,37 @@
+/*
+ * test_tag_values.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <tag_values.hpp>
+
+#include <string>
+
+TEST_CASE("known tag values are classified") {
+    REQUIRE(tag_values::railway("rail") == tag_values::Railway::RAIL);
+    REQUIRE(tag_values::railway("isolated_track_section") == tag_values::Railway::ISOLATED_TRACK_SECTION);
+    REQUIRE(tag_values::railway("platform") == tag_values::Railway::PLATFORM);
+    REQUIRE(tag_values::highway("motorway_link") == tag_values::Highway::MOTORWAY_LINK);
+    REQUIRE(tag_values::highway("busway") == tag_values::Highway::BUSWAY);
+    REQUIRE(tag_values::route("share_taxi") == tag_values::Route::SHARE_TAXI);
+    REQUIRE(tag_values::route("light_rail") == tag_values::Route::LIGHT_RAIL);
+}
+
+TEST_CASE("unknown tag values are not classified") {
+    REQUIRE(tag_values::railway("") == tag_values::Railway::UNKNOWN);
+    REQUIRE(tag_values::railway("rai") == tag_values::Railway::UNKNOWN);
+    REQUIRE(tag_values::railway("rails") == tag_values::Railway::UNKNOWN);
+    REQUIRE(tag_values::railway("Rail") == tag_values::Railway::UNKNOWN);
+    REQUIRE(tag_values::highway("footway") == tag_values::Highway::UNKNOWN);
+    REQUIRE(tag_values::route("bicycle") == tag_values::Route::UNKNOWN);
+}
+
+TEST_CASE("hash is the same at compile time and at run time") {
+    constexpr uint32_t compile_time = tag_values::hash("tram_stop");
+    std::string value {"tram_stop"};
+    REQUIRE(tag_values::hash(value.c_str()) == compile_time);
+}
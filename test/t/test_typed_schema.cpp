@@ -0,0 +1,109 @@
+/*
+ * test_typed_schema.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <feature_spool.hpp>
+#include <spatialite_writer.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::string wkb_point(const double x, const double y) {
+        std::string wkb;
+        wkb += static_cast<char>(0x01);
+        const uint32_t type = 1;
+        wkb.append(reinterpret_cast<const char*>(&type), sizeof(type));
+        wkb.append(reinterpret_cast<const char*>(&x), sizeof(x));
+        wkb.append(reinterpret_cast<const char*>(&y), sizeof(y));
+        return wkb;
+    }
+
+    std::string column_text(sqlite3_stmt* stmt, const int column) {
+        return std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, column))};
+    }
+
+} // namespace
+
+TEST_CASE("typed IDs and timestamps are written as integer and date/time columns") {
+    srand(time(NULL));
+    const std::string filename = ".tmp-" + std::to_string(rand()) + "-typed-schema.sqlite";
+    std::remove(filename.c_str());
+    {
+        SpatialiteWriter writer {filename, 4326, 10};
+        const size_t points = writer.create_table("points", wkbPoint);
+        writer.add_column(points, "node_id", OFTInteger64, 0);
+        writer.add_column(points, "lastchange", OFTDateTime, 0);
+        writer.add_column(points, "name", OFTString, 10);
+        FeatureRecord point {points, wkb_point(8.5, 49.0)};
+        point.add_integer(0, 12345678901);
+        // 2016-01-05T01:22:45Z
+        point.add_timestamp(1, 1451956965);
+        point.add_string(2, "stop");
+        writer.insert(points, point);
+        writer.close();
+    }
+
+    sqlite3* database = nullptr;
+    REQUIRE(sqlite3_open_v2(filename.c_str(), &database, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    REQUIRE(sqlite3_prepare_v2(database, "SELECT node_id, typeof(node_id), lastchange, name FROM points", -1, &stmt,
+            nullptr) == SQLITE_OK);
+    REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+    CHECK(sqlite3_column_int64(stmt, 0) == 12345678901);
+    CHECK(column_text(stmt, 1) == "integer");
+    CHECK(column_text(stmt, 2) == "2016-01-05T01:22:45Z");
+    CHECK(column_text(stmt, 3) == "stop");
+    CHECK(sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+
+    REQUIRE(sqlite3_prepare_v2(database, "SELECT type FROM pragma_table_info('points') WHERE name IN "
+            "('node_id', 'lastchange') ORDER BY cid", -1, &stmt, nullptr) == SQLITE_OK);
+    REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+    CHECK(column_text(stmt, 0) == "BIGINT");
+    REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+    CHECK(column_text(stmt, 0) == "DATETIME");
+    sqlite3_finalize(stmt);
+    sqlite3_close(database);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("typed fields survive the Hilbert sort spool") {
+    srand(time(NULL));
+    const std::string filename = ".tmp-" + std::to_string(rand()) + "-typed-schema.spool";
+    FeatureSpool spool {filename, HilbertCurve{0.0, 0.0, 10.0, 10.0}};
+    FeatureRecord record {3, wkb_point(1.0, 2.0)};
+    record.add_string(0, "abc");
+    record.add_integer(1, -42);
+    record.add_timestamp(2, 1451956965);
+    spool.add(record);
+
+    std::vector<std::unique_ptr<FeatureRecord>> replayed;
+    spool.replay(3, [&replayed](std::unique_ptr<FeatureRecord>&& feature) {
+        replayed.push_back(std::move(feature));
+    });
+    REQUIRE(replayed.size() == 1);
+    const FeatureRecord& result = *replayed.front();
+    CHECK(result.layer_id == 3);
+    CHECK(result.wkb == record.wkb);
+    REQUIRE(result.fields.size() == 3);
+    CHECK(result.fields[0].type == FeatureRecord::FieldType::STRING);
+    CHECK(std::string{result.string_value(result.fields[0])} == "abc");
+    CHECK(result.fields[1].index == 1);
+    CHECK(result.fields[1].type == FeatureRecord::FieldType::INTEGER);
+    CHECK(result.fields[1].value == -42);
+    CHECK(result.fields[2].index == 2);
+    CHECK(result.fields[2].type == FeatureRecord::FieldType::TIMESTAMP);
+    CHECK(result.fields[2].value == 1451956965);
+}
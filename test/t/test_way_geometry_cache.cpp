@@ -0,0 +1,82 @@
+/*
+ * test_way_geometry_cache.cpp
+ *
+ *  Created on:  2026-10-16
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#include "catch.hpp"
+
+#include <way_geometry_cache.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("way geometry cache returns added geometries") {
+    WayGeometryCache cache {4};
+    REQUIRE_FALSE(cache.get(1));
+    auto added = cache.add(1, std::string{"abc"});
+    REQUIRE(*added == "abc");
+    auto cached = cache.get(1);
+    REQUIRE(cached);
+    REQUIRE(cached == added);
+    REQUIRE_FALSE(cache.get(2));
+}
+
+TEST_CASE("way geometry cache evicts the least recently used geometry") {
+    WayGeometryCache cache {3};
+    cache.add(1, std::string{"one"});
+    cache.add(2, std::string{"two"});
+    cache.add(3, std::string{"three"});
+    // way 1 becomes the most recently used one, way 2 the least recently used one
+    REQUIRE(cache.get(1));
+    auto evicted = cache.get(2);
+    REQUIRE(cache.get(3));
+    REQUIRE(cache.get(1));
+    cache.add(4, std::string{"four"});
+    REQUIRE_FALSE(cache.get(2));
+    REQUIRE(*cache.get(1) == "one");
+    REQUIRE(*cache.get(3) == "three");
+    REQUIRE(*cache.get(4) == "four");
+    // evicted geometries stay valid for their holders
+    REQUIRE(*evicted == "two");
+}
+
+TEST_CASE("way geometry cache with capacity 0 is bypassed") {
+    WayGeometryCache cache {0};
+    auto added = cache.add(1, std::string{"abc"});
+    REQUIRE(added);
+    REQUIRE(*added == "abc");
+    REQUIRE_FALSE(cache.get(1));
+    auto second = cache.add(1, std::string{"def"});
+    REQUIRE(*second == "def");
+}
+
+TEST_CASE("way geometry cache keeps the first geometry added for a way") {
+    WayGeometryCache cache {2};
+    auto first = cache.add(1, std::string{"first"});
+    auto second = cache.add(1, std::string{"second"});
+    REQUIRE(second == first);
+    REQUIRE(*cache.get(1) == "first");
+}
+
+TEST_CASE("way geometry cache keeps the first geometry if threads add a way concurrently") {
+    WayGeometryCache cache {16};
+    const size_t thread_count = 8;
+    std::vector<WayGeometryCache::geometry_type> results(thread_count);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&cache, &results, i]() {
+            results[i] = cache.add(42, std::to_string(i));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto cached = cache.get(42);
+    REQUIRE(cached);
+    for (const auto& result : results) {
+        REQUIRE(result == cached);
+    }
+}